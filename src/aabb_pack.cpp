@@ -0,0 +1,96 @@
+#include "aabb_pack.h"
+#include "simd_packs.inl"
+
+using namespace gb::physics;
+
+// overlapMask stays on the baseline flags of this unit whatever the caller is built with
+#if defined(GB_PHYSICS_SSE)
+typedef _pack4 _mask_pack;
+#else
+typedef _pack1 _mask_pack;
+#endif
+
+template<std::size_t N>
+unsigned gb::physics::overlapMask(const aabb_pack<N>& p, const aabb<float>& q)
+{
+    typedef _mask_pack pack;
+    typename pack::type ql[3], qu[3];
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	ql[c] = pack::set1(q.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][c]);
+	qu[c] = pack::set1(q.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][c]);
+    }
+    unsigned ret = 0;
+    for(std::size_t l = 0; l < N; l += pack::width)
+    {
+	unsigned m = ~0u;
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    m &= pack::lt_mask(pack::load(p.lower[c] + l), qu[c]);
+	    m &= pack::lt_mask(ql[c], pack::load(p.upper[c] + l));
+	}
+	ret |= m << l;
+    }
+    return ret;
+}
+
+template<std::size_t N>
+unsigned gb::physics::overlapMask(const aabb_pack<N>& p, const spherebb<float>& q)
+{
+    typedef _mask_pack pack;
+    typename pack::type centre[3];
+    for(std::uint8_t c = 0; c < 3; c++)
+	centre[c] = pack::set1(q.centre[c]);
+    const typename pack::type sqRadius = pack::set1(q.radius * q.radius);
+    const typename pack::type zero = pack::set1(0.0f);
+    unsigned ret = 0;
+    for(std::size_t l = 0; l < N; l += pack::width)
+    {
+	typename pack::type sqDist = zero;
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    // distance outside the slab, 0 inside
+	    const typename pack::type d = pack::max(pack::max(pack::sub(pack::load(p.lower[c] + l), centre[c]),
+							      pack::sub(centre[c], pack::load(p.upper[c] + l))), zero);
+	    sqDist = pack::add(sqDist, pack::mul(d, d));
+	}
+	ret |= pack::le_mask(sqDist, sqRadius) << l;
+    }
+    return ret;
+}
+
+template unsigned gb::physics::overlapMask<4>(const aabb4& p, const aabb<float>& q);
+template unsigned gb::physics::overlapMask<8>(const aabb8& p, const aabb<float>& q);
+template unsigned gb::physics::overlapMask<16>(const aabb16& p, const aabb<float>& q);
+template unsigned gb::physics::overlapMask<4>(const aabb4& p, const spherebb<float>& q);
+template unsigned gb::physics::overlapMask<8>(const aabb8& p, const spherebb<float>& q);
+template unsigned gb::physics::overlapMask<16>(const aabb16& p, const spherebb<float>& q);
+
+template<typename Kernel>
+static void _overlapMasks(const aabb16* packs, const std::size_t count, const float* query, std::uint16_t* masks, const bool bParallel, Kernel kernel)
+{
+    assert((packs != nullptr && masks != nullptr) || count == 0);
+    const float* data = packs == nullptr ? nullptr : packs->lower[0];
+    auto body = [=](const std::size_t begin, const std::size_t end)
+	{
+	    kernel(data + begin * 6 * aabb_pack_lanes, end - begin, query, masks + begin);
+	};
+    if(bParallel)
+	parallelFor(count, aabb_pack_parallel_chunk, body);
+    else
+	body(0, count);
+}
+
+void gb::physics::overlapMasks(const aabb16* packs, const std::size_t count, const aabb<float>& q, std::uint16_t* masks, const bool bParallel)
+{
+    const vec3f& l = q.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX];
+    const vec3f& u = q.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX];
+    const float query[6] = {l.x, l.y, l.z, u.x, u.y, u.z};
+    _overlapMasks(packs, count, query, masks, bParallel, streamKernels().aabb_overlap);
+}
+
+void gb::physics::overlapMasks(const aabb16* packs, const std::size_t count, const spherebb<float>& q, std::uint16_t* masks, const bool bParallel)
+{
+    const float query[4] = {q.centre.x, q.centre.y, q.centre.z, q.radius};
+    _overlapMasks(packs, count, query, masks, bParallel, streamKernels().sphere_overlap);
+}
@@ -0,0 +1,108 @@
+// packed aabbs and one-vs-many overlap tests
+
+#pragma once
+
+#include "boundingbox.h"
+#include "simd.h"
+#include "parallel.h"
+#include "stream_kernels.h"
+#include <type_traits>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, N float aabbs in SoA layout, lower x y z then upper x y z, one row of N floats each,
+ so one query box or sphere is tested against all N with a few register compares, the result is a bitmask.
+ unused lanes are empty(lower +inf, upper -inf) and never overlap anything.
+
+  lower: x0 x1 .. xN-1 | y0 .. | z0 ..
+  upper: x0 x1 .. xN-1 | y0 .. | z0 ..
+ */
+template<std::size_t N>
+struct alignas(N * sizeof(float) < GB_PHYSICS_SIMD_ALIGNMENT ? N * sizeof(float) : GB_PHYSICS_SIMD_ALIGNMENT) aabb_pack
+{
+    static_assert(N == 4 || N == 8 || N == 16, "aabb_pack, N must be 4, 8 or 16");
+    static constexpr std::size_t lanes = N;
+
+    static aabb_pack make_empty()
+	{
+	    aabb_pack ret;
+	    ret.clear();
+	    return ret;
+	}
+
+    void clear()
+	{
+	    for(std::size_t l = 0; l < N; l++)
+		set_empty(l);
+	}
+    void set_empty(const std::size_t lane)
+	{
+	    assert(lane < N);
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		lower[c][lane] = std::numeric_limits<float>::infinity();
+		upper[c][lane] = -std::numeric_limits<float>::infinity();
+	    }
+	}
+    void set(const std::size_t lane, const aabb<float>& bb)
+	{
+	    assert(lane < N);
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		lower[c][lane] = bb.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][c];
+		upper[c][lane] = bb.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][c];
+	    }
+	}
+    aabb<float> get(const std::size_t lane) const
+	{
+	    assert(lane < N);
+	    return aabb<float>(vec3f(lower[0][lane], lower[1][lane], lower[2][lane]),
+			       vec3f(upper[0][lane], upper[1][lane], upper[2][lane]));
+	}
+
+    float lower[3][N];
+    float upper[3][N];
+};
+
+typedef aabb_pack<4> aabb4;
+typedef aabb_pack<8> aabb8;
+typedef aabb_pack<16> aabb16;
+
+static_assert(sizeof(aabb16) == 6 * aabb_pack_lanes * sizeof(float), "aabb16 must match the stream kernels layout");
+
+/*
+ *@brief, bit l set where box l of p overlaps q, strict like aabb::intersect(touching boxes don't overlap).
+ compiled once in aabb_pack.cpp for the baseline instruction set(sse, 4 lanes per compare) and instantiated for 4, 8 and 16,
+ meant for small fixed fan-outs(octree children, bvh nodes). the wide paths go through overlapMasks.
+ */
+template<std::size_t N>
+unsigned overlapMask(const aabb_pack<N>& p, const aabb<float>& q);
+
+/*
+ *@brief, bit l set where box l of p and the sphere q overlap(touching included),
+ exact: the squared distance from the centre to the box against radius^2,
+ tighter than aabb::intersect(spherebb) which grows the box by the radius.
+ */
+template<std::size_t N>
+unsigned overlapMask(const aabb_pack<N>& p, const spherebb<float>& q);
+
+extern template unsigned overlapMask<4>(const aabb4& p, const aabb<float>& q);
+extern template unsigned overlapMask<8>(const aabb8& p, const aabb<float>& q);
+extern template unsigned overlapMask<16>(const aabb16& p, const aabb<float>& q);
+extern template unsigned overlapMask<4>(const aabb4& p, const spherebb<float>& q);
+extern template unsigned overlapMask<8>(const aabb8& p, const spherebb<float>& q);
+extern template unsigned overlapMask<16>(const aabb16& p, const spherebb<float>& q);
+
+// packs above this count are split across threads when bParallel
+static constexpr std::size_t aabb_pack_parallel_chunk = 4096;
+
+/*
+ *@brief, one query against count aabb16, masks[i] = overlapMask(packs[i], q),
+ through the dispatched stream kernels(see cpu.h), so avx2 tests 8 and avx-512 16 boxes per compare.
+ meant for broadphase sweeps over many boxes.
+ */
+void overlapMasks(const aabb16* packs, const std::size_t count, const aabb<float>& q, std::uint16_t* masks, const bool bParallel = false);
+void overlapMasks(const aabb16* packs, const std::size_t count, const spherebb<float>& q, std::uint16_t* masks, const bool bParallel = false);
+
+GB_PHYSICS_NS_END
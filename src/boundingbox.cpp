@@ -1 +1,221 @@
-#include "boundingbox.h"
+#include "boundingbox.h"
+#include "stream_kernels.h"
+
+using namespace gb::physics;
+
+aabb<float> gb::physics::aabbFromPoints(const vec3f* data, const std::size_t count, const bool bParallel)
+{
+    assert(data != nullptr && count != 0);
+    const stream_kernels& kernels = streamKernels();
+    auto map = [&](const std::size_t begin, const std::size_t end)
+	{
+	    float bounds[6];
+	    kernels.points_bounds(data[begin].data(), end - begin, bounds);
+	    return aabb<float>(vec3f(bounds[0], bounds[1], bounds[2]), vec3f(bounds[3], bounds[4], bounds[5]));
+	};
+    if(!bParallel)
+	return map(0, count);
+    const aabb<float> init(data[0], data[0]);
+    return parallelReduce(count, boundingbox_parallel_chunk, init, map,
+			  [](aabb<float>& into, const aabb<float>& partial) { into.expand(partial); });
+}
+
+/*
+  sphereFromPoints, 4 points per step:
+  the 7 projections keep lane minima/maxima over blocks of sphere_block points, a block that improves a lane is noted,
+  the point itself is found once at the end by rescanning the best block.
+  the growing pass tests 4 points against the current sphere and only grows it(point by point) on a hit,
+  which is rare after the first few points.
+*/
+
+static constexpr std::size_t _sphere_block = 64;
+
+static detail::sphere_extremes<float> _sphereExtremes(const vec3f* data, std::size_t i, const std::size_t end)
+{
+    typedef detail::sphere_extremes<float> extremes;
+    extremes ret;
+#if defined(GB_PHYSICS_SSE)
+    if(i + 4 <= end)
+    {
+	const std::size_t vecEnd = i + (end - i) / 4 * 4;
+	__m128 best[extremes::directions][2];
+	std::size_t bestBlock[extremes::directions][2][4];
+	for(std::uint8_t d = 0; d < extremes::directions; d++)
+	{
+	    best[d][0] = _mm_set1_ps(std::numeric_limits<float>::max());
+	    best[d][1] = _mm_set1_ps(std::numeric_limits<float>::lowest());
+	}
+	for(std::size_t block = i; block < vecEnd; block += _sphere_block)
+	{
+	    const std::size_t blockEnd = block + _sphere_block < vecEnd ? block + _sphere_block : vecEnd;
+	    __m128 lower[extremes::directions], upper[extremes::directions];
+	    for(std::uint8_t d = 0; d < extremes::directions; d++)
+	    {
+		lower[d] = best[d][0];
+		upper[d] = best[d][1];
+	    }
+	    for(std::size_t j = block; j < blockEnd; j += 4)
+	    {
+		__m128 x, y, z;
+		loadSoA4(data[j].data(), x, y, z);
+		const __m128 xy = _mm_add_ps(x, y), x_y = _mm_sub_ps(x, y);
+		const __m128 p[extremes::directions] = {x, y, z, _mm_add_ps(xy, z), _mm_sub_ps(xy, z), _mm_add_ps(x_y, z), _mm_sub_ps(x_y, z)};
+		for(std::uint8_t d = 0; d < extremes::directions; d++)
+		{
+		    lower[d] = _mm_min_ps(p[d], lower[d]);
+		    upper[d] = _mm_max_ps(p[d], upper[d]);
+		}
+	    }
+	    for(std::uint8_t d = 0; d < extremes::directions; d++)
+	    {
+		const int masks[2] = {_mm_movemask_ps(_mm_cmplt_ps(lower[d], best[d][0])), _mm_movemask_ps(_mm_cmpgt_ps(upper[d], best[d][1]))};
+		for(std::uint8_t e = 0; e < 2; e++)
+		{
+		    for(std::uint8_t l = 0; l < 4; l++)
+		    {
+			if(masks[e] & (1 << l))
+			    bestBlock[d][e][l] = block;
+		    }
+		}
+		best[d][0] = lower[d];
+		best[d][1] = upper[d];
+	    }
+	}
+
+	// the earliest block reaching the extreme, then its first point, as the scalar pass
+	for(std::uint8_t d = 0; d < extremes::directions; d++)
+	{
+	    for(std::uint8_t e = 0; e < 2; e++)
+	    {
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, best[d][e]);
+		std::uint8_t l = 0;
+		for(std::uint8_t k = 1; k < 4; k++)
+		{
+		    if((e == 0 ? lanes[k] < lanes[l] : lanes[k] > lanes[l]) || (lanes[k] == lanes[l] && bestBlock[d][e][k] < bestBlock[d][e][l]))
+			l = k;
+		}
+		std::size_t j = bestBlock[d][e][l];
+		while(j + 1 < vecEnd && extremes::project(d, data[j].x, data[j].y, data[j].z) != lanes[l])
+		    j++;
+		ret.proj[d][e] = lanes[l];
+		ret.points[d][e] = data[j];
+	    }
+	}
+	i = vecEnd;
+    }
+#endif
+    for(; i < end; i++)
+	ret.add(data[i]);
+    return ret;
+}
+
+static void _sphereGrow(spherebb<float>& s, const vec3f* data, std::size_t i, const std::size_t end)
+{
+#if defined(GB_PHYSICS_SSE)
+    for(; i + 4 <= end; i += 4)
+    {
+	__m128 x, y, z;
+	loadSoA4(data[i].data(), x, y, z);
+	const __m128 dx = _mm_sub_ps(x, _mm_set1_ps(s.centre.x));
+	const __m128 dy = _mm_sub_ps(y, _mm_set1_ps(s.centre.y));
+	const __m128 dz = _mm_sub_ps(z, _mm_set1_ps(s.centre.z));
+	const __m128 sqDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+	const int outside = _mm_movemask_ps(_mm_cmpgt_ps(sqDist, _mm_set1_ps(s.radius * s.radius)));
+	if(outside != 0)
+	{
+	    for(std::uint8_t l = 0; l < 4; l++)
+		s.expand(data[i + l]);
+	}
+    }
+#endif
+    for(; i < end; i++)
+	s.expand(data[i]);
+}
+
+spherebb<float> gb::physics::sphereFromPoints(const vec3f* data, const std::size_t count, const sphere_fit fit, const bool bParallel)
+{
+    assert(data != nullptr && count != 0);
+    return detail::sphereFit<float>(count, fit, bParallel,
+				    [data](const std::size_t begin, const std::size_t end) { return _sphereExtremes(data, begin, end); },
+				    [data](spherebb<float>& s, const std::size_t begin, const std::size_t end) { _sphereGrow(s, data, begin, end); });
+}
+
+/*
+  genOrientedBB, the extent pass projects 4 points per step onto the 3(pca) or 6(pca and dito) axes,
+  the extreme points come from the sphere pass above.
+*/
+
+template<std::uint8_t Frames>
+static detail::obb_extents<float, Frames> _obbExtents(const vec3f* axes, const vec3f* data, std::size_t i, const std::size_t end)
+{
+    detail::obb_extents<float, Frames> ret;
+#if defined(GB_PHYSICS_SSE)
+    if(i + 4 <= end)
+    {
+	__m128 a[Frames * 3][3], lower[Frames * 3], upper[Frames * 3];
+	for(std::uint8_t k = 0; k < Frames * 3; k++)
+	{
+	    for(std::uint8_t c = 0; c < 3; c++)
+		a[k][c] = _mm_set1_ps(axes[k][c]);
+	    lower[k] = _mm_set1_ps(std::numeric_limits<float>::max());
+	    upper[k] = _mm_set1_ps(std::numeric_limits<float>::lowest());
+	}
+	for(; i + 4 <= end; i += 4)
+	{
+	    __m128 x, y, z;
+	    loadSoA4(data[i].data(), x, y, z);
+	    for(std::uint8_t k = 0; k < Frames * 3; k++)
+	    {
+		const __m128 pr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[k][0], x), _mm_mul_ps(a[k][1], y)), _mm_mul_ps(a[k][2], z));
+		lower[k] = _mm_min_ps(lower[k], pr);
+		upper[k] = _mm_max_ps(upper[k], pr);
+	    }
+	}
+	for(std::uint8_t k = 0; k < Frames * 3; k++)
+	{
+	    alignas(16) float l[4], u[4];
+	    _mm_store_ps(l, lower[k]);
+	    _mm_store_ps(u, upper[k]);
+	    for(std::uint8_t j = 0; j < 4; j++)
+	    {
+		if(l[j] < ret.lower[k])
+		    ret.lower[k] = l[j];
+		if(u[j] > ret.upper[k])
+		    ret.upper[k] = u[j];
+	    }
+	}
+    }
+#endif
+    for(; i < end; i++)
+	ret.add(axes, data[i]);
+    return ret;
+}
+
+obb<float> gb::physics::genOrientedBB(const vec3f* data, const std::size_t count, const obb_fit fit, const bool bParallel)
+{
+    assert(data != nullptr && count != 0);
+    return detail::obbFit(data, count, fit, bParallel,
+			  [data](const std::size_t begin, const std::size_t end) { return _sphereExtremes(data, begin, end); },
+			  [data](const vec3f* axes, const std::size_t begin, const std::size_t end) { return _obbExtents<1>(axes, data, begin, end); },
+			  [data](const vec3f* axes, const std::size_t begin, const std::size_t end) { return _obbExtents<2>(axes, data, begin, end); });
+}
+
+void gb::physics::genOrientedBBs(const vec3f* data, const std::size_t* offsets, const std::size_t count, obb<float>* out,
+				 const obb_fit fit, const bool bParallel)
+{
+    assert((data != nullptr && offsets != nullptr && out != nullptr) || count == 0);
+    auto body = [=](const std::size_t begin, const std::size_t end)
+	{
+	    for(std::size_t i = begin; i < end; i++)
+	    {
+		assert(offsets[i] <= offsets[i + 1]);
+		const std::size_t n = offsets[i + 1] - offsets[i];
+		out[i] = n == 0 ? obb<float>() : genOrientedBB(data + offsets[i], n, fit);
+	    }
+	};
+    if(bParallel)
+	parallelFor(count, obb_batch_parallel_chunk, body);
+    else
+	body(0, count);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "matrix.h"
 #include "plane.h"
+#include "parallel.h"
 
 #include <limits>
 
@@ -46,6 +47,29 @@ struct spherebb
 		return false;
 	}
 
+    // grow to hold p(Ritter): the far side of the sphere stays, the centre moves towards p
+    void expand(const vec3<T>& p)
+	{
+	    const T sqDist = centre.sqDistance(p);
+	    if(sqDist <= radius * radius)
+		return;
+	    const T dist = std::sqrt(sqDist);
+	    const T newRadius = (radius + dist) * (T)0.5;
+	    centre = centre + (p - centre) * ((newRadius - radius) / dist);
+	    radius = newRadius;
+	}
+    // the smallest sphere holding both
+    spherebb merge(const spherebb& o) const
+	{
+	    const T dist = distance(o);
+	    if(dist + o.radius <= radius)
+		return *this;
+	    if(dist + radius <= o.radius)
+		return o;
+	    const T newRadius = (dist + radius + o.radius) * (T)0.5;
+	    return spherebb(centre + (o.centre - centre) * ((newRadius - radius) / dist), newRadius);
+	}
+
     spherebb operator *(const mat4<T>& mat) const
 	{
 	    T maxScale = mat[0][0];
@@ -73,6 +97,16 @@ struct spherebb
 	    
 	    radius *= maxScale;
 	}
+
+    spherebb operator *(const affine3<T>& aff) const
+	{
+	    return spherebb(aff.transform_point(centre), radius * aff.max_scale());
+	}
+    void operator *= (const affine3<T>& aff)
+	{
+	    centre = aff.transform_point(centre);
+	    radius *= aff.max_scale();
+	}
 		
     vec3<T> centre;
     T radius;
@@ -132,10 +166,10 @@ struct aabb
 		for(std::uint8_t i = 0; i < 3; i++)
 		{
 		    // lower point
-		    if(diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i] < o_diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i])
+		    if(diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i] > o_diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i])
 			return false;
 		    // upper point
-		    if(diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i] > o_diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i])
+		    if(diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i] < o_diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i])
 			return false;
 		}
 		return true;
@@ -154,53 +188,499 @@ struct aabb
 		return (o.centre >= interior_dia[GB_PHYSICS_DIAGONAL_LOWER_IDX])
 		    && (o.centre <= interior_dia[GB_PHYSICS_DIAGONAL_UPPER_IDX]);
 	}
+    // the box holding both
+    aabb merge(const aabb& o) const
+	{
+	    aabb ret(*this);
+	    ret.expand(o);
+	    return ret;
+	}
+    // grow to hold p
+    void expand(const vec3<T>& p)
+	{
+	    vec3<T> lower = diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX];
+	    vec3<T> upper = diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX];
+	    for(std::uint8_t i = 0; i < 3; i++)
+	    {
+		if(p[i] < lower[i])
+		    lower[i] = p[i];
+		if(p[i] > upper[i])
+		    upper[i] = p[i];
+	    }
+	    set(lower, upper);
+	}
+    void expand(const aabb& o)
+	{
+	    vec3<T> lower = diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX];
+	    vec3<T> upper = diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX];
+	    const vec3<T> (&o_diagonal)[2] = o.diagonal;
+	    for(std::uint8_t i = 0; i < 3; i++)
+	    {
+		if(o_diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i] < lower[i])
+		    lower[i] = o_diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX][i];
+		if(o_diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i] > upper[i])
+		    upper[i] = o_diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX][i];
+	    }
+	    set(lower, upper);
+	}
+    vec3<T> centroid() const
+	{
+	    return (diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX] + diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX]) * (T)0.5;
+	}
+    // the sah cost term
+    T surfaceArea() const
+	{
+	    return (T)2 * (lenSide.x * lenSide.y + lenSide.y * lenSide.z + lenSide.z * lenSide.x);
+	}
+    T volume() const
+	{
+	    return lenSide.x * lenSide.y * lenSide.z;
+	}
+    /*
+      the box bounding the transformed box(Arvo),
+      centre' = aff * centre, halfExtent' = |L| * halfExtent
+     */
+    aabb operator *(const affine3<T>& aff) const
+	{
+	    const vec3<T> centre = (diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX] + diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX]) * (T)0.5;
+	    const vec3<T> half = lenSide * (T)0.5;
+	    const vec3<T> newCentre = aff.transform_point(centre);
+	    const vec3<T> newHalf = aff[0].abs() * half[0] + aff[1].abs() * half[1] + aff[2].abs() * half[2];
+	    return aabb(newCentre - newHalf, newCentre + newHalf);
+	}
+    void operator *= (const affine3<T>& aff)
+	{
+	    *this = (*this) * aff;
+	}
     vec3<T> diagonal[2];
     vec3<T> lenSide;
 };
 
-template<typename T>
-spherebb<T> genSphereBB(const vec3<T>* data, const std::size_t count)
+/*
+ *@brief, the same box as aabb without the derived lenSide, 24 bytes for float(aabb: 36).
+ same intersect/contain semantics as aabb.
+ */
+template<typename T = float>
+struct aabb_minmax
 {
-    assert(data != nullptr);
-    
-    const mat3<T> axes = naturalAxes(data, count);
+    aabb_minmax():
+	lower(0),
+	upper(0)
+	{}
+    aabb_minmax(const vec3<T>& lower_, const vec3<T>& upper_):
+	lower(lower_),
+	upper(upper_)
+	{}
+    explicit aabb_minmax(const aabb<T>& bb):
+	lower(bb.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX]),
+	upper(bb.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX])
+	{}
+    aabb<T> to_aabb() const
+	{
+	    return aabb<T>(lower, upper);
+	}
 
-    const vec3<T>& primaryAxis = axes[0];
+    vec3<T> centre() const
+	{
+	    return (lower + upper) * (T)0.5;
+	}
+    vec3<T> extent() const
+	{
+	    return upper - lower;
+	}
 
-    // projA-B = |A| * cos<A,B> = |A| * (A dot B) / (|A||B|) = A dot B / |B|
-    T projMin = dot(*data, primaryAxis);
-    T projMax = projMin;
-    
-    const vec3<T>* min = data;
-    const vec3<T>* max = min;
-    
-    for(std::size_t i = 1; i < count; i++)
-    {
-	const vec3<T>* cur = data + i;
+    bool intersect(const aabb_minmax& o) const
+	{
+	    return (lower < o.upper) && (upper > o.lower);
+	}
+    bool intersect(const spherebb<T>& o) const
+	{
+	    const vec3<T> delta = o.radius;
+	    return (o.centre >= lower - delta) && (o.centre <= upper + delta);
+	}
+    bool contain(const aabb_minmax& o) const
+	{
+	    return (lower <= o.lower) && (o.upper <= upper);
+	}
+    bool contain(const spherebb<T>& o) const
+	{
+	    const vec3<T> delta = o.radius;
+	    return (o.centre >= lower + delta) && (o.centre <= upper - delta);
+	}
+
+    vec3<T> lower;
+    vec3<T> upper;
+};
+
+/*
+ *@brief, centre and half extent, 24 bytes for float.
+ tests are one subtraction per axis(|c - o.c| against the half extents), handy when boxes move(translate the centre only)
+ */
+template<typename T = float>
+struct aabb_centre
+{
+    aabb_centre():
+	centre(0),
+	half(0)
+	{}
+    aabb_centre(const vec3<T>& centre_, const vec3<T>& half_):
+	centre(centre_),
+	half(half_)
+	{}
+    explicit aabb_centre(const aabb_minmax<T>& bb):
+	centre(bb.centre()),
+	half(bb.extent() * (T)0.5)
+	{}
+    explicit aabb_centre(const aabb<T>& bb):
+	aabb_centre(aabb_minmax<T>(bb))
+	{}
+    aabb_minmax<T> to_minmax() const
+	{
+	    return aabb_minmax<T>(centre - half, centre + half);
+	}
+    aabb<T> to_aabb() const
+	{
+	    return aabb<T>(centre - half, centre + half);
+	}
 
-	const T curProj = dot(*cur, primaryAxis);
+    bool intersect(const aabb_centre& o) const
+	{
+	    return (centre - o.centre).abs() < half + o.half;
+	}
+    bool intersect(const spherebb<T>& o) const
+	{
+	    const vec3<T> delta = o.radius;
+	    return (centre - o.centre).abs() <= half + delta;
+	}
+    bool contain(const aabb_centre& o) const
+	{
+	    return (centre - o.centre).abs() + o.half <= half;
+	}
+    bool contain(const spherebb<T>& o) const
+	{
+	    const vec3<T> delta = o.radius;
+	    return (centre - o.centre).abs() + delta <= half;
+	}
+
+    vec3<T> centre;
+    vec3<T> half;
+};
 
-	if(projMin > curProj)
+/*
+ *@brief, a box quantized to 8 bits per axis inside a parent box, 6 bytes.
+ encoding rounds lower down and upper up, so the decoded box holds the original one(clamped to the parent).
+ intersect/contain compare two boxes of the same parent in the integer domain, exactly as their decoded boxes would,
+ so intersect may report overlaps the original boxes don't have, never misses one.
+ */
+struct aabb_q8
+{
+    std::uint8_t lower[3];
+    std::uint8_t upper[3];
+
+    template<typename T>
+    static aabb_q8 encode(const aabb_minmax<T>& bb, const aabb_minmax<T>& parent)
+	{
+	    const vec3<T> step = parent.extent() / (T)255;
+	    aabb_q8 ret;
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		const T scale = step[c] > 0 ? (T)1 / step[c] : 0;
+		std::uint8_t l = _q(std::floor((bb.lower[c] - parent.lower[c]) * scale));
+		std::uint8_t u = _q(std::ceil((bb.upper[c] - parent.lower[c]) * scale));
+		// one more step where the decoded value rounds to the inside
+		if(l > 0 && _dq(parent.lower[c], step[c], l) > bb.lower[c])
+		    l--;
+		if(u < 255 && _dq(parent.lower[c], step[c], u) < bb.upper[c])
+		    u++;
+		ret.lower[c] = l;
+		ret.upper[c] = u;
+	    }
+	    return ret;
+	}
+    template<typename T>
+    aabb_minmax<T> decode(const aabb_minmax<T>& parent) const
 	{
-	    projMin = curProj;
-	    min = cur;
+	    const vec3<T> step = parent.extent() / (T)255;
+	    aabb_minmax<T> ret;
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		ret.lower[c] = _dq(parent.lower[c], step[c], lower[c]);
+		ret.upper[c] = _dq(parent.lower[c], step[c], upper[c]);
+	    }
+	    return ret;
+	}
 
-	    continue;
+    bool intersect(const aabb_q8& o) const
+	{
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		if(lower[c] >= o.upper[c] || upper[c] <= o.lower[c])
+		    return false;
+	    }
+	    return true;
 	}
+    bool contain(const aabb_q8& o) const
+	{
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		if(lower[c] > o.lower[c] || upper[c] < o.upper[c])
+		    return false;
+	    }
+	    return true;
+	}
+private:
+    template<typename T>
+    static std::uint8_t _q(const T q)
+	{
+	    return (std::uint8_t)(q < 0 ? 0 : (q > 255 ? 255 : q));
+	}
+    template<typename T>
+    static T _dq(const T parentLower, const T step, const std::uint8_t q)
+	{
+	    return parentLower + q * step;
+	}
+};
+
+static_assert(sizeof(aabb_minmax<float>) == 24, "aabb_minmax<float> must be 24 bytes");
+static_assert(sizeof(aabb_centre<float>) == 24, "aabb_centre<float> must be 24 bytes");
+static_assert(sizeof(aabb_q8) == 6, "aabb_q8 must be 6 bytes");
+
+// points above this count are split across threads when bParallel
+static constexpr std::size_t boundingbox_parallel_chunk = 64 * 1024;
+
+/*
+ *@brief, the tightest aabb of count points, count must not be 0
+ */
+template<typename T>
+aabb<T> aabbFromPoints(const vec3<T>* data, const std::size_t count, const bool bParallel = false)
+{
+    assert(data != nullptr && count != 0);
+    auto map = [=](const std::size_t begin, const std::size_t end)
+	{
+	    aabb<T> ret(data[begin], data[begin]);
+	    vec3<T>& lower = ret.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX];
+	    vec3<T>& upper = ret.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX];
+	    for(std::size_t i = begin + 1; i < end; i++)
+	    {
+		const vec3<T>& p = data[i];
+		for(std::uint8_t c = 0; c < 3; c++)
+		{
+		    if(p[c] < lower[c])
+			lower[c] = p[c];
+		    if(p[c] > upper[c])
+			upper[c] = p[c];
+		}
+	    }
+	    ret.set(lower, upper);
+	    return ret;
+	};
+    if(!bParallel)
+	return map(0, count);
+    const aabb<T> init(data[0], data[0]);
+    return parallelReduce(count, boundingbox_parallel_chunk, init, map,
+			  [](aabb<T>& into, const aabb<T>& partial) { into.expand(partial); });
+}
+
+/*
+ *@brief, float version through the dispatched stream kernels(see cpu.h),
+ the points are read as a flat float array, so any level gives the same box.
+ */
+aabb<float> aabbFromPoints(const vec3f* data, const std::size_t count, const bool bParallel = false);
+
+// how hard sphereFromPoints works on the radius
+enum sphere_fit : std::uint8_t
+{
+    sphere_fit_ritter = 0,	// 2 passes, the seed and one growing pass, typically 5%-20% over the minimal radius
+    sphere_fit_tight		// then sphere_fit_iterations shrink and regrow passes, typically a few % over
+};
+
+static constexpr std::uint8_t sphere_fit_iterations = 8;
+
+namespace detail
+{
+    /*
+      extreme points along the epos-14 directions, the axes and the 4 cube diagonals(not normalized,
+      only the order of the projections matters), proj[d][0] the smallest, proj[d][1] the largest.
+     */
+    template<typename T>
+    struct sphere_extremes
+    {
+	static constexpr std::uint8_t directions = 7;
+
+	sphere_extremes()
+	    {
+		for(std::uint8_t d = 0; d < directions; d++)
+		{
+		    proj[d][0] = std::numeric_limits<T>::max();
+		    proj[d][1] = std::numeric_limits<T>::lowest();
+		}
+	    }
+	static T project(const std::uint8_t d, const T x, const T y, const T z)
+	    {
+		switch(d)
+		{
+		case 0: return x;
+		case 1: return y;
+		case 2: return z;
+		case 3: return x + y + z;
+		case 4: return x + y - z;
+		case 5: return x - y + z;
+		default: return x - y - z;
+		}
+	    }
+	void add(const vec3<T>& p)
+	    {
+		for(std::uint8_t d = 0; d < directions; d++)
+		{
+		    const T pr = project(d, p.x, p.y, p.z);
+		    if(pr < proj[d][0])
+		    {
+			proj[d][0] = pr;
+			points[d][0] = p;
+		    }
+		    if(pr > proj[d][1])
+		    {
+			proj[d][1] = pr;
+			points[d][1] = p;
+		    }
+		}
+	    }
+	// keeps the earlier point on ties, so merging in chunk order matches one pass
+	void merge(const sphere_extremes& o)
+	    {
+		for(std::uint8_t d = 0; d < directions; d++)
+		{
+		    if(o.proj[d][0] < proj[d][0])
+		    {
+			proj[d][0] = o.proj[d][0];
+			points[d][0] = o.points[d][0];
+		    }
+		    if(o.proj[d][1] > proj[d][1])
+		    {
+			proj[d][1] = o.proj[d][1];
+			points[d][1] = o.points[d][1];
+		    }
+		}
+	    }
+	// the sphere over the most distant pair
+	spherebb<T> seed() const
+	    {
+		std::uint8_t best = 0;
+		T bestSqDist = points[0][0].sqDistance(points[0][1]);
+		for(std::uint8_t d = 1; d < directions; d++)
+		{
+		    const T sqDist = points[d][0].sqDistance(points[d][1]);
+		    if(sqDist > bestSqDist)
+		    {
+			bestSqDist = sqDist;
+			best = d;
+		    }
+		}
+		return spherebb<T>((points[best][0] + points[best][1]) * (T)0.5, std::sqrt(bestSqDist) * (T)0.5);
+	    }
+
+	T proj[directions][2];
+	vec3<T> points[directions][2];
+    };
+
+    template<typename T>
+    sphere_extremes<T> sphereExtremes(const vec3<T>* data, const std::size_t begin, const std::size_t end)
+    {
+	sphere_extremes<T> ret;
+	for(std::size_t i = begin; i < end; i++)
+	    ret.add(data[i]);
+	return ret;
+    }
+
+    template<typename T>
+    void sphereGrow(spherebb<T>& s, const vec3<T>* data, const std::size_t begin, const std::size_t end)
+    {
+	for(std::size_t i = begin; i < end; i++)
+	    s.expand(data[i]);
+    }
+
+    /*
+      Ritter from the epos-14 seed, then for sphere_fit_tight the iterative refinement of Ericson(RTCD 4.3.5):
+      shrink the last sphere by 5% and grow it over the points again, keep the smallest.
+      the serial passes start at a different point each time instead of shuffling the data.
+      parallel passes grow one sphere per chunk(all from the same start) and merge them in chunk order.
+      the points are only reached through Extremes: sphere_extremes<T>(begin, end), Grow: void(spherebb<T>&, begin, end)
+     */
+    template<typename T, typename Extremes, typename Grow>
+    spherebb<T> sphereFit(const std::size_t count, const sphere_fit fit, const bool bParallel, Extremes extremes, Grow grow)
+    {
+	const spherebb<T> seed = bParallel ?
+	    parallelReduce(count, boundingbox_parallel_chunk, sphere_extremes<T>(), extremes,
+			   [](sphere_extremes<T>& into, const sphere_extremes<T>& partial) { into.merge(partial); }).seed()
+	    : extremes(0, count).seed();
+
+	auto pass = [=](const spherebb<T>& start, const std::size_t offset)
+	    {
+		if(bParallel)
+		    return parallelReduce(count, boundingbox_parallel_chunk, start,
+					  [=](const std::size_t begin, const std::size_t end)
+					  {
+					      spherebb<T> ret = start;
+					      grow(ret, begin, end);
+					      return ret;
+					  },
+					  [](spherebb<T>& into, const spherebb<T>& partial) { into = into.merge(partial); });
+		spherebb<T> ret = start;
+		grow(ret, offset, count);
+		grow(ret, 0, offset);
+		return ret;
+	    };
 
-	if(projMax < curProj)
+	spherebb<T> ret = pass(seed, 0);
+	if(fit == sphere_fit_tight)
 	{
-	    projMax = curProj;
-	    max = cur;
+	    spherebb<T> s = ret;
+	    for(std::uint8_t k = 1; k <= sphere_fit_iterations; k++)
+	    {
+		s.radius *= (T)0.95;
+		s = pass(s, count * k / (sphere_fit_iterations + 1));
+		if(s.radius < ret.radius)
+		    ret = s;
+	    }
 	}
+	return ret;
     }
+}
 
-    return spherebb<T>(*min/2 + *max/2, projMax/2 - projMin/2);
+/*
+ *@brief, a bounding sphere of count(not 0) points in linear time, holds every point up to float rounding.
+ fit: sphere_fit
+ */
+template<typename T>
+spherebb<T> sphereFromPoints(const vec3<T>* data, const std::size_t count, const sphere_fit fit = sphere_fit_ritter, const bool bParallel = false)
+{
+    assert(data != nullptr && count != 0);
+    return detail::sphereFit<T>(count, fit, bParallel,
+				[data](const std::size_t begin, const std::size_t end) { return detail::sphereExtremes(data, begin, end); },
+				[data](spherebb<T>& s, const std::size_t begin, const std::size_t end) { detail::sphereGrow(s, data, begin, end); });
+}
+
+/*
+ *@brief, float version, 4 points per step(loadSoA4) for the extremes and for the containment test of the growing pass.
+ */
+spherebb<float> sphereFromPoints(const vec3f* data, const std::size_t count, const sphere_fit fit = sphere_fit_ritter, const bool bParallel = false);
+
+/*
+ *@brief, kept for the existing callers, the Ritter sphere of sphereFromPoints
+ */
+template<typename T>
+spherebb<T> genSphereBB(const vec3<T>* data, const std::size_t count)
+{
+    return sphereFromPoints(data, count);
 }
 
 template <typename T = float>
 struct obb
 {
+    /*
+      the box between 2 planes of unit normal, points[0] on the lower one, points[1] on the upper one
+      (the centres of the 2 faces).
+     */
     struct slab
     {
 	vec3<T> normal;
@@ -213,66 +693,337 @@ struct obb
 		
 		return plane(normal, points[1]).is_same_side(point, points[0]);
 	    }
+	T width() const
+	    {
+		return dot(points[1] - points[0], normal);
+	    }
     };
+
+    vec3<T> centre() const
+	{
+	    return (slabs[0].points[0] + slabs[0].points[1]) * (T)0.5;
+	}
+    T volume() const
+	{
+	    return slabs[0].width() * slabs[1].width() * slabs[2].width();
+	}
+    T surfaceArea() const
+	{
+	    const T w[3] = {slabs[0].width(), slabs[1].width(), slabs[2].width()};
+	    return (T)2 * (w[0] * w[1] + w[1] * w[2] + w[2] * w[0]);
+	}
+    // tolerance: how far p may lie outside
+    bool contain(const vec3<T>& p, const T tolerance = 0) const
+	{
+	    const vec3<T> c = centre();
+	    for(std::uint8_t i = 0; i < 3; i++)
+	    {
+		if(std::abs(dot(p - c, slabs[i].normal)) > slabs[i].width() * (T)0.5 + tolerance)
+		    return false;
+	    }
+	    return true;
+	}
+
     slab slabs[3];	
 };
 
-template <typename T>
-obb<T> genOrientedBB(const vec3<T>* data, const std::size_t count)
+// how genOrientedBB picks the axes
+enum obb_fit : std::uint8_t
 {
-    assert(data != nullptr);
-    
-    obb<T> ret;
-    
-    const mat3<T> axis = naturalAxes(data, count);
+    obb_fit_pca = 0,	// eigenvectors of the covariance, 2 passes(moments, extents)
+    obb_fit_dito	// the pca box or the best DiTO-14 box, whichever is smaller, 1 more pass(extreme points)
+};
+
+namespace detail
+{
+    // lower/upper projections onto the 3 axes of Frames frames
+    template<typename T, std::uint8_t Frames>
+    struct obb_extents
+    {
+	obb_extents()
+	    {
+		for(std::uint8_t a = 0; a < Frames * 3; a++)
+		{
+		    lower[a] = std::numeric_limits<T>::max();
+		    upper[a] = std::numeric_limits<T>::lowest();
+		}
+	    }
+	void add(const vec3<T>* axes, const vec3<T>& p)
+	    {
+		for(std::uint8_t a = 0; a < Frames * 3; a++)
+		{
+		    const T pr = dot(axes[a], p);
+		    if(pr < lower[a])
+			lower[a] = pr;
+		    if(pr > upper[a])
+			upper[a] = pr;
+		}
+	    }
+	void merge(const obb_extents& o)
+	    {
+		for(std::uint8_t a = 0; a < Frames * 3; a++)
+		{
+		    if(o.lower[a] < lower[a])
+			lower[a] = o.lower[a];
+		    if(o.upper[a] > upper[a])
+			upper[a] = o.upper[a];
+		}
+	    }
+	// the half surface area of frame f's box
+	T halfArea(const std::uint8_t f) const
+	    {
+		const T* l = lower + f * 3;
+		const T* u = upper + f * 3;
+		const T w[3] = {u[0] - l[0], u[1] - l[1], u[2] - l[2]};
+		return w[0] * w[1] + w[1] * w[2] + w[2] * w[0];
+	    }
+
+	T lower[Frames * 3];
+	T upper[Frames * 3];
+    };
 
-    for(std:uint8_t i = 0; i < 3; i++)
+    template<typename T, std::uint8_t Frames>
+    obb_extents<T, Frames> obbExtents(const vec3<T>* axes, const vec3<T>* data, const std::size_t begin, const std::size_t end)
     {
-	ret.slabs[i].normal = axis[i].normalize();
+	obb_extents<T, Frames> ret;
+	for(std::size_t i = begin; i < end; i++)
+	    ret.add(axes, data[i]);
+	return ret;
     }
 
-    T extend[3][2] = {{0}};
+    template<typename T>
+    obb<T> obbFromExtents(const vec3<T>* axes, const T* lower, const T* upper)
+    {
+	obb<T> ret;
+	vec3<T> centre;
+	for(std::uint8_t i = 0; i < 3; i++)
+	    centre += axes[i] * ((lower[i] + upper[i]) * (T)0.5);
+	for(std::uint8_t i = 0; i < 3; i++)
+	{
+	    typename obb<T>::slab& slab = ret.slabs[i];
+	    const T half = (upper[i] - lower[i]) * (T)0.5;
+	    slab.normal = axes[i];
+	    slab.points[0] = centre - axes[i] * half;
+	    slab.points[1] = centre + axes[i] * half;
+	}
+	return ret;
+    }
 
-    for(std::uint8_t i = 0; i < 3; i ++)
+    /*
+      DiTO-14(Larsson, Kallberg, Fast Computation of Tight-Fitting Oriented Bounding Boxes, 2011):
+      the 14 extreme points along the sphere_extremes directions span a large triangle(the most distant pair and
+      the point farthest from their line) and 2 tetrahedra over it(the points farthest below and above its plane).
+      every edge of those 7 triangles with the triangle normal makes a frame,
+      the frame with the smallest box over the 14 points wins.
+      returns false when the points are (nearly) collinear, no triangle to take a frame from.
+     */
+    template<typename T>
+    bool ditoFrame(const sphere_extremes<T>& extremes, vec3<T>* frame)
     {
-	obb<T>::slab & curSlab = ret.slabs[i];
-	const vec3<T> & normal = curSlab.normal;
-	vec3<T> & minP = curSlab.points[0];
-	vec3<T> & maxP = curSlab.points[1];
-	T & minE = extend[i][0];
-	T & maxE = extend[i][1];
-
-	/*
-	  for each slab.normal, minP is the point which has smallest
-	  projection on the normal, and maxP has the largest.
-	      
-	  proj = P * P * N / (|P||N|)
-	  since |N| = 1, so proj = ((P^T dot P) / |P|) * N;
-	*/
-
-	minP = data[0];
-	maxP = data[0];
-	minE = dot(minP, minP) / minP.magnitude();
-	maxE = minE;
-	
-	for(std::size_t j = 1; j < count; j++)
+	const std::uint8_t count = sphere_extremes<T>::directions * 2;
+	vec3<T> points[count];
+	for(std::uint8_t i = 0; i < count; i++)
+	    points[i] = extremes.points[i / 2][i % 2];
+
+	std::uint8_t p0 = 0;
+	T best = -1;
+	for(std::uint8_t d = 0; d < sphere_extremes<T>::directions; d++)
+	{
+	    const T sqDist = extremes.points[d][0].sqDistance(extremes.points[d][1]);
+	    if(sqDist > best)
+	    {
+		best = sqDist;
+		p0 = d * 2;
+	    }
+	}
+	const vec3<T>& a = points[p0];
+	const vec3<T>& b = points[p0 + 1];
+	const vec3<T> ab = b - a;
+	const T sqLen = dot(ab, ab);
+	if(!(sqLen > 0))
+	    return false;
+
+	// farthest from the line ab
+	std::uint8_t p2 = 0;
+	best = 0;
+	for(std::uint8_t i = 0; i < count; i++)
+	{
+	    const vec3<T> ap = points[i] - a;
+	    const T sqDist = dot(ap, ap) - dot(ap, ab) * dot(ap, ab) / sqLen;
+	    if(sqDist > best)
+	    {
+		best = sqDist;
+		p2 = i;
+	    }
+	}
+	if(!(best > sqLen * std::numeric_limits<T>::epsilon()))
+	    return false;
+	const vec3<T>& c = points[p2];
+
+	// the apexes below and above abc
+	const vec3<T> n = cross(ab, c - a);
+	std::uint8_t apex[2] = {0, 0};
+	T apexDist[2] = {0, 0};
+	for(std::uint8_t i = 0; i < count; i++)
+	{
+	    const T h = dot(points[i] - a, n);
+	    if(h < apexDist[0])
+	    {
+		apexDist[0] = h;
+		apex[0] = i;
+	    }
+	    if(h > apexDist[1])
+	    {
+		apexDist[1] = h;
+		apex[1] = i;
+	    }
+	}
+
+	vec3<T> triangles[7][3] = {{a, b, c}};
+	std::uint8_t triangleCount = 1;
+	for(std::uint8_t e = 0; e < 2; e++)
 	{
-	    const vec3 & P = data[j];
-	    const T projScalar = dot(P, P) / P.magnitude();
-	    if(minE > projScalar)
+	    if(apexDist[e] == 0)
+		continue;
+	    const vec3<T>& q = points[apex[e]];
+	    const vec3<T> t[3][3] = {{a, b, q}, {b, c, q}, {c, a, q}};
+	    for(std::uint8_t i = 0; i < 3; i++, triangleCount++)
 	    {
-		minE = projScalar;
-		minP = P;
+		for(std::uint8_t v = 0; v < 3; v++)
+		    triangles[triangleCount][v] = t[i][v];
 	    }
+	}
 
-	    if(maxE < projScalar)
+	T bestArea = std::numeric_limits<T>::max();
+	for(std::uint8_t t = 0; t < triangleCount; t++)
+	{
+	    const vec3<T> (&tri)[3] = triangles[t];
+	    const vec3<T> normal = cross(tri[1] - tri[0], tri[2] - tri[0]);
+	    if(!(dot(normal, normal) > 0))
+		continue;
+	    const vec3<T> unitNormal = normal.normalize();
+	    for(std::uint8_t e = 0; e < 3; e++)
 	    {
-		maxE = projScalar;
-		maxP = P;
+		const vec3<T> edge = tri[(e + 1) % 3] - tri[e];
+		if(!(dot(edge, edge) > 0))
+		    continue;
+		const vec3<T> axes[3] = {edge.normalize(), unitNormal, cross(unitNormal, edge.normalize())};
+		const T area = obbExtents<T, 1>(axes, points, 0, count).halfArea(0);
+		if(area < bestArea)
+		{
+		    bestArea = area;
+		    for(std::uint8_t i = 0; i < 3; i++)
+			frame[i] = axes[i];
+		}
 	    }
 	}
+	return bestArea < std::numeric_limits<T>::max();
     }
+
+    // block wise moments, momentsVec3 without its threads
+    template<typename T>
+    point_moments<T> obbMoments(const vec3<T>* data, const std::size_t count, const bool bParallel)
+    {
+	if(bParallel)
+	    return momentsVec3(data, count);
+	const std::size_t blockSize = 1024;
+	point_moments<T> ret;
+	for(std::size_t b = 0; b < count; b += blockSize)
+	    ret.merge(momentsBlock<T>(data + b, count - b < blockSize ? count - b : blockSize));
+	return ret;
+    }
+
+    /*
+      Extremes: sphere_extremes<T>(begin, end),
+      Extents1/Extents2: obb_extents<T, 1 or 2>(axes, begin, end)
+     */
+    template<typename T, typename Extremes, typename Extents1, typename Extents2>
+    obb<T> obbFit(const vec3<T>* data, const std::size_t count, const obb_fit fit, const bool bParallel,
+		  Extremes extremes, Extents1 extents1, Extents2 extents2)
+    {
+	const mat3<T> eigen = obbMoments(data, count, bParallel).covariance().eigenvectors();
+	vec3<T> axes[6] = {eigen[0], eigen[1], eigen[2]};
+
+	bool bDito = false;
+	if(fit == obb_fit_dito)
+	{
+	    const sphere_extremes<T> e = bParallel ?
+		parallelReduce(count, boundingbox_parallel_chunk, sphere_extremes<T>(), extremes,
+			       [](sphere_extremes<T>& into, const sphere_extremes<T>& partial) { into.merge(partial); })
+		: extremes(0, count);
+	    bDito = ditoFrame(e, axes + 3);
+	}
+
+	if(!bDito)
+	{
+	    const obb_extents<T, 1> ext = bParallel ?
+		parallelReduce(count, boundingbox_parallel_chunk, obb_extents<T, 1>(),
+			       [&](const std::size_t begin, const std::size_t end) { return extents1(axes, begin, end); },
+			       [](obb_extents<T, 1>& into, const obb_extents<T, 1>& partial) { into.merge(partial); })
+		: extents1(axes, 0, count);
+	    return obbFromExtents(axes, ext.lower, ext.upper);
+	}
+
+	// both frames in one pass
+	const obb_extents<T, 2> ext = bParallel ?
+	    parallelReduce(count, boundingbox_parallel_chunk, obb_extents<T, 2>(),
+			   [&](const std::size_t begin, const std::size_t end) { return extents2(axes, begin, end); },
+			   [](obb_extents<T, 2>& into, const obb_extents<T, 2>& partial) { into.merge(partial); })
+	    : extents2(axes, 0, count);
+	const std::uint8_t f = ext.halfArea(1) < ext.halfArea(0) ? 1 : 0;
+	return obbFromExtents(axes + f * 3, ext.lower + f * 3, ext.upper + f * 3);
+    }
+}
+
+/*
+ *@brief, an oriented box of count(not 0) points, fit: obb_fit.
+ the pca axes follow the spread of the points, not the hull, so elongated or uneven point densities
+ can tilt them, obb_fit_dito looks at the hull through the extreme points and keeps the smaller box.
+ */
+template <typename T>
+obb<T> genOrientedBB(const vec3<T>* data, const std::size_t count, const obb_fit fit = obb_fit_pca, const bool bParallel = false)
+{
+    assert(data != nullptr && count != 0);
+    return detail::obbFit(data, count, fit, bParallel,
+			  [data](const std::size_t begin, const std::size_t end) { return detail::sphereExtremes(data, begin, end); },
+			  [data](const vec3<T>* axes, const std::size_t begin, const std::size_t end) { return detail::obbExtents<T, 1>(axes, data, begin, end); },
+			  [data](const vec3<T>* axes, const std::size_t begin, const std::size_t end) { return detail::obbExtents<T, 2>(axes, data, begin, end); });
+}
+
+/*
+ *@brief, float version, 4 points per step(loadSoA4) in the extreme and the extent passes,
+ the moments are momentsBlock's.
+ */
+obb<float> genOrientedBB(const vec3f* data, const std::size_t count, const obb_fit fit = obb_fit_pca, const bool bParallel = false);
+
+// objects above this count are split across threads when bParallel
+static constexpr std::size_t obb_batch_parallel_chunk = 16;
+
+/*
+ *@brief, one box per object, object i is data[offsets[i], offsets[i + 1]), offsets has count + 1 entries,
+ an empty object gets obb<T>(). bParallel spreads the objects over the threads, each object is fitted on one.
+ */
+template <typename T>
+void genOrientedBBs(const vec3<T>* data, const std::size_t* offsets, const std::size_t count, obb<T>* out,
+		    const obb_fit fit = obb_fit_pca, const bool bParallel = false)
+{
+    assert((data != nullptr && offsets != nullptr && out != nullptr) || count == 0);
+    auto body = [=](const std::size_t begin, const std::size_t end)
+	{
+	    for(std::size_t i = begin; i < end; i++)
+	    {
+		assert(offsets[i] <= offsets[i + 1]);
+		const std::size_t n = offsets[i + 1] - offsets[i];
+		out[i] = n == 0 ? obb<T>() : genOrientedBB(data + offsets[i], n, fit);
+	    }
+	};
+    if(bParallel)
+	parallelFor(count, obb_batch_parallel_chunk, body);
+    else
+	body(0, count);
 }
 
+void genOrientedBBs(const vec3f* data, const std::size_t* offsets, const std::size_t count, obb<float>* out,
+		    const obb_fit fit = obb_fit_pca, const bool bParallel = false);
 
 GB_PHYSICS_NS_END
@@ -0,0 +1,5 @@
+//gbPhysics config file
+
+//version
+#define GB_PHYSICS_VERSION_MAJOR 0
+#define GB_PHYSICS_VERSION_MINOR 0
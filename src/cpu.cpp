@@ -0,0 +1,132 @@
+#include "cpu.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define GB_PHYSICS_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define GB_PHYSICS_X86
+#endif
+
+using namespace gb::physics;
+
+#if defined(GB_PHYSICS_X86)
+static void _cpuid(const unsigned int leaf, const unsigned int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subLeaf);
+    for(int i = 0; i < 4; i++)
+	regs[i] = (unsigned int)r[i];
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0, register state the os saves on context switches
+static std::uint64_t _xgetbv()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((std::uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static simd_level _detect()
+{
+#if defined(GB_PHYSICS_X86)
+    unsigned int r[4];
+    _cpuid(0, 0, r);
+    const unsigned int maxLeaf = r[0];
+
+    _cpuid(1, 0, r);
+    const unsigned int ecx1 = r[2], edx1 = r[3];
+    if((edx1 & (1u << 26)) == 0)
+	return simd_level::scalar;
+    if((ecx1 & (1u << 19)) == 0)
+	return simd_level::sse2;
+
+    // avx needs the os to save ymm(XCR0 bits 1, 2)
+    const bool osxsave = (ecx1 & (1u << 27)) != 0;
+    const std::uint64_t xcr0 = osxsave ? _xgetbv() : 0;
+    if((ecx1 & (1u << 28)) == 0 || (xcr0 & 0x6) != 0x6 || maxLeaf < 7)
+	return simd_level::sse41;
+
+    _cpuid(7, 0, r);
+    const unsigned int ebx7 = r[1];
+    if((ebx7 & (1u << 5)) == 0)
+	return simd_level::sse41;
+    // avx-512f, plus opmask and zmm state(XCR0 bits 5, 6, 7)
+    if((ebx7 & (1u << 16)) == 0 || (xcr0 & 0xe6) != 0xe6)
+	return simd_level::avx2;
+    return simd_level::avx512;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+// detected level capped by GB_PHYSICS_SIMD
+static simd_level _startup_level()
+{
+    const simd_level detected = detectedSimdLevel();
+    const char* env = std::getenv("GB_PHYSICS_SIMD");
+    if(env == nullptr)
+	return detected;
+
+    for(std::uint8_t l = 0; l < (std::uint8_t)simd_level::count; l++)
+    {
+	if(std::strcmp(env, simdLevelName((simd_level)l)) == 0)
+	    return (simd_level)l < detected ? (simd_level)l : detected;
+    }
+    return detected;
+}
+
+static std::atomic<std::uint8_t>& _active()
+{
+    static std::atomic<std::uint8_t> ret((std::uint8_t)_startup_level());
+    return ret;
+}
+
+simd_level gb::physics::detectedSimdLevel()
+{
+    static const simd_level ret = _detect();
+    return ret;
+}
+
+simd_level gb::physics::activeSimdLevel()
+{
+    return (simd_level)_active().load(std::memory_order_relaxed);
+}
+
+simd_level gb::physics::forceSimdLevel(const simd_level level)
+{
+    const simd_level detected = detectedSimdLevel();
+    const simd_level ret = level < detected ? level : detected;
+    _active().store((std::uint8_t)ret, std::memory_order_relaxed);
+    return ret;
+}
+
+void gb::physics::resetSimdLevel()
+{
+    _active().store((std::uint8_t)_startup_level(), std::memory_order_relaxed);
+}
+
+const char* gb::physics::simdLevelName(const simd_level level)
+{
+    switch(level)
+    {
+    case simd_level::scalar: return "scalar";
+    case simd_level::sse2: return "sse2";
+    case simd_level::sse41: return "sse4.1";
+    case simd_level::avx2: return "avx2";
+    case simd_level::avx512: return "avx512";
+    default: return "unknown";
+    }
+}
@@ -0,0 +1,52 @@
+// runtime cpu feature detection and kernel dispatch
+
+#pragma once
+
+#include "physicsNS.h"
+#include <cstdint>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, instruction set levels bulk kernels may be built for, each one implies the previous ones.
+ */
+enum class simd_level : std::uint8_t
+{
+    scalar = 0,
+    sse2,
+    sse41,
+    avx2,
+    avx512,
+    count
+};
+
+// widest level both the cpu and the os support, detected once
+simd_level detectedSimdLevel();
+/*
+ *@brief, level the dispatched kernels use, detectedSimdLevel() unless forced.
+ the GB_PHYSICS_SIMD environment variable(scalar, sse2, sse4.1, avx2, avx512) caps it at startup.
+ */
+simd_level activeSimdLevel();
+/*
+ *@brief, route kernels through level(clamped to the detected one) until reset, for benchmarks and tests.
+ *@return, the level actually in use.
+ */
+simd_level forceSimdLevel(const simd_level level);
+void resetSimdLevel();
+const char* simdLevelName(const simd_level level);
+
+/*
+ *@brief, kernel table for the active level,
+ byLevel[l] is the table built for level l, nullptr where the build has none,
+ the widest one not above activeSimdLevel() is picked(byLevel[scalar] must be set).
+ */
+template<typename Table>
+const Table& selectKernels(const Table* const (&byLevel)[(std::size_t)simd_level::count])
+{
+    std::size_t l = (std::size_t)activeSimdLevel();
+    while(l > 0 && byLevel[l] == nullptr)
+	l--;
+    return *byLevel[l];
+}
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,165 @@
+// zero copy Eigen views over vec and mat arrays
+
+#pragma once
+
+#include "matrix.h"
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, Eigen::Map over our own storage, no staging copy, writes through the map land in the array.
+ vectors and matrices are column major on both sides, so an array of count
+ - vec3 is a 3 x count matrix(column i = point i), vec4 a 4 x count one
+ - mat3 is a 3 x (3 * count) matrix(matrix i = middleCols<3>(3 * i)), mat4 a 4 x (4 * count) one
+ - affine3 a 3 x (4 * count) one
+ and a single mat3/mat4/affine3 a fixed size 3x3/4x4/3x4 map.
+ vec4<float>(and mat4<float>) are 16 bytes aligned, their maps are flagged Aligned16 so Eigen's packet loads need no peeling.
+
+  e.g. centroid and covariance of a point set:
+  const auto p = eigenMap(points, count);
+  const Eigen::Vector3f mean = p.rowwise().mean();
+  const Eigen::Matrix3f c = (p.colwise() - mean) * (p.colwise() - mean).transpose() / count;
+ */
+template<typename V>
+struct eigen_map_options
+{
+    static constexpr int value = alignof(V) >= 16 ? Eigen::Aligned16 : Eigen::Unaligned;
+};
+
+template<typename T, int Rows, int Cols, typename V>
+using eigen_map = Eigen::Map<Eigen::Matrix<T, Rows, Cols>, eigen_map_options<V>::value>;
+template<typename T, int Rows, int Cols, typename V>
+using eigen_const_map = Eigen::Map<const Eigen::Matrix<T, Rows, Cols>, eigen_map_options<V>::value>;
+
+namespace detail
+{
+    // a V must be Rows * Cols tightly packed T, column major
+    template<typename V, typename T, std::size_t Scalars>
+    constexpr bool eigenMappable()
+    {
+	static_assert(std::is_arithmetic<T>::value, "eigenMap, T must be an arithmetic type");
+	static_assert(sizeof(V) == Scalars * sizeof(T), "eigenMap, V must be tightly packed");
+	static_assert(std::is_standard_layout<V>::value, "eigenMap, V must be standard layout");
+	return true;
+    }
+}
+
+// vec3 array, 3 x count
+template<typename T>
+eigen_map<T, 3, Eigen::Dynamic, vec3<T>> eigenMap(vec3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<vec3<T>, T, 3>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_map<T, 3, Eigen::Dynamic, vec3<T>>(data == nullptr ? nullptr : data->data(), 3, (Eigen::Index)count);
+}
+template<typename T>
+eigen_const_map<T, 3, Eigen::Dynamic, vec3<T>> eigenMap(const vec3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<vec3<T>, T, 3>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_const_map<T, 3, Eigen::Dynamic, vec3<T>>(data == nullptr ? nullptr : data->data(), 3, (Eigen::Index)count);
+}
+
+// vec4 array, 4 x count
+template<typename T>
+eigen_map<T, 4, Eigen::Dynamic, vec4<T>> eigenMap(vec4<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<vec4<T>, T, 4>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_map<T, 4, Eigen::Dynamic, vec4<T>>(data == nullptr ? nullptr : data->data(), 4, (Eigen::Index)count);
+}
+template<typename T>
+eigen_const_map<T, 4, Eigen::Dynamic, vec4<T>> eigenMap(const vec4<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<vec4<T>, T, 4>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_const_map<T, 4, Eigen::Dynamic, vec4<T>>(data == nullptr ? nullptr : data->data(), 4, (Eigen::Index)count);
+}
+
+// mat3 array, 3 x (3 * count)
+template<typename T>
+eigen_map<T, 3, Eigen::Dynamic, mat3<T>> eigenMap(mat3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<mat3<T>, T, 9>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_map<T, 3, Eigen::Dynamic, mat3<T>>(data == nullptr ? nullptr : data->value[0].data(), 3, (Eigen::Index)(3 * count));
+}
+template<typename T>
+eigen_const_map<T, 3, Eigen::Dynamic, mat3<T>> eigenMap(const mat3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<mat3<T>, T, 9>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_const_map<T, 3, Eigen::Dynamic, mat3<T>>(data == nullptr ? nullptr : data->value[0].data(), 3, (Eigen::Index)(3 * count));
+}
+
+// mat4 array, 4 x (4 * count)
+template<typename T>
+eigen_map<T, 4, Eigen::Dynamic, mat4<T>> eigenMap(mat4<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<mat4<T>, T, 16>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_map<T, 4, Eigen::Dynamic, mat4<T>>(data == nullptr ? nullptr : data->value[0].data(), 4, (Eigen::Index)(4 * count));
+}
+template<typename T>
+eigen_const_map<T, 4, Eigen::Dynamic, mat4<T>> eigenMap(const mat4<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<mat4<T>, T, 16>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_const_map<T, 4, Eigen::Dynamic, mat4<T>>(data == nullptr ? nullptr : data->value[0].data(), 4, (Eigen::Index)(4 * count));
+}
+
+// affine3 array, 3 x (4 * count)
+template<typename T>
+eigen_map<T, 3, Eigen::Dynamic, affine3<T>> eigenMap(affine3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<affine3<T>, T, 12>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_map<T, 3, Eigen::Dynamic, affine3<T>>(data == nullptr ? nullptr : data->value[0].data(), 3, (Eigen::Index)(4 * count));
+}
+template<typename T>
+eigen_const_map<T, 3, Eigen::Dynamic, affine3<T>> eigenMap(const affine3<T>* data, const std::size_t count)
+{
+    static_assert(detail::eigenMappable<affine3<T>, T, 12>(), "");
+    assert(data != nullptr || count == 0);
+    return eigen_const_map<T, 3, Eigen::Dynamic, affine3<T>>(data == nullptr ? nullptr : data->value[0].data(), 3, (Eigen::Index)(4 * count));
+}
+
+// single matrices
+template<typename T>
+eigen_map<T, 3, 3, mat3<T>> eigenMap(mat3<T>& m)
+{
+    static_assert(detail::eigenMappable<mat3<T>, T, 9>(), "");
+    return eigen_map<T, 3, 3, mat3<T>>(m.value[0].data());
+}
+template<typename T>
+eigen_const_map<T, 3, 3, mat3<T>> eigenMap(const mat3<T>& m)
+{
+    static_assert(detail::eigenMappable<mat3<T>, T, 9>(), "");
+    return eigen_const_map<T, 3, 3, mat3<T>>(m.value[0].data());
+}
+template<typename T>
+eigen_map<T, 4, 4, mat4<T>> eigenMap(mat4<T>& m)
+{
+    static_assert(detail::eigenMappable<mat4<T>, T, 16>(), "");
+    return eigen_map<T, 4, 4, mat4<T>>(m.value[0].data());
+}
+template<typename T>
+eigen_const_map<T, 4, 4, mat4<T>> eigenMap(const mat4<T>& m)
+{
+    static_assert(detail::eigenMappable<mat4<T>, T, 16>(), "");
+    return eigen_const_map<T, 4, 4, mat4<T>>(m.value[0].data());
+}
+template<typename T>
+eigen_map<T, 3, 4, affine3<T>> eigenMap(affine3<T>& m)
+{
+    static_assert(detail::eigenMappable<affine3<T>, T, 12>(), "");
+    return eigen_map<T, 3, 4, affine3<T>>(m.value[0].data());
+}
+template<typename T>
+eigen_const_map<T, 3, 4, affine3<T>> eigenMap(const affine3<T>& m)
+{
+    static_assert(detail::eigenMappable<affine3<T>, T, 12>(), "");
+    return eigen_const_map<T, 3, 4, affine3<T>>(m.value[0].data());
+}
+
+GB_PHYSICS_NS_END
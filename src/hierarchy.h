@@ -0,0 +1,221 @@
+// flattened transform hierarchy
+
+#pragma once
+
+#include "quat.h"
+#include <vector>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, scene graph transforms in flat arrays, a node is an index.
+ a parent is always added before its children, so parent index < child index.
+ every node keeps a local translation, rotation and scale(world = parent world * T * R * S).
+
+ editing a local transform only marks the node dirty, update() then recomputes the world matrices
+ of the dirty nodes and of their subtrees, level by level, nothing else is touched.
+ so a big mostly static hierarchy costs as much as its moving part.
+ nodes can't be removed(clear() and rebuild).
+ */
+template <typename T>
+class transform_hierarchy
+{
+public:
+    static constexpr std::uint32_t npos = ~std::uint32_t(0);
+    // dirty nodes of one level above this count are updated in parallel
+    static constexpr std::size_t parallel_chunk = 4096;
+
+    void reserve(const std::size_t capacity)
+	{
+	    _parent.reserve(capacity);
+	    _level.reserve(capacity);
+	    _firstChild.reserve(capacity);
+	    _nextSibling.reserve(capacity);
+	    _translation.reserve(capacity);
+	    _rotation.reserve(capacity);
+	    _scale.reserve(capacity);
+	    _world.reserve(capacity);
+	    _dirty.reserve(capacity);
+	}
+
+    void clear()
+	{
+	    _parent.clear();
+	    _level.clear();
+	    _firstChild.clear();
+	    _nextSibling.clear();
+	    _translation.clear();
+	    _rotation.clear();
+	    _scale.clear();
+	    _world.clear();
+	    _dirty.clear();
+	    _pending.clear();
+	}
+
+    // a root if parent is npos, returns the node index, the node starts dirty
+    std::uint32_t add(const std::uint32_t parent = npos,
+		      const vec3<T>& translation = vec3<T>(0),
+		      const quat<T>& rotation = quat<T>::make_identity(),
+		      const vec3<T>& scale = vec3<T>(1))
+	{
+	    assert(parent == npos || parent < size());
+	    const std::uint32_t ret = (std::uint32_t)size();
+	    _parent.push_back(parent);
+	    _level.push_back(parent == npos ? 0 : _level[parent] + 1);
+	    _firstChild.push_back(npos);
+	    _nextSibling.push_back(npos);
+	    if(parent != npos)
+	    {
+		// prepend, sibling order doesn't matter
+		_nextSibling[ret] = _firstChild[parent];
+		_firstChild[parent] = ret;
+	    }
+	    _translation.push_back(translation);
+	    _rotation.push_back(rotation);
+	    _scale.push_back(scale);
+	    _world.push_back(mat4<T>::make_identity());
+	    _dirty.push_back(0);
+	    _mark(ret);
+	    return ret;
+	}
+
+    std::size_t size() const { return _parent.size(); }
+    std::uint32_t parent(const std::uint32_t node) const { return _parent[node]; }
+    std::uint32_t level(const std::uint32_t node) const { return _level[node]; }
+
+    const vec3<T>& translation(const std::uint32_t node) const { return _translation[node]; }
+    const quat<T>& rotation(const std::uint32_t node) const { return _rotation[node]; }
+    const vec3<T>& scale(const std::uint32_t node) const { return _scale[node]; }
+
+    void set_translation(const std::uint32_t node, const vec3<T>& translation)
+	{
+	    _translation[node] = translation;
+	    _mark(node);
+	}
+    void set_rotation(const std::uint32_t node, const quat<T>& rotation)
+	{
+	    _rotation[node] = rotation;
+	    _mark(node);
+	}
+    void set_scale(const std::uint32_t node, const vec3<T>& scale)
+	{
+	    _scale[node] = scale;
+	    _mark(node);
+	}
+    void set_local(const std::uint32_t node, const vec3<T>& translation, const quat<T>& rotation, const vec3<T>& scale)
+	{
+	    _translation[node] = translation;
+	    _rotation[node] = rotation;
+	    _scale[node] = scale;
+	    _mark(node);
+	}
+
+    // T * R * S
+    mat4<T> local(const std::uint32_t node) const
+	{
+	    return makeTRS(_translation[node], _rotation[node], _scale[node]);
+	}
+
+    // stale until update() if the node or one of its ancestors is dirty
+    const mat4<T>& world(const std::uint32_t node) const { return _world[node]; }
+    const mat4<T>* worlds() const { return _world.data(); }
+    // the node itself was edited since the last update()
+    bool dirty(const std::uint32_t node) const { return _dirty[node] != 0; }
+
+    /*
+     *@brief, recompute the world matrices of the dirty subtrees, parents before children.
+     every level waits for the one above, the nodes of one level are independent(bParallel splits them)
+     *@return, the number of world matrices recomputed
+     */
+    std::size_t update(const bool bParallel = false)
+	{
+	    if(_pending.empty())
+		return 0;
+
+	    // dirty roots by level, a node under a dirty ancestor is reached through it
+	    std::vector<std::vector<std::uint32_t>> levels;
+	    for(const std::uint32_t node : _pending)
+	    {
+		if(_under_dirty(node))
+		    continue;
+		const std::uint32_t l = _level[node];
+		if(levels.size() <= l)
+		    levels.resize(l + 1);
+		levels[l].push_back(node);
+	    }
+	    _pending.clear();
+
+	    std::size_t ret = 0;
+	    std::vector<std::uint32_t> cur, next;
+	    for(std::size_t l = 0; l < levels.size() || !next.empty(); l++)
+	    {
+		cur.swap(next);
+		next.clear();
+		if(l < levels.size())
+		    cur.insert(cur.end(), levels[l].begin(), levels[l].end());
+		if(cur.empty())
+		    continue;
+
+		auto body = [this, &cur](const std::size_t begin, const std::size_t end)
+		    {
+			for(std::size_t i = begin; i < end; i++)
+			{
+			    const std::uint32_t node = cur[i];
+			    const std::uint32_t p = _parent[node];
+			    _world[node] = p == npos ? local(node) : _world[p] * local(node);
+			    _dirty[node] = 0;
+			}
+		    };
+		if(bParallel)
+		    parallelFor(cur.size(), parallel_chunk, body);
+		else
+		    body(0, cur.size());
+		ret += cur.size();
+
+		for(const std::uint32_t node : cur)
+		{
+		    for(std::uint32_t c = _firstChild[node]; c != npos; c = _nextSibling[c])
+			next.push_back(c);
+		}
+	    }
+	    return ret;
+	}
+private:
+    void _mark(const std::uint32_t node)
+	{
+	    if(_dirty[node] != 0)
+		return;
+	    _dirty[node] = 1;
+	    _pending.push_back(node);
+	}
+    bool _under_dirty(const std::uint32_t node) const
+	{
+	    for(std::uint32_t p = _parent[node]; p != npos; p = _parent[p])
+	    {
+		if(_dirty[p] != 0)
+		    return true;
+	    }
+	    return false;
+	}
+
+    std::vector<std::uint32_t> _parent;
+    std::vector<std::uint32_t> _level;
+    std::vector<std::uint32_t> _firstChild;
+    std::vector<std::uint32_t> _nextSibling;
+    std::vector<vec3<T>> _translation;
+    std::vector<quat<T>> _rotation;
+    std::vector<vec3<T>> _scale;
+    std::vector<mat4<T>, aligned_allocator<mat4<T>>> _world;
+    // byte flags, the parallel update writes neighbours from different threads
+    std::vector<std::uint8_t> _dirty;
+    std::vector<std::uint32_t> _pending;
+};
+
+template <typename T>
+constexpr std::uint32_t transform_hierarchy<T>::npos;
+template <typename T>
+constexpr std::size_t transform_hierarchy<T>::parallel_chunk;
+
+typedef transform_hierarchy<float> transform_hierarchyf;
+
+GB_PHYSICS_NS_END
@@ -1,4 +1,5 @@
 #include "sptree.h"
+#include "roaring.h"
 #include "math.h"
 
 #include <vector>
@@ -14,31 +15,75 @@ namespace gb
 	{
 	    std::vector<T> contour;
 
-	    for(std::uint32_t i = 0; i < height; i++)
+	    // only visit set pixels, empty space is skipped a word(64 pixels) at a time
+	    const std::size_t total = (std::size_t)width * height;
+	    for(std::size_t idx = img.find_next(0); idx < total; idx = img.find_next(idx + 1))
 	    {
-		for(std::uint32_t j = 0; j < width; j++)
+		const std::uint32_t i = (std::uint32_t)(idx / width);
+		const std::uint32_t j = (std::uint32_t)(idx % width);
+
+		if( i == 0 || i == (height - 1) || j == 0 || j == (width - 1))
+		    contour.push_back(T(j, i));
+		else
 		{
-		    if(img[i * width + j] != 0)
-		    {
-			if( i == 0 || i == (height - 1) || j == 0 || j == (width - 1))
-			    contour.push_back(T(j, i));
-			else if(img[i * width + j - 1] == 0//left
-				|| img[(i - 1) * width + j - 1] == 0//left top
-				|| img[(i - 1) * width + j] == 0//top
-				|| img[(i - 1) * width + j + 1] == 0 //right top
-				|| img[i * width + j + 1] == 0//right
-				|| img[(i + 1) * width + j + 1] == 0//right bottom
-				|| img[(i + 1) * width + j] == 0//bottom
-				|| img[(i + 1) * width + j - 1] == 0//left bottom
-			    )
-			    contour.push_back(T(j, i));
-		    }
+		    const std::size_t up = idx - width;
+		    const std::size_t down = idx + width;
+		    if(!img.test(idx - 1)//left
+		       || !img.test(up - 1)//left top
+		       || !img.test(up)//top
+		       || !img.test(up + 1) //right top
+		       || !img.test(idx + 1)//right
+		       || !img.test(down + 1)//right bottom
+		       || !img.test(down)//bottom
+		       || !img.test(down - 1)//left bottom
+			)
+			contour.push_back(T(j, i));
 		}
 	    }
 	    return contour;
 	}
 
 
+	/*
+	 *@brief, same as above, empty runs cost nothing, and a pixel
+	 inside a run already has both left and right neighbours set.
+	 */
+	template<typename T>
+	std::vector<T> binary_img_contour(const roaring_bit_vector& img, const std::uint32_t width, const std::uint32_t height)
+	{
+	    std::vector<T> contour;
+
+	    const std::size_t total = (std::size_t)width * height;
+	    img.for_each_run([&](const std::size_t beginIdx, const std::size_t size)
+			     {
+				 const std::size_t lastIdx = beginIdx + size - 1;
+				 const std::size_t endIdx = std::min(lastIdx + 1, total);
+				 for(std::size_t idx = beginIdx; idx < endIdx; idx++)
+				 {
+				     const std::uint32_t i = (std::uint32_t)(idx / width);
+				     const std::uint32_t j = (std::uint32_t)(idx % width);
+
+				     if( i == 0 || i == (height - 1) || j == 0 || j == (width - 1)
+					 || idx == beginIdx || idx == lastIdx)//left or right is not set
+					 contour.push_back(T(j, i));
+				     else
+				     {
+					 const std::size_t up = idx - width;
+					 const std::size_t down = idx + width;
+					 if(!img.test(up - 1)//left top
+					    || !img.test(up)//top
+					    || !img.test(up + 1) //right top
+					    || !img.test(down + 1)//right bottom
+					    || !img.test(down)//bottom
+					    || !img.test(down - 1)//left bottom
+					     )
+					     contour.push_back(T(j, i));
+				     }
+				 }
+			     });
+	    return contour;
+	}
+
 	array_2d<std::uint8_t> signed_distance_field(const bit_vector& img,
 						     const std::uint32_t width,
 						     const std::uint32_t height,
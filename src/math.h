@@ -8,6 +8,16 @@
 
 #define GB_MATH_PI 3.141592f
 
+// whether builtin is_constant_evaluated is there, lets constexpr code keep a fast run time path
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define GB_MATH_HAS_CONSTANT_EVALUATED
+#endif
+#endif
+#if !defined(GB_MATH_HAS_CONSTANT_EVALUATED) && ((defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define GB_MATH_HAS_CONSTANT_EVALUATED
+#endif
+
 namespace gb
 {
     namespace number_conversion
@@ -139,11 +149,71 @@ namespace gb
 	    double _scale;
 	};
 
-	inline float degree2radian(float degree)
+	constexpr float degree2radian(float degree)
 	{
 	    return GB_MATH_PI * (degree / 180.0f);
 	}
 
+	// |radian| <= pi / 2, Taylor series up to x^23, error < 1e-16
+	constexpr double _constSinReduced(const double radian)
+	{
+	    const double x2 = radian * radian;
+	    double term = radian;
+	    double ret = radian;
+	    for(int n = 1; n < 12; n++)
+	    {
+		term *= -x2 / ((2 * n) * (2 * n + 1));
+		ret += term;
+	    }
+	    return ret;
+	}
+
+	/*
+	  sin/cos usable in constant expressions(std::sin isn't constexpr),
+	  so builders of constant transforms fold at compile time.
+	  radian is reduced to [-pi / 2, pi / 2] first, it must fit in a long long turns count.
+	 */
+	constexpr double constSin(double radian)
+	{
+	    const double pi = 3.14159265358979323846;
+	    const double turns = radian / (2 * pi);
+	    const long long n = (long long)(turns + (turns >= 0 ? 0.5 : -0.5));
+	    radian -= (double)n * (2 * pi);
+	    if(radian > pi / 2)
+		radian = pi - radian;
+	    else if(radian < -pi / 2)
+		radian = -pi - radian;
+	    return _constSinReduced(radian);
+	}
+
+	constexpr double constCos(const double radian)
+	{
+	    return constSin(radian + 3.14159265358979323846 / 2);
+	}
+
+	/*
+	  sin/cos of a float radian for the constexpr builders: folded through constSin/constCos
+	  when constant evaluated, std::sin/std::cos(float) at run time.
+	  without the builtin(older compilers) constSin/constCos are used in both cases.
+	 */
+	constexpr float foldableSin(const float radian)
+	{
+#ifdef GB_MATH_HAS_CONSTANT_EVALUATED
+	    if(!__builtin_is_constant_evaluated())
+		return std::sin(radian);
+#endif
+	    return (float)constSin(radian);
+	}
+
+	constexpr float foldableCos(const float radian)
+	{
+#ifdef GB_MATH_HAS_CONSTANT_EVALUATED
+	    if(!__builtin_is_constant_evaluated())
+		return std::cos(radian);
+#endif
+	    return (float)constCos(radian);
+	}
+
 	template <typename T>
 	struct quadratic_equation
 	{
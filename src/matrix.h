@@ -2,11 +2,11 @@
 
 #include "type.h"
 #include "math.h"
+#include "parallel.h"
 #include <utility>
-#include <functional>
+#include <limits>
 
 #include "Eigen/Dense"
-#include "Eigen/Eigenvalues"
 /*
   COLUMN MAJOR ORDER
 
@@ -90,7 +90,7 @@ struct mat3
 {
     typedef vec3<T> col_type;
     col_type value[3];
-    static mat3 make_identity()
+    static constexpr mat3 make_identity()
 	{
 	    return mat3{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
 	}
@@ -219,134 +219,10 @@ struct mat3
 	return ret;
     }
 
-    mat3 eigenvectors() const
-	{
-	    /*
-	      TODO qr algorithm with shifts ref@http://people.inf.ethz.ch/arbenz/ewp/Lnotes/chapter4.pdf
-
-	      basic QR algorithm ref@https://en.wikipedia.org/wiki/QR_decomposition
-	      A = Q * R, Q is othogonal matrix, R is upper triangluar matrix
-	      let, Ak = Qk * Rk
-	      then form Ak+1 = Rk * Qk = Qk(-1) * Qk * Rk * Qk = Qk(-1) * Ak * Qk
-	      so, Ak+1 is similar to Ak
-	      keep iterating until Ak is converged to a triangluar matrix
-
-	      1st. decomposite A with Q and R
-	      2nd. iterating
-
-	      qr_decomposition(Using Householder reflection):
-					    |
-	       	       	       	       	X1 /|
-				          / |
-				         /  |
-	       	       	       	        o---+----------
-					 \  |
-				       X1'\ |
-					   \|
-					    |V
-		       +--+--+--+--+--...------+
-		       |X'+--+  |  |           .
-		       |1 |  |  |  |	       .
-		       |  |X'+--+  |   	       .
-		       |  |2 |  |  | 	       |
-		       |  |  |X'+--+--...------+
-		       |  |  |3 |X'| 	       |
-		       |  |  |	|4 | 	   +---+
-		       |  |  |	|  |   	   |X'n|
-
-              Xi is ith column of A
-	      X1'(|X1|* e1) is X1's reflection about the plane which orthogonal with Vector V(Unit vector)
-	      e1 is (1, 0, 0..., 0), e2 is (1, 0, 0... 0), en is (1)
-		     |		 |	    |	       |	  |
-		     +----n------+	    +----n-1---+	  1
-
-	      let Xi be the column of A, if Xi' is transformed to be the basis of the A, then
-	      A is transformed to be a triangular matrix.
-
-	      let X1' = |X1|e1, I is identity matrix, and V is point to X1,
-	      then V = (-X1' + X1)/|V| = (X1 - sign(-X1[1])*|X1|e1)/|V|
-	      NOTE!!!: sign(-X1[1]) is for avoding X1 - X1' cancellation
-
-	      X1' = X1 - 2 * cos<X1, V> * |X1| * V
-	          = X1 - 2 * (X1 dot V / |X1||V|) * |X1| * V
-		  = X1 - 2 * (X1 dot V) * V / |V| (V is unit vecotr, so |V| is 1)
-		  = X1 - V * 2(X1 dot V) (convert to matrix multiply)
-		  = X1 - V . 2(Vt . X1) = I . X1 - 2 . V . Vt . X1 = (I - 2.V.Vt) . X1
-
-	      let H = I - 2VVt,
-              then X1' = H1 . X1
-	      ...
-
-	      eventually Hn ... H3.H2.H1 . A = R(triangluar matrix)
-	      ...
-	      A = H1(-1).H2(-1).H3(-1)...Hn(-1) . R
-	      let Q = H1(-1)H2(-1)H3(-1)...Hn(-1)
-	      because Hn is othogonal matrix
-	      then
-	      Q = H1tH2t...Hnt
-
-	    */
-
-	    bool bSymmetric = (value[0][1] == value[1][0] && value[0][2] == value[2][0] && value[1][2] && value[2][1]);
-
-	    std::function<void(const mat3<T>&, mat3<T>&, mat3<T>&)> qr_decomposition = [](const mat3<T>& A, mat3<T>& Q, mat3<T>& R)
-		{
-		    // 1st col
-		    mat3<T> H1 = mat3<T>::make_identity();
-
-		    const vec3<T>& col1 = A[0];
-		    if(col1[1] != 0 || col1[2] != 0)
-			{
-			    const vec3<T> e1{1, 0, 0};
-			    vec3<T> V = col1 - e1 * (col1.magnitude()) * sign(-col1[0]);
-			    V = V / V.magnitude();
-
-			    H1 = mat3<T>::make_identity() -= vec3ColMultiplyRow(V, V) *= 2;
-			}
-
-		    // 2nd col
-		    const mat3<T> A_prime = H1 * A; //H2 . (H1 . A) = R !!!
-
-		    mat3<T> H2 = mat3<T>::make_identity();
-
-		    const vec2<T> col2{A_prime[1][1], A_prime[1][2]};
-		    if(col2[1] != 0)
-			{
-			    const vec2<T> e2{1, 0};
-			    vec2<T> V = col2 - e2 * (col2.magnitude()) * sign(-col2[0]);
-			    V = V / V.magnitude();
-
-			    mat2<T> h2 = mat2<T>::make_identity() -= vec2ColMultiplyRow(V, V) *= 2;
-
-			    H2[1][1] = h2[0][0];
-			    H2[1][2] = h2[0][1];
-			    H2[2][1] = h2[1][0];
-			    H2[2][2] = h2[1][1];
-			}
-
-		    R = H2 * A_prime;	// R = H2 . H1 . A = H2 . A'
-		    Q = H1.transpose() * H2.transpose();
-		};
-
-	    mat3<T> A = *this;
-	    mat3<T> ret = mat3<T>::make_identity();
-	    mat3<T> Q, R;
-	    while(A[0][1] != 0 || A[0][2] != 0 || A[1][2] != 0)
-		{
-		    qr_decomposition(A, Q, R);
-		    A = R * Q;
-		    if(bSymmetric)
-			ret *= Q;
-		}
-
-	    if(!bSymmetric)
-		{
-		    // TODO
-		}
-	    return ret;
-	}
+    // columns are the unit eigenvectors of the symmetric *this, by decreasing eigenvalue, see eigenSym3
+    mat3 eigenvectors() const;
 
-    //Eigen adapter
+    //Eigen adapter, copies(eigen_map.h has zero copy views)
     operator Eigen::Matrix<T, 3, 3> () const
 	{
 	    Eigen::Matrix<T, 3, 3> ret;
@@ -354,11 +230,12 @@ struct mat3
 	    return ret;
 	}
 
-    mat3(const Eigen::Matrix<T, 3, 3> & em)
+    static mat3 from_eigen(const Eigen::Matrix<T, 3, 3> & em)
 	{
-	    std::memcpy(value, em.data(), 3 * 3 * sizeof(T));
+	    mat3 ret;
+	    std::memcpy(ret.value, em.data(), 3 * 3 * sizeof(T));
+	    return ret;
 	}
-    mat3(){}
 };
 
 template <typename T>
@@ -372,28 +249,417 @@ mat3<T> vec3ColMultiplyRow(const vec3<T>& col, const vec3<T>& row)
     return ret;
 }
 
+/*
+ *@brief, eigen decomposition of a symmetric 3x3 matrix(only the upper triangle is read),
+ values in decreasing order, vectors[i] is the unit eigenvector of values[i], vectors is a right handed rotation.
+
+ closed form first: eigenvalues from the trigonometric solution of the characteristic cubic,
+ eigenvectors of the largest and the smallest from cross products of the rows of(A - lambda * I).
+ that loses precision when two eigenvalues(nearly) coincide, then cyclic Jacobi rotations take over,
+ at most eigen_sym3_max_sweeps sweeps.
+ returns false if Jacobi didn't converge in time(the result is still the best estimate).
+ ref: https://en.wikipedia.org/wiki/Eigenvalue_algorithm#3%C3%973_matrices
+      https://arxiv.org/abs/physics/0610206
+ */
+static constexpr std::uint8_t eigen_sym3_max_sweeps = 32;
+
+namespace detail
+{
+    template<typename T>
+    void sortEigenSym3(vec3<T>& values, mat3<T>& vectors)
+    {
+	for(std::uint8_t i = 0; i < 2; i++)
+	{
+	    std::uint8_t maxIdx = i;
+	    for(std::uint8_t j = i + 1; j < 3; j++)
+	    {
+		if(values[j] > values[maxIdx])
+		    maxIdx = j;
+	    }
+	    if(maxIdx != i)
+	    {
+		std::swap(values[i], values[maxIdx]);
+		std::swap(vectors[i], vectors[maxIdx]);
+	    }
+	}
+	if(dot(cross(vectors[0], vectors[1]), vectors[2]) < 0)
+	    vectors[2] = -vectors[2];
+    }
+
+    template<typename T>
+    bool jacobiSym3(const mat3<T>& m, vec3<T>& values, mat3<T>& vectors)
+    {
+	T a[3][3];
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    for(std::uint8_t r = 0; r <= c; r++)
+		a[r][c] = a[c][r] = m[c][r];
+	}
+	vectors = mat3<T>::make_identity();
+
+	bool bConverged = false;
+	for(std::uint8_t sweep = 0; sweep < eigen_sym3_max_sweeps; sweep++)
+	{
+	    const T off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+	    const T diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+	    if(off <= std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon() * diag || off == 0)
+	    {
+		bConverged = true;
+		break;
+	    }
+
+	    for(std::uint8_t p = 0; p < 2; p++)
+	    {
+		for(std::uint8_t q = p + 1; q < 3; q++)
+		{
+		    if(a[p][q] == 0)
+			continue;
+		    // rotation zeroing a[p][q]
+		    const T theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+		    const T t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+		    const T c = 1 / std::sqrt(t * t + 1);
+		    const T s = t * c;
+
+		    a[p][p] -= t * a[p][q];
+		    a[q][q] += t * a[p][q];
+		    a[p][q] = a[q][p] = 0;
+		    const std::uint8_t k = 3 - p - q;
+		    const T akp = a[k][p];
+		    const T akq = a[k][q];
+		    a[k][p] = a[p][k] = c * akp - s * akq;
+		    a[k][q] = a[q][k] = s * akp + c * akq;
+
+		    for(std::uint8_t r = 0; r < 3; r++)
+		    {
+			const T vp = vectors[p][r];
+			const T vq = vectors[q][r];
+			vectors[p][r] = c * vp - s * vq;
+			vectors[q][r] = s * vp + c * vq;
+		    }
+		}
+	    }
+	}
+
+	values = vec3<T>(a[0][0], a[1][1], a[2][2]);
+	sortEigenSym3(values, vectors);
+	return bConverged;
+    }
+
+    // the null direction of the rank 2 matrix(A - lambda * I), false if it isn't clearly rank 2
+    template<typename T>
+    bool eigenvectorSym3(const mat3<T>& m, const T lambda, const T tolerance, vec3<T>& out)
+    {
+	const vec3<T> r0(m[0][0] - lambda, m[1][0], m[2][0]);
+	const vec3<T> r1(m[1][0], m[1][1] - lambda, m[2][1]);
+	const vec3<T> r2(m[2][0], m[2][1], m[2][2] - lambda);
+	const vec3<T> c[3] = {cross(r0, r1), cross(r0, r2), cross(r1, r2)};
+	std::uint8_t best = 0;
+	T bestSq = c[0].sqMagnitude();
+	for(std::uint8_t i = 1; i < 3; i++)
+	{
+	    const T sq = c[i].sqMagnitude();
+	    if(sq > bestSq)
+	    {
+		best = i;
+		bestSq = sq;
+	    }
+	}
+	if(!(bestSq > tolerance))
+	    return false;
+	out = c[best] / std::sqrt(bestSq);
+	return true;
+    }
+}
 
 template<typename T>
-mat3<T> covarianceMat3(const vec3<T>* data, const std::size_t count)
+bool eigenSym3(const mat3<T>& m, vec3<T>& values, mat3<T>& vectors)
 {
-    vec3<T> mean = meanVec3<T>(data, count);
+    // upper triangle, mirrored
+    mat3<T> a;
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	for(std::uint8_t r = 0; r <= c; r++)
+	    a[c][r] = a[r][c] = m[c][r];
+    }
 
-    /*
-       C = E((P - E(P))(P - E(P))_T)
-       C = SUM((P - E(P))(P - E(P))_T) / count
-    */
+    const T p1 = a[1][0] * a[1][0] + a[2][0] * a[2][0] + a[2][1] * a[2][1];
+    if(p1 == 0)
+    {
+	// already diagonal
+	values = vec3<T>(a[0][0], a[1][1], a[2][2]);
+	vectors = mat3<T>::make_identity();
+	detail::sortEigenSym3(values, vectors);
+	return true;
+    }
 
+    const T q = (a[0][0] + a[1][1] + a[2][2]) / 3;
+    const T d0 = a[0][0] - q, d1 = a[1][1] - q, d2 = a[2][2] - q;
+    const T p = std::sqrt((d0 * d0 + d1 * d1 + d2 * d2 + 2 * p1) / 6);
+    // det((A - qI) / p) / 2
+    T r = (d0 * (d1 * d2 - a[2][1] * a[2][1])
+	   - a[1][0] * (a[1][0] * d2 - a[2][1] * a[2][0])
+	   + a[2][0] * (a[1][0] * a[2][1] - d1 * a[2][0])) / (2 * p * p * p);
+    r = r < -1 ? -1 : (r > 1 ? 1 : r);
+    const T phi = std::acos(r) / 3;
+    const T twoThirdsPi = (T)2.0943951023931954923;
+    const T e0 = q + 2 * p * std::cos(phi);
+    const T e2 = q + 2 * p * std::cos(phi + twoThirdsPi);
+    const T e1 = 3 * q - e0 - e2;
+
+    // eigenvalues closer than this(relative to the spread p) make the cross products unreliable
+    const T gapTolerance = std::sqrt(std::numeric_limits<T>::epsilon()) * 16;
+    vec3<T> v0, v2;
+    if(e0 - e1 < gapTolerance * p || e1 - e2 < gapTolerance * p
+       || !detail::eigenvectorSym3(a, e0, gapTolerance * gapTolerance * p * p * p * p, v0)
+       || !detail::eigenvectorSym3(a, e2, gapTolerance * gapTolerance * p * p * p * p, v2))
+	return detail::jacobiSym3(a, values, vectors);
+
+    // orthogonalize against the largest and complete the basis
+    v2 = (v2 - v0 * dot(v0, v2)).normalize();
+    values = vec3<T>(e0, e1, e2);
+    vectors[0] = v0;
+    vectors[1] = cross(v2, v0);
+    vectors[2] = v2;
+    return true;
+}
+
+// Float compares fuzzily, solve in float
+inline bool eigenSym3(const mat3<Float>& m, vec3<Float>& values, mat3<Float>& vectors)
+{
+    mat3<float> mf;
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	for(std::uint8_t r = 0; r < 3; r++)
+	    mf[c][r] = m[c][r];
+    }
+    vec3<float> vf;
+    mat3<float> ef;
+    const bool ret = eigenSym3(mf, vf, ef);
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	values[c] = vf[c];
+	for(std::uint8_t r = 0; r < 3; r++)
+	    vectors[c][r] = ef[c][r];
+    }
+    return ret;
+}
+
+// batch form, values and vectors hold count elements, returns false if any matrix fell short of converging
+template<typename T>
+bool eigenSym3(const mat3<T>* m, const std::size_t count, vec3<T>* values, mat3<T>* vectors, const bool bParallel = false)
+{
+    assert((m != nullptr && values != nullptr && vectors != nullptr) || count == 0);
+    auto body = [m, values, vectors](const std::size_t begin, const std::size_t end)
+	{
+	    bool ret = true;
+	    for(std::size_t i = begin; i < end; i++)
+		ret = eigenSym3(m[i], values[i], vectors[i]) && ret;
+	    return ret;
+	};
+    if(!bParallel)
+	return body(0, count);
+    return parallelReduce(count, 4096, true, body,
+			  [](bool& into, const bool partial)
+			  {
+			      into = into && partial;
+			  });
+}
+
+template <typename T>
+mat3<T> mat3<T>::eigenvectors() const
+{
+    vec3<T> values;
     mat3<T> ret;
+    eigenSym3(*this, values, ret);
+    return ret;
+}
+
+
+/*
+ *@brief, running first and second moments of a point set,
+ mean and the sums of centered products(m2: xx, yy, zz, xy, xz, yz).
+ partial moments of disjoint sets merge exactly(Chan et al.),
+ so chunks can be reduced independently and combined at the end.
+ ref: https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm
+ */
+template<typename T>
+struct point_moments
+{
+    point_moments() :
+	count(0),
+	m2{0, 0, 0, 0, 0, 0}
+	{}
+
+    void merge(const point_moments& o)
+	{
+	    if(o.count == 0)
+		return;
+	    if(count == 0)
+	    {
+		*this = o;
+		return;
+	    }
+
+	    const T n = T(count + o.count);
+	    const vec3<T> delta = o.mean - mean;
+	    // weight of the cross term, na * nb / n
+	    const T w = T(count) * T(o.count) / n;
+
+	    mean += delta * (T(o.count) / n);
+	    m2[0] += o.m2[0] + delta.x * delta.x * w;
+	    m2[1] += o.m2[1] + delta.y * delta.y * w;
+	    m2[2] += o.m2[2] + delta.z * delta.z * w;
+	    m2[3] += o.m2[3] + delta.x * delta.y * w;
+	    m2[4] += o.m2[4] + delta.x * delta.z * w;
+	    m2[5] += o.m2[5] + delta.y * delta.z * w;
+	    count += o.count;
+	}
+
+    // population covariance, SUM((P - E(P))(P - E(P))_T) / count
+    mat3<T> covariance() const
+	{
+	    mat3<T> ret;
+	    if(count == 0)
+		return ret;
+	    const T n = T(count);
+	    ret[0] = vec3<T>(m2[0], m2[3], m2[4]) / n;
+	    ret[1] = vec3<T>(m2[3], m2[1], m2[5]) / n;
+	    ret[2] = vec3<T>(m2[4], m2[5], m2[2]) / n;
+	    return ret;
+	}
+
+    std::size_t count;
+    vec3<T> mean;
+    T m2[6];
+};
+
+/*
+ *@brief, moments of a cache sized block, mean first then the centered products,
+ the second walk hits L1 so memory is still read once.
+ */
+template<typename T>
+point_moments<T> momentsBlock(const vec3<T>* data, const std::size_t count)
+{
+    point_moments<T> ret;
+    if(count == 0)
+	return ret;
+
+    vec3<T> sum;
+    for(std::size_t i = 0; i < count; i++)
+	sum += data[i];
+    ret.count = count;
+    ret.mean = sum / T(count);
 
-    vec3<T> p_ep;
     for(std::size_t i = 0; i < count; i++)
     {
-	p_ep = data[i] - mean;
-	ret += (vec3ColMultiplyRow(p_ep, p_ep) / count);
+	const vec3<T> d = data[i] - ret.mean;
+	ret.m2[0] += d.x * d.x;
+	ret.m2[1] += d.y * d.y;
+	ret.m2[2] += d.z * d.z;
+	ret.m2[3] += d.x * d.y;
+	ret.m2[4] += d.x * d.z;
+	ret.m2[5] += d.y * d.z;
     }
+    return ret;
+}
 
+#if defined(GB_PHYSICS_SSE)
+template<>
+inline point_moments<float> momentsBlock<float>(const vec3<float>* data, const std::size_t count)
+{
+    point_moments<float> ret;
+    if(count == 0)
+	return ret;
+
+    const float* p = data->data();
+    const std::size_t simdCount = count & ~std::size_t(3);
+
+    __m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+    for(std::size_t i = 0; i < simdCount; i += 4)
+    {
+	__m128 x, y, z;
+	loadSoA4(p + i * 3, x, y, z);
+	sx = _mm_add_ps(sx, x);
+	sy = _mm_add_ps(sy, y);
+	sz = _mm_add_ps(sz, z);
+    }
+    vec3<float> sum(hsum4(sx), hsum4(sy), hsum4(sz));
+    for(std::size_t i = simdCount; i < count; i++)
+	sum += data[i];
+    ret.count = count;
+    ret.mean = sum / float(count);
+
+    const __m128 mx = _mm_set1_ps(ret.mean.x), my = _mm_set1_ps(ret.mean.y), mz = _mm_set1_ps(ret.mean.z);
+    __m128 xx = _mm_setzero_ps(), yy = _mm_setzero_ps(), zz = _mm_setzero_ps();
+    __m128 xy = _mm_setzero_ps(), xz = _mm_setzero_ps(), yz = _mm_setzero_ps();
+    for(std::size_t i = 0; i < simdCount; i += 4)
+    {
+	__m128 x, y, z;
+	loadSoA4(p + i * 3, x, y, z);
+	x = _mm_sub_ps(x, mx);
+	y = _mm_sub_ps(y, my);
+	z = _mm_sub_ps(z, mz);
+	xx = _mm_add_ps(xx, _mm_mul_ps(x, x));
+	yy = _mm_add_ps(yy, _mm_mul_ps(y, y));
+	zz = _mm_add_ps(zz, _mm_mul_ps(z, z));
+	xy = _mm_add_ps(xy, _mm_mul_ps(x, y));
+	xz = _mm_add_ps(xz, _mm_mul_ps(x, z));
+	yz = _mm_add_ps(yz, _mm_mul_ps(y, z));
+    }
+    ret.m2[0] = hsum4(xx);
+    ret.m2[1] = hsum4(yy);
+    ret.m2[2] = hsum4(zz);
+    ret.m2[3] = hsum4(xy);
+    ret.m2[4] = hsum4(xz);
+    ret.m2[5] = hsum4(yz);
+    for(std::size_t i = simdCount; i < count; i++)
+    {
+	const vec3<float> d = data[i] - ret.mean;
+	ret.m2[0] += d.x * d.x;
+	ret.m2[1] += d.y * d.y;
+	ret.m2[2] += d.z * d.z;
+	ret.m2[3] += d.x * d.y;
+	ret.m2[4] += d.x * d.z;
+	ret.m2[5] += d.y * d.z;
+    }
     return ret;
 }
+#endif
+
+/*
+ *@brief, mean and covariance moments in one pass over memory,
+ blocks are reduced two pass in cache, then merged, chunks run on separate threads.
+ */
+template<typename T>
+point_moments<T> momentsVec3(const vec3<T>* data, const std::size_t count)
+{
+    // points per in-cache block and per thread at least
+    const std::size_t blockSize = 1024;
+    const std::size_t minChunk = 64 * 1024;
+
+    return parallelReduce(count, minChunk, point_moments<T>(),
+			  [data, blockSize](const std::size_t begin, const std::size_t end)
+			  {
+			      point_moments<T> ret;
+			      for(std::size_t b = begin; b < end; b += blockSize)
+				  ret.merge(momentsBlock<T>(data + b, end - b < blockSize ? end - b : blockSize));
+			      return ret;
+			  },
+			  [](point_moments<T>& into, const point_moments<T>& partial)
+			  {
+			      into.merge(partial);
+			  });
+}
+
+template<typename T>
+mat3<T> covarianceMat3(const vec3<T>* data, const std::size_t count)
+{
+    /*
+       C = E((P - E(P))(P - E(P))_T)
+       C = SUM((P - E(P))(P - E(P))_T) / count
+    */
+    return momentsVec3<T>(data, count).covariance();
+}
 
 template <typename T>
 mat3<T> naturalAxes(const vec3<T>* data, const std::size_t count)
@@ -431,11 +697,8 @@ mat3<T> naturalAxes(const vec3<T>* data, const std::size_t count)
       then the problem turns out to find eigenvectors of C
     */
 
-    // covariance matrix
-    Eigen::Matrix<T, 3, 3> covM = covarianceMat3<T>(data, count);
-    Eigen::EigenSolver<Eigen::Matrix<T, 3, 3>> solver(covM, true);
-    // eigenvector
-    return solver.eigenvectors().real();
+    // eigenvectors of the covariance matrix, the primary axis first
+    return covarianceMat3<T>(data, count).eigenvectors();
 }
 
 template <typename T>
@@ -443,7 +706,7 @@ struct mat4
 {
     typedef vec4<T> col_type;
     col_type value[4];
-    static mat4 make_identity()
+    static constexpr mat4 make_identity()
 	{
 	    return mat4{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
 	}
@@ -471,7 +734,7 @@ struct mat4
     template < typename S>
     typename std::enable_if<std::is_scalar<S>::value, mat4>::type operator * (const S scalar) const
     {
-	return mat4{{value[0] * scalar}, {value[1] * scalar}, {value[2] * scalar}, {value[3] * scalar}};
+	return mat4{{value[0] * scalar, value[1] * scalar, value[2] * scalar, value[3] * scalar}};
     }
     void operator *= (const mat4 & o)
     {
@@ -675,81 +938,357 @@ struct mat4
     }
 };
 
-typedef mat4<float> mat4f;
-
-template <typename T>
-mat4<T> scaleMat(const vec3<T>& scale)
+#if defined(GB_PHYSICS_SSE)
+/*
+  mat4<float> columns are vec4<float>, each one a __m128,
+  so A * v is 4 broadcasts + 4 muls + 3 adds
+*/
+template <>
+inline vec4<float> mat4<float>::operator * (const vec4<float> & v) const
 {
-    mat4<T> ret = mat4<T>::make_identity();
+    const __m128 vm = v.m;
+    __m128 ret = _mm_mul_ps(value[0].m, _mm_shuffle_ps(vm, vm, _MM_SHUFFLE(0, 0, 0, 0)));
+    ret = _mm_add_ps(ret, _mm_mul_ps(value[1].m, _mm_shuffle_ps(vm, vm, _MM_SHUFFLE(1, 1, 1, 1))));
+    ret = _mm_add_ps(ret, _mm_mul_ps(value[2].m, _mm_shuffle_ps(vm, vm, _MM_SHUFFLE(2, 2, 2, 2))));
+    ret = _mm_add_ps(ret, _mm_mul_ps(value[3].m, _mm_shuffle_ps(vm, vm, _MM_SHUFFLE(3, 3, 3, 3))));
+    return ret;
+}
 
-    ret[0][0] = scale[0];
-    ret[1][1] = scale[1];
-    ret[2][2] = scale[2];
+// sse only, the header is shared by units built with different -m flags
+template <>
+inline mat4<float> mat4<float>::operator * (const mat4<float> & o) const
+{
+    mat4<float> ret;
+    ret.value[0] = operator*(o.value[0]);
+    ret.value[1] = operator*(o.value[1]);
+    ret.value[2] = operator*(o.value[2]);
+    ret.value[3] = operator*(o.value[3]);
+    return ret;
+}
 
+template <>
+inline mat4<float> mat4<float>::transpose() const
+{
+    __m128 c0 = value[0].m, c1 = value[1].m, c2 = value[2].m, c3 = value[3].m;
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    mat4<float> ret;
+    ret.value[0].m = c0;
+    ret.value[1].m = c1;
+    ret.value[2].m = c2;
+    ret.value[3].m = c3;
     return ret;
 }
 
-template <typename T>
-mat4<T> rotateXAxisMat(const float degree)
+/*
+  Cramer's rule in registers, after Intel's "Streaming SIMD Extensions - Inverse of 4x4 Matrix"(AP-928).
+  the matrix is loaded transposed with rows 1 and 3 half swapped, so that every 2x2 sub-determinant
+  product comes out of one mul + shuffle, the cofactors(minor0..3) then land in the output order.
+  storage order is the same for input and output, so it holds for column major too.
+*/
+namespace detail
 {
-    mat4<T> ret = mat4<T>::make_identity();
-    float radian = gb::math::degree2radian(degree);
+    struct mat4_cramer
+    {
+	explicit mat4_cramer(const mat4<float>& m)
+	    {
+		const __m128 t0 = _mm_movelh_ps(m.value[0].m, m.value[1].m);// s0 s1 s4 s5
+		const __m128 t1 = _mm_movelh_ps(m.value[2].m, m.value[3].m);// s8 s9 s12 s13
+		row0 = _mm_shuffle_ps(t0, t1, 0x88);// s0 s4 s8 s12
+		row1 = _mm_shuffle_ps(t1, t0, 0xDD);// s9 s13 s1 s5
+		const __m128 t2 = _mm_movehl_ps(m.value[1].m, m.value[0].m);// s2 s3 s6 s7
+		const __m128 t3 = _mm_movehl_ps(m.value[3].m, m.value[2].m);// s10 s11 s14 s15
+		row2 = _mm_shuffle_ps(t2, t3, 0x88);// s2 s6 s10 s14
+		row3 = _mm_shuffle_ps(t3, t2, 0xDD);// s11 s15 s3 s7
+	    }
 
-    T sin = std::sin(radian);
-    T cos = std::cos(radian);
+	// first cofactor row, enough for the determinant
+	void cofactors0()
+	    {
+		__m128 tmp = _mm_mul_ps(row2, row3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor0 = _mm_mul_ps(row1, tmp);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp), minor0);
+
+		tmp = _mm_mul_ps(row1, row2);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor0);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp));
+
+		tmp = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		const __m128 row2s = _mm_shuffle_ps(row2, row2, 0x4E);
+		minor0 = _mm_add_ps(_mm_mul_ps(row2s, tmp), minor0);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2s, tmp));
+	    }
 
-    ret[1][1] = cos;
-    ret[2][1] = -sin;
-    ret[1][2] = sin;
-    ret[2][2] = cos;
+	void cofactors()
+	    {
+		__m128 tmp = _mm_mul_ps(row2, row3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor0 = _mm_mul_ps(row1, tmp);
+		minor1 = _mm_mul_ps(row0, tmp);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp), minor0);
+		minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor1);
+		minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+		tmp = _mm_mul_ps(row1, row2);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor0);
+		minor3 = _mm_mul_ps(row0, tmp);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp));
+		minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor3);
+		minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+		tmp = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		const __m128 row2s = _mm_shuffle_ps(row2, row2, 0x4E);
+		minor0 = _mm_add_ps(_mm_mul_ps(row2s, tmp), minor0);
+		minor2 = _mm_mul_ps(row0, tmp);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2s, tmp));
+		minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor2);
+		minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+		tmp = _mm_mul_ps(row0, row1);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor2);
+		minor3 = _mm_sub_ps(_mm_mul_ps(row2s, tmp), minor3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp), minor2);
+		minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2s, tmp));
+
+		tmp = _mm_mul_ps(row0, row3);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2s, tmp));
+		minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor2);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor1 = _mm_add_ps(_mm_mul_ps(row2s, tmp), minor1);
+		minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp));
+
+		tmp = _mm_mul_ps(row0, row2s);
+		tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+		minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor1);
+		minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp));
+		tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+		minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp));
+		minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor3);
+	    }
 
-    return ret;
+	// row0 . minor0 in every lane
+	__m128 determinant() const
+	    {
+		__m128 det = _mm_mul_ps(row0, minor0);
+		det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+		return _mm_add_ps(_mm_shuffle_ps(det, det, 0xB1), det);
+	    }
+
+	__m128 row0, row1, row2, row3;
+	__m128 minor0, minor1, minor2, minor3;
+    };
 }
 
-template <typename T>
-mat4<T> rotateYAxisMat(const float degree)
+template <>
+inline float mat4<float>::determinant() const
 {
-    mat4<T> ret = mat4<T>::make_identity();
-    float radian = gb::math::degree2radian(degree);
+    detail::mat4_cramer c(*this);
+    c.cofactors0();
+    return _mm_cvtss_f32(c.determinant());
+}
 
-    T sin = std::sin(radian);
-    T cos = std::cos(radian);
+template <>
+inline bool mat4<float>::inverse(mat4<float>& out) const
+{
+    detail::mat4_cramer c(*this);
+    c.cofactors();
+    const __m128 det = c.determinant();
+    if(_mm_cvtss_f32(det) == 0)
+	return false;
+
+    const __m128 oneOverDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    out.value[0].m = _mm_mul_ps(c.minor0, oneOverDet);
+    out.value[1].m = _mm_mul_ps(c.minor1, oneOverDet);
+    out.value[2].m = _mm_mul_ps(c.minor2, oneOverDet);
+    out.value[3].m = _mm_mul_ps(c.minor3, oneOverDet);
+    return true;
+}
+#endif
 
-    ret[0][0] = cos;
-    ret[2][0] = sin;
-    ret[0][2] = -sin;
-    ret[2][2] = cos;
+typedef mat4<float> mat4f;
 
-    return ret;
+/*
+  the builders are constexpr, constant transforms fold at compile time
+  (rotations use gb::math::foldableSin/foldableCos, std::sin/std::cos at run time)
+ */
+template <typename T>
+constexpr mat4<T> scaleMat(const vec3<T>& scale)
+{
+    return mat4<T>{{{scale.x, 0, 0, 0},
+		    {0, scale.y, 0, 0},
+			{0, 0, scale.z, 0},
+			    {0, 0, 0, 1}}};
 }
 
 template <typename T>
-mat4<T> rotateZAxisMat(const float degree)
+constexpr mat4<T> rotateXAxisMat(const float degree)
 {
-    mat4<T> ret = mat4<T>::make_identity();
-    float radian = gb::math::degree2radian(degree);
+    const float radian = gb::math::degree2radian(degree);
+    const T sin = gb::math::foldableSin(radian);
+    const T cos = gb::math::foldableCos(radian);
+
+    return mat4<T>{{{1, 0, 0, 0},
+		    {0, cos, sin, 0},
+			{0, -sin, cos, 0},
+			    {0, 0, 0, 1}}};
+}
 
-    T sin = std::sin(radian);
-    T cos = std::cos(radian);
+template <typename T>
+constexpr mat4<T> rotateYAxisMat(const float degree)
+{
+    const float radian = gb::math::degree2radian(degree);
+    const T sin = gb::math::foldableSin(radian);
+    const T cos = gb::math::foldableCos(radian);
+
+    return mat4<T>{{{cos, 0, -sin, 0},
+		    {0, 1, 0, 0},
+			{sin, 0, cos, 0},
+			    {0, 0, 0, 1}}};
+}
 
-    ret[0][0] = cos;
-    ret[1][0] = -sin;
-    ret[0][1] = sin;
-    ret[1][1] = cos;
+template <typename T>
+constexpr mat4<T> rotateZAxisMat(const float degree)
+{
+    const float radian = gb::math::degree2radian(degree);
+    const T sin = gb::math::foldableSin(radian);
+    const T cos = gb::math::foldableCos(radian);
+
+    return mat4<T>{{{cos, sin, 0, 0},
+		    {-sin, cos, 0, 0},
+			{0, 0, 1, 0},
+			    {0, 0, 0, 1}}};
+}
 
-    return ret;
+template <typename T>
+constexpr mat4<T> translateMat(const vec3<T>& v)
+{
+    return mat4<T>{{{1, 0, 0, 0},
+		    {0, 1, 0, 0},
+			{0, 0, 1, 0},
+			    {v.x, v.y, v.z, 1}}};
 }
 
+/*
+  affine transform stored as 3x4, the implicit last row of mat4 is (0, 0, 0, 1).
+  value[0..2] are the linear columns, value[3] the translation, same layout as mat4.
+  compose is 36 muls(mat4: 64), inverse is a 3x3 inverse and -inv(L) * t, 25% smaller than mat4.
+ */
 template <typename T>
-mat4<T> translateMat(const vec3<T>& v)
+struct affine3
 {
-    mat4<T> ret = mat4<T>::make_identity();
+    typedef vec3<T> col_type;
+    col_type value[4];
+    static constexpr affine3 make_identity()
+	{
+	    return affine3{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 0}}};
+	}
+    // m must be affine, the last row is dropped
+    static affine3 from_mat4(const mat4<T>& m)
+	{
+	    assert(m[0][3] == 0 && m[1][3] == 0 && m[2][3] == 0 && m[3][3] == 1);
+	    return affine3{{{m[0][0], m[0][1], m[0][2]},
+			    {m[1][0], m[1][1], m[1][2]},
+				{m[2][0], m[2][1], m[2][2]},
+				    {m[3][0], m[3][1], m[3][2]}}};
+	}
+    mat4<T> to_mat4() const
+	{
+	    return mat4<T>{{{value[0][0], value[0][1], value[0][2], 0},
+			    {value[1][0], value[1][1], value[1][2], 0},
+				{value[2][0], value[2][1], value[2][2], 0},
+				    {value[3][0], value[3][1], value[3][2], 1}}};
+	}
+
+    const col_type& operator[](const std::uint8_t idx) const
+	{
+	    assert(idx <= 3);
+	    return value[idx];
+	}
+    col_type& operator[](const std::uint8_t idx)
+	{
+	    assert(idx <= 3);
+	    return value[idx];
+	}
 
-    ret[3][0] = v[0];
-    ret[3][1] = v[1];
-    ret[3][2] = v[2];
+    // m * (p, 1)
+    vec3<T> transform_point(const vec3<T>& p) const
+	{
+	    return value[0] * p[0] + value[1] * p[1] + value[2] * p[2] + value[3];
+	}
+    // m * (d, 0)
+    vec3<T> transform_direction(const vec3<T>& d) const
+	{
+	    return value[0] * d[0] + value[1] * d[1] + value[2] * d[2];
+	}
 
-    return ret;
-}
+    affine3 operator * (const affine3& o) const
+	{
+	    return affine3{{transform_direction(o[0]), transform_direction(o[1]), transform_direction(o[2]), transform_point(o[3])}};
+	}
+    void operator *= (const affine3& o)
+	{
+	    *this = (*this) * o;
+	}
+
+    T determinant() const
+	{
+	    return dot(value[0], cross(value[1], value[2]));
+	}
+
+    bool inverse(affine3& out) const
+	{
+	    // rows of inv(L) are the cross products of L's columns over det
+	    const vec3<T> r0 = cross(value[1], value[2]);
+	    const vec3<T> r1 = cross(value[2], value[0]);
+	    const vec3<T> r2 = cross(value[0], value[1]);
+	    const T det = dot(value[0], r0);
+	    if(det == 0)
+		return false;
+
+	    const T oneOverDeterminant = ((T)1) / det;
+	    out[0] = vec3<T>(r0[0], r1[0], r2[0]) * oneOverDeterminant;
+	    out[1] = vec3<T>(r0[1], r1[1], r2[1]) * oneOverDeterminant;
+	    out[2] = vec3<T>(r0[2], r1[2], r2[2]) * oneOverDeterminant;
+	    out[3] = -out.transform_direction(value[3]);
+	    return true;
+	}
+
+    /*
+     *@brief, upper bound of the largest stretch |L * v| / |v| of the linear part,
+     *so a sphere of radius r maps inside radius r * max_scale().
+     *the largest column norm falls short under shear, this takes the largest
+     *absolute row sum of L^T * L (Gershgorin), exact while the columns are
+     *orthogonal (rotation and scale) and still an upper bound otherwise.
+     */
+    T max_scale() const
+	{
+	    const T d01 = std::abs(dot(value[0], value[1]));
+	    const T d02 = std::abs(dot(value[0], value[2]));
+	    const T d12 = std::abs(dot(value[1], value[2]));
+	    T ret = value[0].sqMagnitude() + d01 + d02;
+	    const T r1 = value[1].sqMagnitude() + d01 + d12;
+	    const T r2 = value[2].sqMagnitude() + d02 + d12;
+	    if(r1 > ret)
+		ret = r1;
+	    if(r2 > ret)
+		ret = r2;
+	    return std::sqrt(ret);
+	}
+};
+
+typedef affine3<float> affine3f;
 
 GB_PHYSICS_NS_END
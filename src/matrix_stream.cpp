@@ -0,0 +1,91 @@
+#include "matrix_stream.h"
+
+using namespace gb::physics;
+
+// whole blocks go through the per isa kernels of stream_kernels.inl, see detail::mat4SingularBits for the masks
+
+std::size_t gb::physics::detail::mat4SingularBits(const std::vector<std::uint16_t>& masks, const std::size_t count, bit_vector& singular)
+{
+    singular.clear();
+    singular.insert(0, count, 0);
+    std::size_t ret = 0;
+    for(std::size_t b = 0; b < masks.size(); b++)
+    {
+	for(std::uint16_t mask = masks[b]; mask != 0; mask &= mask - 1)
+	{
+	    const std::size_t i = b * mat4_stream_lanes + ctz64(mask);
+	    assert(i < count);
+	    singular.set(i);
+	    ret++;
+	}
+    }
+    return ret;
+}
+
+std::size_t gb::physics::inverse(const mat4f_stream& in, mat4f_stream& out, bit_vector& singular, const bool bParallel)
+{
+    out.resize(in.size());
+    std::vector<std::uint16_t> masks(in.blocks());
+    const float* src = in.data();
+    float* dst = out.data();
+    std::uint16_t* m = masks.data();
+    const stream_kernels& kernels = streamKernels();
+    detail::mat4StreamRun(in.blocks(), bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      kernels.mat4_inverse(src + begin * mat4f_stream::block_size, end - begin,
+						   dst + begin * mat4f_stream::block_size, m + begin);
+			  });
+    return detail::mat4SingularBits(masks, in.size(), singular);
+}
+
+void gb::physics::determinant(const mat4f_stream& in, float* out, const bool bParallel)
+{
+    assert(out != nullptr || in.empty());
+    if(in.empty())
+	return;
+    // whole blocks of results, the tail block goes through a scratch
+    const std::size_t fullBlocks = in.size() / mat4_stream_lanes;
+    const float* src = in.data();
+    const stream_kernels& kernels = streamKernels();
+    detail::mat4StreamRun(fullBlocks, bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      kernels.mat4_determinant(src + begin * mat4f_stream::block_size, end - begin, out + begin * mat4_stream_lanes);
+			  });
+    const std::size_t tail = in.size() - fullBlocks * mat4_stream_lanes;
+    if(tail != 0)
+    {
+	alignas(GB_PHYSICS_SIMD_ALIGNMENT) float scratch[mat4_stream_lanes];
+	kernels.mat4_determinant(src + fullBlocks * mat4f_stream::block_size, 1, scratch);
+	for(std::size_t l = 0; l < tail; l++)
+	    out[fullBlocks * mat4_stream_lanes + l] = scratch[l];
+    }
+}
+
+std::size_t gb::physics::inverse(const mat4f* in, const std::size_t count, mat4f* out, bit_vector& singular, const bool bParallel)
+{
+    assert((in != nullptr && out != nullptr) || count == 0);
+    const std::size_t blocks = (count + mat4_stream_lanes - 1) / mat4_stream_lanes;
+    std::vector<std::uint16_t> masks(blocks);
+    const stream_kernels& kernels = streamKernels();
+    detail::mat4StreamRun(blocks, bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      const std::size_t first = begin * mat4_stream_lanes;
+			      const std::size_t last = end * mat4_stream_lanes < count ? end * mat4_stream_lanes : count;
+			      mat4f_stream s(in + first, last - first);
+			      kernels.mat4_inverse(s.data(), s.blocks(), s.data(), masks.data() + begin);
+			      s.store(out + first);
+			  });
+    return detail::mat4SingularBits(masks, count, singular);
+}
+
+void gb::physics::determinant(const mat4f* in, const std::size_t count, float* out, const bool bParallel)
+{
+    assert((in != nullptr && out != nullptr) || count == 0);
+    const std::size_t blocks = (count + mat4_stream_lanes - 1) / mat4_stream_lanes;
+    detail::mat4StreamRun(blocks, bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      const std::size_t first = begin * mat4_stream_lanes;
+			      const std::size_t last = end * mat4_stream_lanes < count ? end * mat4_stream_lanes : count;
+			      determinant(mat4f_stream(in + first, last - first), out + first);
+			  });
+}
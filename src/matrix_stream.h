@@ -0,0 +1,225 @@
+// mat4 batches in blocked SoA(AoSoA) layout and their bulk inverse/determinant
+
+#pragma once
+
+#include "matrix.h"
+#include "type.h"
+#include "simd.h"
+#include "parallel.h"
+#include "stream_kernels.h"
+#include <vector>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, mat4 stream in blocks of mat4_stream_lanes matrices,
+ element j(col * 4 + row) of the matrix l of a block is at block[j * mat4_stream_lanes + l],
+ so one register load gets the same element of 4, 8 or 16 matrices whatever the simd level.
+ the unused lanes of the last block hold identities.
+
+  AoS:   m0[0] m0[1] ... m0[15] m1[0] m1[1] ...
+  AoSoA: m0[0] m1[0] ... m15[0] m0[1] m1[1] ... m15[15] | m16[0] ...
+ */
+template<typename T>
+class mat4_stream
+{
+public:
+    typedef std::vector<T, aligned_allocator<T>> storage_type;
+    static constexpr std::size_t lanes = mat4_stream_lanes;
+    static constexpr std::size_t block_size = 16 * lanes;
+
+    mat4_stream():
+	_size(0)
+	{}
+    explicit mat4_stream(const std::size_t size):
+	_size(0)
+	{
+	    resize(size);
+	}
+    mat4_stream(const mat4<T>* data, const std::size_t count):
+	_size(0)
+	{
+	    assign(data, count);
+	}
+    mat4_stream(const std::vector<mat4<T>>& v):
+	_size(0)
+	{
+	    assign(v.data(), v.size());
+	}
+
+    void assign(const mat4<T>* data, const std::size_t count)
+	{
+	    assert(data != nullptr || count == 0);
+	    resize(count);
+	    for(std::size_t i = 0; i < count; i++)
+		set(i, data[i]);
+	}
+
+    // gather back to AoS, out must hold size() elements
+    void store(mat4<T>* out) const
+	{
+	    assert(out != nullptr || size() == 0);
+	    for(std::size_t i = 0; i < _size; i++)
+		out[i] = operator[](i);
+	}
+
+    std::vector<mat4<T>> to_vector() const
+	{
+	    std::vector<mat4<T>> ret(size());
+	    store(ret.data());
+	    return ret;
+	}
+    operator std::vector<mat4<T>>() const
+	{
+	    return to_vector();
+	}
+
+    // new matrices are identities
+    void resize(const std::size_t size)
+	{
+	    const std::size_t oldBlocks = blocks();
+	    _size = size;
+	    _data.resize(blocks() * block_size);
+	    for(std::size_t b = oldBlocks; b < blocks(); b++)
+	    {
+		T* block = _data.data() + b * block_size;
+		for(std::uint8_t j = 0; j < 16; j++)
+		{
+		    for(std::size_t l = 0; l < lanes; l++)
+			block[j * lanes + l] = j % 5 == 0 ? 1 : 0;
+		}
+	    }
+	    // the tail of a kept block
+	    for(std::size_t i = size; i < blocks() * lanes && i / lanes < oldBlocks; i++)
+		set_lane(i, mat4<T>::make_identity());
+	}
+    void clear()
+	{
+	    _data.clear();
+	    _size = 0;
+	}
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    std::size_t blocks() const { return (_size + lanes - 1) / lanes; }
+
+    mat4<T> operator[](const std::size_t idx) const
+	{
+	    assert(idx < size());
+	    const T* p = _data.data() + idx / lanes * block_size + idx % lanes;
+	    mat4<T> ret;
+	    for(std::uint8_t col = 0; col < 4; col++)
+	    {
+		for(std::uint8_t row = 0; row < 4; row++)
+		    ret[col][row] = p[(col * 4 + row) * lanes];
+	    }
+	    return ret;
+	}
+    void set(const std::size_t idx, const mat4<T>& m)
+	{
+	    assert(idx < size());
+	    set_lane(idx, m);
+	}
+
+    // blocks() * block_size elements
+    T* data() { return _data.data(); }
+    const T* data() const { return _data.data(); }
+private:
+    void set_lane(const std::size_t idx, const mat4<T>& m)
+	{
+	    T* p = _data.data() + idx / lanes * block_size + idx % lanes;
+	    for(std::uint8_t col = 0; col < 4; col++)
+	    {
+		for(std::uint8_t row = 0; row < 4; row++)
+		    p[(col * 4 + row) * lanes] = m[col][row];
+	    }
+	}
+
+    storage_type _data;
+    std::size_t _size;
+};
+
+template<typename T>
+constexpr std::size_t mat4_stream<T>::lanes;
+template<typename T>
+constexpr std::size_t mat4_stream<T>::block_size;
+
+typedef mat4_stream<float> mat4f_stream;
+
+// blocks per thread when bParallel
+static constexpr std::size_t mat4_stream_parallel_blocks = 256;
+
+namespace detail
+{
+    // func(beginBlock, endBlock), split across threads when bParallel
+    template<typename Func>
+    void mat4StreamRun(const std::size_t blocks, const bool bParallel, Func func)
+    {
+	if(bParallel)
+	    parallelFor(blocks, mat4_stream_parallel_blocks, func);
+	else
+	    func(std::size_t(0), blocks);
+    }
+
+    /*
+     *@brief, one singular mask per block(bit l for lane l), so threads never share a bit_vector word,
+     singular is filled from them afterwards on the calling thread.
+     *@return, the number of set bits
+     */
+    std::size_t mat4SingularBits(const std::vector<std::uint16_t>& masks, const std::size_t count, bit_vector& singular);
+}
+
+/*
+ *@brief, out[i] = inverse(in[i]), out may be in.
+ singular gets size() bits, bit i set when in[i] has a zero determinant(out[i] is then undefined).
+ float runs the dispatched stream kernels(see cpu.h): a lane group whose matrices are all affine
+ takes the 3x3 + translation path, others the general 2x2 minors expansion.
+ bParallel splits the blocks across threads.
+ *@return, the number of singular matrices
+ */
+template<typename T>
+std::size_t inverse(const mat4_stream<T>& in, mat4_stream<T>& out, bit_vector& singular, const bool bParallel = false)
+{
+    static_assert(mat4_stream<T>::lanes <= 16, "one uint16 singular mask per block");
+    const std::size_t count = in.size();
+    out.resize(count);
+    std::vector<std::uint16_t> masks(in.blocks());
+    detail::mat4StreamRun(in.blocks(), bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      for(std::size_t b = begin; b < end; b++)
+			      {
+				  const std::size_t first = b * mat4_stream<T>::lanes;
+				  const std::size_t last = first + mat4_stream<T>::lanes < count ? first + mat4_stream<T>::lanes : count;
+				  for(std::size_t i = first; i < last; i++)
+				  {
+				      mat4<T> inv;
+				      if(!in[i].inverse(inv))
+					  masks[b] |= (std::uint16_t)(1u << (i - first));
+				      out.set(i, inv);
+				  }
+			      }
+			  });
+    return detail::mat4SingularBits(masks, count, singular);
+}
+
+// out[i] = determinant(in[i]), out must hold in.size() elements
+template<typename T>
+void determinant(const mat4_stream<T>& in, T* out, const bool bParallel = false)
+{
+    assert(out != nullptr || in.empty());
+    detail::mat4StreamRun(in.blocks(), bParallel, [&](const std::size_t begin, const std::size_t end)
+			  {
+			      const std::size_t last = end * mat4_stream<T>::lanes < in.size() ? end * mat4_stream<T>::lanes : in.size();
+			      for(std::size_t i = begin * mat4_stream<T>::lanes; i < last; i++)
+				  out[i] = in[i].determinant();
+			  });
+}
+
+std::size_t inverse(const mat4f_stream& in, mat4f_stream& out, bit_vector& singular, const bool bParallel = false);
+void determinant(const mat4f_stream& in, float* out, const bool bParallel = false);
+
+// AoS arrays, packed to blocks on the way
+std::size_t inverse(const mat4f* in, const std::size_t count, mat4f* out, bit_vector& singular, const bool bParallel = false);
+void determinant(const mat4f* in, const std::size_t count, float* out, const bool bParallel = false);
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,353 @@
+#include "mmap.h"
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace gb::physics;
+
+constexpr std::uint32_t mapped_header::magic_value;
+
+mapped_file::mapped_file() :
+    _data(nullptr),
+    _size(0),
+    _mode(read_write),
+#ifdef _WIN32
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(nullptr)
+#else
+    _fd(-1)
+#endif
+{}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept :
+    mapped_file()
+{
+    *this = std::move(other);
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if(this == &other)
+	return *this;
+
+    close();
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    std::swap(_mode, other._mode);
+#ifdef _WIN32
+    std::swap(_file, other._file);
+    std::swap(_mapping, other._mapping);
+#else
+    std::swap(_fd, other._fd);
+#endif
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const char* path, const mode m, const std::size_t size)
+{
+    close();
+    _mode = m;
+
+    const DWORD access = m == read_only ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE);
+    const DWORD disposition = m == create ? CREATE_ALWAYS : OPEN_EXISTING;
+    _file = CreateFileA(path, access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(_file == INVALID_HANDLE_VALUE)
+	return false;
+
+    if(m == create)
+    {
+	if(!resize(size))
+	{
+	    close();
+	    return false;
+	}
+	return true;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(_file, &fileSize))
+    {
+	close();
+	return false;
+    }
+    _size = (std::size_t)fileSize.QuadPart;
+    if(!_map())
+    {
+	close();
+	return false;
+    }
+    return true;
+}
+
+bool mapped_file::open_temporary(const std::size_t size)
+{
+    close();
+    _mode = read_write;
+
+    char dir[MAX_PATH + 1];
+    char path[MAX_PATH + 1];
+    if(GetTempPathA(sizeof(dir), dir) == 0 || GetTempFileNameA(dir, "gbm", 0, path) == 0)
+	return false;
+    _file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if(_file == INVALID_HANDLE_VALUE)
+	return false;
+    if(!resize(size))
+    {
+	close();
+	return false;
+    }
+    return true;
+}
+
+bool mapped_file::resize(const std::size_t size)
+{
+    if(_file == INVALID_HANDLE_VALUE || _mode == read_only || size == 0)
+	return false;
+
+    if(size >= _size)
+    {
+	// a larger mapping grows the file, the old view is kept until the new one is there
+	LARGE_INTEGER len;
+	len.QuadPart = (LONGLONG)size;
+	HANDLE mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, len.HighPart, len.LowPart, nullptr);
+	void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+	if(data == nullptr)
+	{
+	    if(mapping != nullptr)
+		CloseHandle(mapping);
+	    return false;
+	}
+	_unmap();
+	_mapping = mapping;
+	_data = data;
+	_size = size;
+	return true;
+    }
+
+    // a mapped file can't be truncated, the view is dropped first and restored if that fails
+    _unmap();
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)size;
+    if(!SetFilePointerEx(_file, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(_file))
+    {
+	if(!_map())
+	    close();
+	return false;
+    }
+    _size = size;
+    if(!_map())
+    {
+	close();
+	return false;
+    }
+    return true;
+}
+
+bool mapped_file::_map()
+{
+    // an empty file can't be mapped, keep a valid handle only
+    if(_size == 0)
+	return false;
+
+    const bool ro = _mode == read_only;
+    _mapping = CreateFileMappingA(_file, nullptr, ro ? PAGE_READONLY : PAGE_READWRITE, 0, 0, nullptr);
+    if(_mapping == nullptr)
+	return false;
+    _data = MapViewOfFile(_mapping, ro ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, _size);
+    return _data != nullptr;
+}
+
+void mapped_file::_unmap()
+{
+    if(_data != nullptr)
+    {
+	UnmapViewOfFile(_data);
+	_data = nullptr;
+    }
+    if(_mapping != nullptr)
+    {
+	CloseHandle(_mapping);
+	_mapping = nullptr;
+    }
+}
+
+void mapped_file::flush()
+{
+    if(_data != nullptr && _mode != read_only)
+    {
+	FlushViewOfFile(_data, 0);
+	FlushFileBuffers(_file);
+    }
+}
+
+void mapped_file::close()
+{
+    flush();
+    _unmap();
+    if(_file != INVALID_HANDLE_VALUE)
+    {
+	CloseHandle(_file);
+	_file = INVALID_HANDLE_VALUE;
+    }
+    _size = 0;
+}
+
+#else
+
+bool mapped_file::open(const char* path, const mode m, const std::size_t size)
+{
+    close();
+    _mode = m;
+
+    const int flags = m == read_only ? O_RDONLY : (m == create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR);
+    _fd = ::open(path, flags, 0644);
+    if(_fd < 0)
+	return false;
+
+    if(m == create)
+    {
+	if(!resize(size))
+	{
+	    close();
+	    return false;
+	}
+	return true;
+    }
+
+    struct stat st;
+    if(fstat(_fd, &st) != 0)
+    {
+	close();
+	return false;
+    }
+    _size = (std::size_t)st.st_size;
+    if(!_map())
+    {
+	close();
+	return false;
+    }
+    return true;
+}
+
+bool mapped_file::open_temporary(const std::size_t size)
+{
+    close();
+    _mode = read_write;
+
+    // tmpfile() is already unlinked, its descriptor outlives the FILE
+    std::FILE* file = std::tmpfile();
+    if(file == nullptr)
+	return false;
+    _fd = dup(fileno(file));
+    std::fclose(file);
+    if(_fd < 0)
+	return false;
+    if(!resize(size))
+    {
+	close();
+	return false;
+    }
+    return true;
+}
+
+bool mapped_file::resize(const std::size_t size)
+{
+    if(_fd < 0 || _mode == read_only || size == 0)
+	return false;
+
+    // the file is only shortened once the new view is there, on failure both are left as they were
+    const std::size_t oldSize = _size;
+    // the grown part reads as zeros
+    if(size > oldSize && ftruncate(_fd, (off_t)size) != 0)
+	return false;
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if(data != MAP_FAILED && size < oldSize && ftruncate(_fd, (off_t)size) != 0)
+    {
+	munmap(data, size);
+	data = MAP_FAILED;
+    }
+    if(data == MAP_FAILED)
+    {
+	// best effort, a longer file is harmless and the old bytes are untouched
+	const int rollback = size > oldSize ? ftruncate(_fd, (off_t)oldSize) : 0;
+	(void)rollback;
+	return false;
+    }
+    _unmap();
+    _data = data;
+    _size = size;
+    return true;
+}
+
+bool mapped_file::_map()
+{
+    if(_size == 0)
+	return false;
+
+    const int prot = _mode == read_only ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void* ret = mmap(nullptr, _size, prot, MAP_SHARED, _fd, 0);
+    if(ret == MAP_FAILED)
+	return false;
+    _data = ret;
+    return true;
+}
+
+void mapped_file::_unmap()
+{
+    if(_data != nullptr)
+    {
+	munmap(_data, _size);
+	_data = nullptr;
+    }
+}
+
+void mapped_file::flush()
+{
+    if(_data != nullptr && _mode != read_only)
+	msync(_data, _size, MS_SYNC);
+}
+
+void mapped_file::close()
+{
+    flush();
+    _unmap();
+    if(_fd >= 0)
+    {
+	::close(_fd);
+	_fd = -1;
+    }
+    _size = 0;
+}
+
+#endif
+
+mapped_header* mapped_header::get(const mapped_file& file, const std::uint32_t kind)
+{
+    if(!file.is_open() || file.size() < sizeof(mapped_header))
+	return nullptr;
+
+    mapped_header* ret = (mapped_header*)file.data();
+    if(ret->magic != magic_value || ret->kind != kind
+       || ret->payload_size > file.size() - sizeof(mapped_header))
+	return nullptr;
+    return ret;
+}
@@ -0,0 +1,96 @@
+// memory mapped files
+
+#pragma once
+
+#include "physicsNS.h"
+#include <cstddef>
+#include <cstdint>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, a file mapped into memory(read/write shared mapping),
+ writes go to the page cache and reach the file on flush() or close(),
+ so resident memory is bounded by the page cache rather than the heap.
+ */
+class mapped_file
+{
+public:
+    enum mode
+    {
+	create = 0,		// create or truncate, then size to the requested bytes
+	read_write,		// existing file
+	read_only		// existing file, the mapping must not be written
+    };
+
+    mapped_file();
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    /*
+     *@param, size, file size in bytes for create, ignored otherwise.
+     *@return, false if the file can't be opened or mapped.
+     */
+    bool open(const char* path, const mode m, const std::size_t size = 0);
+    // unnamed read/write file of size bytes, gone once closed
+    bool open_temporary(const std::size_t size);
+    /*
+     *@brief, grow or shrink the file and remap it, data() may move.
+     *@return, false for a read only file or on I/O failure, the file and data() are then kept.
+     */
+    bool resize(const std::size_t size);
+    // write dirty pages back to the file
+    void flush();
+    void close();
+
+    bool is_open() const { return _data != nullptr; }
+    bool writable() const { return _mode != read_only; }
+    std::size_t size() const { return _size; }
+    void* data() const { return _data; }
+private:
+    bool _map();
+    void _unmap();
+private:
+    void* _data;
+    std::size_t _size;
+    std::uint8_t _mode;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _fd;
+#endif
+};
+
+/*
+ *@brief, fixed 64 bytes header in front of the mapped payload,
+ enough to reopen a container without knowing its shape beforehand.
+ the payload starts right after it, so it stays GB_PHYSICS_SIMD_ALIGNMENT aligned.
+ */
+struct mapped_header
+{
+    static constexpr std::uint32_t magic_value = 0x666d6267;// "gbmf"
+
+    std::uint32_t magic;
+    std::uint32_t kind;// owner type, see mapped_kind
+    std::uint64_t elem_size;
+    std::uint64_t dims[2];// array_2d: row, col. bit_vector: size, capacity
+    std::uint64_t payload_size;// bytes following the header
+    std::uint8_t reserved[24];
+
+    // header of a mapped file, nullptr if it's too small or not of the given kind
+    static mapped_header* get(const mapped_file& file, const std::uint32_t kind);
+    void* payload() { return this + 1; }
+};
+static_assert(sizeof(mapped_header) == 64, "mapped_header must stay 64 bytes");
+
+enum mapped_kind : std::uint32_t
+{
+    mapped_array_2d = 1,
+    mapped_bit_vector
+};
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,90 @@
+// fork/join helpers for bulk kernels
+
+#pragma once
+
+#include "physicsNS.h"
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+GB_PHYSICS_NS_BEGIN
+
+inline std::size_t hardwareThreads()
+{
+    const unsigned int ret = std::thread::hardware_concurrency();
+    return ret == 0 ? 1 : ret;
+}
+
+/*
+ *@brief, split [0, count) into contiguous chunks of at least minChunk elements(one per hardware thread at most)
+ and run func(begin, end) on every chunk, the calling thread takes the first one.
+ small inputs stay on the calling thread.
+ */
+template<typename Func>
+void parallelFor(const std::size_t count, const std::size_t minChunk, Func func)
+{
+    std::size_t chunks = minChunk == 0 ? count : count / minChunk;
+    const std::size_t threads = hardwareThreads();
+    if(chunks > threads)
+	chunks = threads;
+    if(chunks <= 1)
+    {
+	if(count != 0)
+	    func(std::size_t(0), count);
+	return;
+    }
+
+    const std::size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for(std::size_t c = 1; c < chunks; c++)
+    {
+	const std::size_t begin = c * chunkSize;
+	const std::size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+	if(begin >= end)
+	    break;
+	workers.emplace_back([&func, begin, end]()
+			     {
+				 func(begin, end);
+			     });
+    }
+    func(std::size_t(0), chunkSize < count ? chunkSize : count);
+    for(std::thread& t : workers)
+	t.join();
+}
+
+/*
+ *@brief, map every chunk of [0, count) to a partial result, R map(begin, end),
+ then fold the partials in chunk order with void merge(R& into, const R& partial),
+ so the result doesn't depend on thread timing.
+ */
+template<typename R, typename Map, typename Merge>
+R parallelReduce(const std::size_t count, const std::size_t minChunk, const R& init, Map map, Merge merge)
+{
+    std::size_t chunks = minChunk == 0 ? count : count / minChunk;
+    const std::size_t threads = hardwareThreads();
+    if(chunks > threads)
+	chunks = threads;
+    if(chunks == 0)
+	chunks = 1;
+
+    const std::size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<R> partials(chunks, init);
+    parallelFor(chunks, 1, [&](const std::size_t cBegin, const std::size_t cEnd)
+		{
+		    for(std::size_t c = cBegin; c < cEnd; c++)
+		    {
+			const std::size_t begin = c * chunkSize;
+			const std::size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+			if(begin < end)
+			    partials[c] = map(begin, end);
+		    }
+		});
+
+    R ret = init;
+    for(const R& p : partials)
+	merge(ret, p);
+    return ret;
+}
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,211 @@
+#include "quantize.h"
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+using namespace gb::physics;
+
+/*
+  vec3f arrays are walked as flat float arrays where the component doesn't matter(half),
+  4 points(12 floats, 3 registers) at a time otherwise, the per axis constants are then
+  rotated to match the x y z x | y z x y | z x y z register layout.
+  the tail goes through the scalar conversions of quantize.h.
+*/
+
+#if defined(GB_PHYSICS_SSE)
+
+// v0 v1 v2 v0 | v1 v2 v0 v1 | v2 v0 v1 v2
+static inline void _rotated(const vec3f& v, __m128& r0, __m128& r1, __m128& r2)
+{
+    r0 = _mm_setr_ps(v.x, v.y, v.z, v.x);
+    r1 = _mm_setr_ps(v.y, v.z, v.x, v.y);
+    r2 = _mm_setr_ps(v.z, v.x, v.y, v.z);
+}
+
+// (v - lower) * scale, clamped to [0, maxQ] and rounded
+static inline __m128i _quantize(const __m128 v, const __m128 lower, const __m128 scale, const __m128 maxQ)
+{
+    const __m128 q = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, lower), scale), _mm_setzero_ps()), maxQ);
+    return _mm_cvttps_epi32(_mm_add_ps(q, _mm_set1_ps(0.5f)));
+}
+
+// 2 x 4 int32 in [0, 65535] to 8 uint16
+static inline __m128i _pack_u16(const __m128i a, const __m128i b)
+{
+    // sign extend the low 16 bits so the signed saturating pack keeps them as is
+    return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+}
+
+#if !defined(__F16C__)
+static inline __m128i _float_to_half(const __m128 f)
+{
+    const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+    const __m128i justSign = _mm_and_si128(_mm_castps_si128(f), signMask);
+    const __m128i absInt = _mm_xor_si128(_mm_castps_si128(f), justSign);
+    const __m128 absF = _mm_castsi128_ps(absInt);
+
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+    const __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absInt);
+    const __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+    const __m128i isSub = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absInt);
+
+    // subnormal results, rounded by the float adder
+    const __m128i subMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i sub = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(subMagic))), subMagic);
+
+    // normal results, rebias and round to nearest even
+    const __m128i mantOdd = _mm_srai_epi32(_mm_slli_epi32(absInt, 31 - 13), 31);
+    const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absInt, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), mantOdd);
+    const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+    const __m128i nonSpecial = _mm_or_si128(_mm_and_si128(isSub, sub), _mm_andnot_si128(isSub, normal));
+    const __m128i joined = _mm_or_si128(_mm_and_si128(isRegular, nonSpecial), _mm_andnot_si128(isRegular, infOrNaN));
+    return _mm_or_si128(joined, _mm_srli_epi32(justSign, 16));
+}
+
+static inline __m128 _half_to_float(const __m128i h)
+{
+    const __m128i expMant = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+    const __m128i justSign = _mm_xor_si128(h, expMant);
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)),
+				     _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    const __m128i wasInfNaN = _mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7bff));
+    const __m128i signInf = _mm_or_si128(_mm_slli_epi32(justSign, 16), _mm_and_si128(wasInfNaN, _mm_set1_epi32(255 << 23)));
+    return _mm_castsi128_ps(_mm_or_si128(_mm_castps_si128(scaled), signInf));
+}
+#endif
+
+#endif
+
+void gb::physics::encodeHalf(const vec3f* in, const std::size_t count, vec3h* out)
+{
+    const float* src = in->data();
+    std::uint16_t* dst = &out->x.bits;
+    const std::size_t n = count * 3;
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    for(; i + 4 <= n; i += 4)
+    {
+	const __m128 f = _mm_loadu_ps(src + i);
+#if defined(__F16C__)
+	const __m128i h = _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+	const __m128i h = _pack_u16(_float_to_half(f), _mm_setzero_si128());
+#endif
+	_mm_storel_epi64((__m128i*)(dst + i), h);
+    }
+#endif
+    for(; i < n; i++)
+	dst[i] = half::from_float(src[i]);
+}
+
+void gb::physics::decodeHalf(const vec3h* in, const std::size_t count, vec3f* out)
+{
+    const std::uint16_t* src = &in->x.bits;
+    float* dst = out->data();
+    const std::size_t n = count * 3;
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    for(; i + 4 <= n; i += 4)
+    {
+	const __m128i h = _mm_loadl_epi64((const __m128i*)(src + i));
+#if defined(__F16C__)
+	_mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+#else
+	_mm_storeu_ps(dst + i, _half_to_float(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+#endif
+    }
+#endif
+    for(; i < n; i++)
+	dst[i] = half::to_float(src[i]);
+}
+
+void gb::physics::quantize(const vec3_quantizer& q, const vec3f* in, const std::size_t count, vec3q16* out)
+{
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    __m128 l0, l1, l2, s0, s1, s2;
+    _rotated(q.lower, l0, l1, l2);
+    _rotated(q.scale(65535.0f), s0, s1, s2);
+    const __m128 maxQ = _mm_set1_ps(65535.0f);
+    for(; i + 4 <= count; i += 4)
+    {
+	const float* src = in[i].data();
+	const __m128i q0 = _quantize(_mm_loadu_ps(src), l0, s0, maxQ);
+	const __m128i q1 = _quantize(_mm_loadu_ps(src + 4), l1, s1, maxQ);
+	const __m128i q2 = _quantize(_mm_loadu_ps(src + 8), l2, s2, maxQ);
+	std::uint16_t* dst = &out[i].x;
+	_mm_storeu_si128((__m128i*)dst, _pack_u16(q0, q1));
+	_mm_storel_epi64((__m128i*)(dst + 8), _pack_u16(q2, _mm_setzero_si128()));
+    }
+#endif
+    for(; i < count; i++)
+	out[i] = q.encode16(in[i]);
+}
+
+void gb::physics::dequantize(const vec3_quantizer& q, const vec3q16* in, const std::size_t count, vec3f* out)
+{
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    __m128 l0, l1, l2, s0, s1, s2;
+    _rotated(q.lower, l0, l1, l2);
+    _rotated(q.step(65535.0f), s0, s1, s2);
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 4 <= count; i += 4)
+    {
+	const std::uint16_t* src = &in[i].x;
+	const __m128i a = _mm_loadu_si128((const __m128i*)src);
+	const __m128i b = _mm_loadl_epi64((const __m128i*)(src + 8));
+	float* dst = out[i].data();
+	_mm_storeu_ps(dst, _mm_add_ps(l0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero)), s0)));
+	_mm_storeu_ps(dst + 4, _mm_add_ps(l1, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero)), s1)));
+	_mm_storeu_ps(dst + 8, _mm_add_ps(l2, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(b, zero)), s2)));
+    }
+#endif
+    for(; i < count; i++)
+	out[i] = q.decode16(in[i]);
+}
+
+void gb::physics::quantize(const vec3_quantizer& q, const vec3f* in, const std::size_t count, vec3q10* out)
+{
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    const vec3f s = q.scale(1023.0f);
+    const __m128 lx = _mm_set1_ps(q.lower.x), ly = _mm_set1_ps(q.lower.y), lz = _mm_set1_ps(q.lower.z);
+    const __m128 sx = _mm_set1_ps(s.x), sy = _mm_set1_ps(s.y), sz = _mm_set1_ps(s.z);
+    const __m128 maxQ = _mm_set1_ps(1023.0f);
+    for(; i + 4 <= count; i += 4)
+    {
+	__m128 x, y, z;
+	loadSoA4(in[i].data(), x, y, z);
+	const __m128i bits = _mm_or_si128(_quantize(x, lx, sx, maxQ),
+					  _mm_or_si128(_mm_slli_epi32(_quantize(y, ly, sy, maxQ), 10),
+						       _mm_slli_epi32(_quantize(z, lz, sz, maxQ), 20)));
+	_mm_storeu_si128((__m128i*)&out[i].bits, bits);
+    }
+#endif
+    for(; i < count; i++)
+	out[i] = q.encode10(in[i]);
+}
+
+void gb::physics::dequantize(const vec3_quantizer& q, const vec3q10* in, const std::size_t count, vec3f* out)
+{
+    std::size_t i = 0;
+#if defined(GB_PHYSICS_SSE)
+    const vec3f s = q.step(1023.0f);
+    const __m128 lx = _mm_set1_ps(q.lower.x), ly = _mm_set1_ps(q.lower.y), lz = _mm_set1_ps(q.lower.z);
+    const __m128 sx = _mm_set1_ps(s.x), sy = _mm_set1_ps(s.y), sz = _mm_set1_ps(s.z);
+    const __m128i mask = _mm_set1_epi32(0x3ff);
+    for(; i + 4 <= count; i += 4)
+    {
+	const __m128i bits = _mm_loadu_si128((const __m128i*)&in[i].bits);
+	const __m128 x = _mm_cvtepi32_ps(_mm_and_si128(bits, mask));
+	const __m128 y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(bits, 10), mask));
+	const __m128 z = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(bits, 20), mask));
+	storeAoS4(out[i].data(), _mm_add_ps(lx, _mm_mul_ps(x, sx)), _mm_add_ps(ly, _mm_mul_ps(y, sy)), _mm_add_ps(lz, _mm_mul_ps(z, sz)));
+    }
+#endif
+    for(; i < count; i++)
+	out[i] = q.decode10(in[i]);
+}
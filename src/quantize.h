@@ -0,0 +1,181 @@
+// compact vec3 storage
+
+#pragma once
+
+#include "type.h"
+#include "boundingbox.h"
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, IEEE 754 binary16, storage only(convert to float for math).
+ conversion rounds to nearest even, overflow goes to inf and NaN stays NaN.
+ ref: https://gist.github.com/rygorous/2156668
+ */
+struct half
+{
+    half() :
+	bits(0)
+	{}
+    explicit half(const float f) :
+	bits(from_float(f))
+	{}
+    operator float() const { return to_float(bits); }
+
+    static std::uint16_t from_float(const float f)
+	{
+	    std::uint32_t u;
+	    std::memcpy(&u, &f, sizeof(u));
+	    const std::uint32_t sign = u & 0x80000000u;
+	    u ^= sign;
+
+	    std::uint16_t ret;
+	    if(u >= (std::uint32_t)(127 + 16) << 23)
+		ret = u > 0x7f800000u ? 0x7e00 : 0x7c00;// NaN : inf
+	    else if(u < (std::uint32_t)(127 - 14) << 23)
+	    {
+		// subnormal, let the float adder do the rounding
+		const std::uint32_t magicBits = (std::uint32_t)((127 - 15) + (23 - 10) + 1) << 23;
+		float magic, tmp;
+		std::memcpy(&magic, &magicBits, sizeof(magic));
+		std::memcpy(&tmp, &u, sizeof(tmp));
+		tmp += magic;
+		std::memcpy(&u, &tmp, sizeof(u));
+		ret = (std::uint16_t)(u - magicBits);
+	    }
+	    else
+	    {
+		const std::uint32_t mantOdd = (u >> 13) & 1;
+		u += ((std::uint32_t)(15 - 127) << 23) + 0xfff;
+		u += mantOdd;
+		ret = (std::uint16_t)(u >> 13);
+	    }
+	    return (std::uint16_t)(ret | (sign >> 16));
+	}
+    static float to_float(const std::uint16_t h)
+	{
+	    const float magic = 5.192296858534828e+33f;// 2^112, rebias 15 to 127
+	    const std::uint32_t expMant = h & 0x7fffu;
+	    std::uint32_t u = expMant << 13;
+	    float f;
+	    std::memcpy(&f, &u, sizeof(f));
+	    f *= magic;
+	    std::memcpy(&u, &f, sizeof(u));
+	    if(expMant >= 0x7c00u)
+		u |= 255u << 23;// inf, NaN
+	    u |= (std::uint32_t)(h & 0x8000u) << 16;
+	    std::memcpy(&f, &u, sizeof(f));
+	    return f;
+	}
+
+    std::uint16_t bits;
+};
+
+// 6 bytes
+struct vec3h
+{
+    vec3h() {}
+    explicit vec3h(const vec3f& v) :
+	x(v.x),
+	y(v.y),
+	z(v.z)
+	{}
+    operator vec3f() const { return vec3f((float)x, (float)y, (float)z); }
+
+    half x, y, z;
+};
+
+// 16 bits fixed point per axis, relative to a vec3_quantizer box, 6 bytes
+struct vec3q16
+{
+    std::uint16_t x, y, z;
+};
+
+// 10-10-10-2 fixed point, x in the lowest bits, the top 2 bits are free for the caller, 4 bytes
+struct vec3q10
+{
+    std::uint32_t bits;
+
+    std::uint32_t x() const { return bits & 0x3ff; }
+    std::uint32_t y() const { return (bits >> 10) & 0x3ff; }
+    std::uint32_t z() const { return (bits >> 20) & 0x3ff; }
+    std::uint8_t tag() const { return (std::uint8_t)(bits >> 30); }
+    void set_tag(const std::uint8_t tag) { bits = (bits & 0x3fffffffu) | ((std::uint32_t)(tag & 3) << 30); }
+};
+
+static_assert(sizeof(vec3h) == 6, "vec3h must be 6 bytes");
+static_assert(sizeof(vec3q16) == 6, "vec3q16 must be 6 bytes");
+static_assert(sizeof(vec3q10) == 4, "vec3q10 must be 4 bytes");
+
+/*
+ *@brief, maps positions inside an aabb to fixed point and back.
+ each axis is cut into 2^bits - 1 steps, so the error is at most half a step(lenSide / (2^bits - 1) / 2),
+ positions outside the box are clamped to it.
+ */
+struct vec3_quantizer
+{
+    explicit vec3_quantizer(const aabb<float>& box) :
+	lower(box.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX]),
+	extent(box.diagonal[GB_PHYSICS_DIAGONAL_UPPER_IDX] - box.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX])
+	{}
+
+    // steps per unit for a maxQ steps axis, 0 for a flat axis
+    vec3f scale(const float maxQ) const
+	{
+	    return vec3f(extent.x > 0 ? maxQ / extent.x : 0,
+			 extent.y > 0 ? maxQ / extent.y : 0,
+			 extent.z > 0 ? maxQ / extent.z : 0);
+	}
+    // units per step
+    vec3f step(const float maxQ) const
+	{
+	    return extent / maxQ;
+	}
+
+    vec3q16 encode16(const vec3f& v) const
+	{
+	    const vec3f s = scale(65535.0f);
+	    return vec3q16{_q(v.x, lower.x, s.x, 65535.0f), _q(v.y, lower.y, s.y, 65535.0f), _q(v.z, lower.z, s.z, 65535.0f)};
+	}
+    vec3f decode16(const vec3q16& q) const
+	{
+	    const vec3f s = step(65535.0f);
+	    return vec3f(lower.x + q.x * s.x, lower.y + q.y * s.y, lower.z + q.z * s.z);
+	}
+    vec3q10 encode10(const vec3f& v, const std::uint8_t tag = 0) const
+	{
+	    const vec3f s = scale(1023.0f);
+	    return vec3q10{_q(v.x, lower.x, s.x, 1023.0f)
+		    | ((std::uint32_t)_q(v.y, lower.y, s.y, 1023.0f) << 10)
+		    | ((std::uint32_t)_q(v.z, lower.z, s.z, 1023.0f) << 20)
+		    | ((std::uint32_t)(tag & 3) << 30)};
+	}
+    vec3f decode10(const vec3q10& q) const
+	{
+	    const vec3f s = step(1023.0f);
+	    return vec3f(lower.x + q.x() * s.x, lower.y + q.y() * s.y, lower.z + q.z() * s.z);
+	}
+
+    vec3f lower;
+    vec3f extent;
+private:
+    static std::uint16_t _q(const float v, const float lower, const float scale, const float maxQ)
+	{
+	    float q = (v - lower) * scale;
+	    q = q < 0 ? 0 : (q > maxQ ? maxQ : q);
+	    return (std::uint16_t)(q + 0.5f);
+	}
+};
+
+/*
+  batch conversions, SSE2 when available(F16C for half if the compiler targets it),
+  in and out may not overlap.
+*/
+void encodeHalf(const vec3f* in, const std::size_t count, vec3h* out);
+void decodeHalf(const vec3h* in, const std::size_t count, vec3f* out);
+void quantize(const vec3_quantizer& q, const vec3f* in, const std::size_t count, vec3q16* out);
+void dequantize(const vec3_quantizer& q, const vec3q16* in, const std::size_t count, vec3f* out);
+void quantize(const vec3_quantizer& q, const vec3f* in, const std::size_t count, vec3q10* out);
+void dequantize(const vec3_quantizer& q, const vec3q10* in, const std::size_t count, vec3f* out);
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,181 @@
+#include "quat.h"
+
+using namespace gb::physics;
+
+/*
+  4 quaternions or 4 vertices per step, quaternions are transposed to x y z w registers(SoA),
+  vertices go through loadSoA4/storeAoS4. tails fall back to the scalar quat.h math.
+*/
+
+static constexpr std::size_t _parallel_chunk = 16 * 1024;
+
+template<typename Func>
+static void _run(const std::size_t count, const bool bParallel, Func func)
+{
+    if(bParallel)
+	parallelFor(count, _parallel_chunk, func);
+    else
+	func(std::size_t(0), count);
+}
+
+static void _nlerp(const quatf* a, const quatf* b, const float t, std::size_t i, const std::size_t end, quatf* out)
+{
+#if defined(GB_PHYSICS_SSE)
+    const __m128 ta = _mm_set1_ps(1 - t);
+    const __m128 tb = _mm_set1_ps(t);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for(; i + 4 <= end; i += 4)
+    {
+	__m128 ax = _mm_loadu_ps(&a[i].x), ay = _mm_loadu_ps(&a[i + 1].x), az = _mm_loadu_ps(&a[i + 2].x), aw = _mm_loadu_ps(&a[i + 3].x);
+	__m128 bx = _mm_loadu_ps(&b[i].x), by = _mm_loadu_ps(&b[i + 1].x), bz = _mm_loadu_ps(&b[i + 2].x), bw = _mm_loadu_ps(&b[i + 3].x);
+	_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+	_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+	// shorter arc, flip b where a . b < 0
+	const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+	const __m128 tbSigned = _mm_xor_ps(tb, _mm_and_ps(d, signMask));
+
+	__m128 x = _mm_add_ps(_mm_mul_ps(ax, ta), _mm_mul_ps(bx, tbSigned));
+	__m128 y = _mm_add_ps(_mm_mul_ps(ay, ta), _mm_mul_ps(by, tbSigned));
+	__m128 z = _mm_add_ps(_mm_mul_ps(az, ta), _mm_mul_ps(bz, tbSigned));
+	__m128 w = _mm_add_ps(_mm_mul_ps(aw, ta), _mm_mul_ps(bw, tbSigned));
+	const __m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+	const __m128 oneOverMag = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(sq));
+	x = _mm_mul_ps(x, oneOverMag);
+	y = _mm_mul_ps(y, oneOverMag);
+	z = _mm_mul_ps(z, oneOverMag);
+	w = _mm_mul_ps(w, oneOverMag);
+
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&out[i].x, x);
+	_mm_storeu_ps(&out[i + 1].x, y);
+	_mm_storeu_ps(&out[i + 2].x, z);
+	_mm_storeu_ps(&out[i + 3].x, w);
+    }
+#endif
+    for(; i < end; i++)
+	out[i] = nlerp(a[i], b[i], t);
+}
+
+void gb::physics::nlerp(const quatf* a, const quatf* b, const float t, const std::size_t count, quatf* out, const bool bParallel)
+{
+    assert((a != nullptr && b != nullptr && out != nullptr) || count == 0);
+    _run(count, bParallel, [a, b, t, out](const std::size_t begin, const std::size_t end)
+	 {
+	     _nlerp(a, b, t, begin, end, out);
+	 });
+}
+
+/*
+  DLB, sum of the weighted joints, a joint on the other hemisphere of the first one is negated.
+  the blend is left unnormalized, the transforms below divide by |real|^2 instead
+*/
+static void _blend(const dualquatf* joints, const skin_influence& inf, float* real, float* dual)
+{
+    const quatf& pivot = joints[inf.joint[0]].real;
+    for(std::uint8_t c = 0; c < 4; c++)
+	real[c] = dual[c] = 0;
+    for(std::uint8_t k = 0; k < 4; k++)
+    {
+	if(inf.weight[k] == 0)
+	    continue;
+	const dualquatf& j = joints[inf.joint[k]];
+	const float w = pivot.dot(j.real) < 0 ? -inf.weight[k] : inf.weight[k];
+	const float* jr = &j.real.x;
+	const float* jd = &j.dual.x;
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    real[c] += jr[c] * w;
+	    dual[c] += jd[c] * w;
+	}
+    }
+}
+
+/*
+  for the unnormalized blend b = r + eps * d, n = |r|^2,
+  rotate: (v * (rw^2 - |r.xyz|^2) + 2 * r.xyz * (r.xyz . v) + 2 * rw * cross(r.xyz, v)) / n
+  translate: 2 * (rw * d.xyz - dw * r.xyz + cross(r.xyz, d.xyz)) / n
+*/
+template<bool Point>
+static void _skin(const dualquatf* joints, const skin_influence* influences, const vec3f* in, std::size_t i, const std::size_t end, vec3f* out)
+{
+#if defined(GB_PHYSICS_SSE)
+    for(; i + 4 <= end; i += 4)
+    {
+	__m128 r[4], d[4];
+	for(std::uint8_t v = 0; v < 4; v++)
+	{
+	    const skin_influence& inf = influences[i + v];
+	    const quatf& pivot = joints[inf.joint[0]].real;
+	    r[v] = d[v] = _mm_setzero_ps();
+	    for(std::uint8_t k = 0; k < 4; k++)
+	    {
+		if(inf.weight[k] == 0)
+		    continue;
+		const dualquatf& j = joints[inf.joint[k]];
+		const __m128 w = _mm_set1_ps(pivot.dot(j.real) < 0 ? -inf.weight[k] : inf.weight[k]);
+		r[v] = _mm_add_ps(r[v], _mm_mul_ps(_mm_loadu_ps(&j.real.x), w));
+		d[v] = _mm_add_ps(d[v], _mm_mul_ps(_mm_loadu_ps(&j.dual.x), w));
+	    }
+	}
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	const __m128 rx = r[0], ry = r[1], rz = r[2], rw = r[3];
+
+	__m128 x, y, z;
+	loadSoA4(in[i].data(), x, y, z);
+
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 uu = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+	const __m128 oneOverN = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(uu, _mm_mul_ps(rw, rw)));
+	const __m128 s = _mm_sub_ps(_mm_mul_ps(rw, rw), uu);
+	const __m128 uv2 = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, x), _mm_mul_ps(ry, y)), _mm_mul_ps(rz, z)));
+	const __m128 w2 = _mm_mul_ps(two, rw);
+	// cross(u, v)
+	const __m128 cx = _mm_sub_ps(_mm_mul_ps(ry, z), _mm_mul_ps(rz, y));
+	const __m128 cy = _mm_sub_ps(_mm_mul_ps(rz, x), _mm_mul_ps(rx, z));
+	const __m128 cz = _mm_sub_ps(_mm_mul_ps(rx, y), _mm_mul_ps(ry, x));
+	__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, s), _mm_mul_ps(rx, uv2)), _mm_mul_ps(cx, w2));
+	__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, s), _mm_mul_ps(ry, uv2)), _mm_mul_ps(cy, w2));
+	__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(z, s), _mm_mul_ps(rz, uv2)), _mm_mul_ps(cz, w2));
+
+	if(Point)
+	{
+	    _MM_TRANSPOSE4_PS(d[0], d[1], d[2], d[3]);
+	    const __m128 dx = d[0], dy = d[1], dz = d[2], dw = d[3];
+	    const __m128 tx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, dx), _mm_mul_ps(dw, rx)), _mm_sub_ps(_mm_mul_ps(ry, dz), _mm_mul_ps(rz, dy)));
+	    const __m128 ty = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, dy), _mm_mul_ps(dw, ry)), _mm_sub_ps(_mm_mul_ps(rz, dx), _mm_mul_ps(rx, dz)));
+	    const __m128 tz = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, dz), _mm_mul_ps(dw, rz)), _mm_sub_ps(_mm_mul_ps(rx, dy), _mm_mul_ps(ry, dx)));
+	    ox = _mm_add_ps(ox, _mm_mul_ps(two, tx));
+	    oy = _mm_add_ps(oy, _mm_mul_ps(two, ty));
+	    oz = _mm_add_ps(oz, _mm_mul_ps(two, tz));
+	}
+	storeAoS4(out[i].data(), _mm_mul_ps(ox, oneOverN), _mm_mul_ps(oy, oneOverN), _mm_mul_ps(oz, oneOverN));
+    }
+#endif
+    for(; i < end; i++)
+    {
+	float r[4], d[4];
+	_blend(joints, influences[i], r, d);
+	const dualquatf b{quatf{r[0], r[1], r[2], r[3]}, quatf{d[0], d[1], d[2], d[3]}};
+	const dualquatf n = b.normalize();
+	out[i] = Point ? n.transform_point(in[i]) : n.transform_direction(in[i]);
+    }
+}
+
+void gb::physics::skinPoints(const dualquatf* joints, const skin_influence* influences, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    assert((joints != nullptr && influences != nullptr && in != nullptr && out != nullptr) || count == 0);
+    _run(count, bParallel, [=](const std::size_t begin, const std::size_t end)
+	 {
+	     _skin<true>(joints, influences, in, begin, end, out);
+	 });
+}
+
+void gb::physics::skinDirections(const dualquatf* joints, const skin_influence* influences, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    assert((joints != nullptr && influences != nullptr && in != nullptr && out != nullptr) || count == 0);
+    _run(count, bParallel, [=](const std::size_t begin, const std::size_t end)
+	 {
+	     _skin<false>(joints, influences, in, begin, end, out);
+	 });
+}
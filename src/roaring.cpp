@@ -0,0 +1,409 @@
+#include "roaring.h"
+#include <algorithm>
+
+using namespace gb::physics;
+
+constexpr std::size_t roaring_bit_vector::chunk_bits;
+constexpr std::size_t roaring_bit_vector::npos;
+
+// array containers beyond this cardinality are bigger than a bitmap
+static constexpr std::uint32_t _array_max = 4096;
+static constexpr std::uint32_t _bitmap_words = roaring_bit_vector::chunk_bits / 64;
+static constexpr std::size_t _bitmap_bytes = _bitmap_words * sizeof(std::uint64_t);
+
+//**************** container ****************
+
+bool roaring_bit_vector::_container::contains(const std::uint32_t pos) const
+{
+    if(type == bitmap)
+	return ((words[pos / 64] >> (pos % 64)) & 1) != 0;
+    else if(type == array)
+	return std::binary_search(positions.begin(), positions.end(), (std::uint16_t)pos);
+    else
+    {
+	// last run starting at or before pos
+	std::vector<_run>::const_iterator it = std::upper_bound(runs.begin(), runs.end(), pos,
+							      [](const std::uint32_t p, const _run& r)
+							      {
+								  return p < r.first;
+							      });
+	if(it == runs.begin())
+	    return false;
+	--it;
+	return pos <= it->last;
+    }
+}
+
+std::uint32_t roaring_bit_vector::_container::_next(const std::uint32_t pos, const bool val) const
+{
+    assert(type == bitmap);
+    std::uint32_t w = pos / 64;
+    std::uint64_t cur = val ? words[w] : ~words[w];
+    cur &= ~std::uint64_t(0) << (pos % 64);
+    for(;;)
+    {
+	if(cur != 0)
+	    return w * 64 + ctz64(cur);
+	if(++w >= _bitmap_words)
+	    return chunk_bits;
+	cur = val ? words[w] : ~words[w];
+    }
+}
+
+std::size_t roaring_bit_vector::_container::_run_count() const
+{
+    if(type == run)
+	return runs.size();
+    if(type == array)
+	return arrayRuns;
+
+    std::size_t ret = 0;
+    for_each_run([&ret](const std::uint32_t, const std::uint32_t)
+		 {
+		     ret++;
+		 });
+    return ret;
+}
+
+void roaring_bit_vector::_container::_to_runs()
+{
+    if(type == run)
+	return;
+
+    std::vector<_run> newRuns;
+    for_each_run([&newRuns](const std::uint32_t first, const std::uint32_t last)
+		 {
+		     newRuns.push_back(_run{(std::uint16_t)first, (std::uint16_t)last});
+		 });
+    runs.swap(newRuns);
+    positions.clear();
+    positions.shrink_to_fit();
+    words.clear();
+    words.shrink_to_fit();
+    type = run;
+}
+
+void roaring_bit_vector::_container::_to_array()
+{
+    if(type == array)
+	return;
+
+    std::vector<std::uint16_t> newPositions;
+    newPositions.reserve(cardinality);
+    std::uint32_t newRuns = 0;
+    for_each_run([&newPositions, &newRuns](const std::uint32_t first, const std::uint32_t last)
+		 {
+		     for(std::uint32_t p = first; p <= last; p++)
+			 newPositions.push_back((std::uint16_t)p);
+		     newRuns++;
+		 });
+    positions.swap(newPositions);
+    arrayRuns = newRuns;
+    runs.clear();
+    runs.shrink_to_fit();
+    words.clear();
+    words.shrink_to_fit();
+    type = array;
+}
+
+void roaring_bit_vector::_container::_to_bitmap()
+{
+    if(type == bitmap)
+	return;
+
+    std::vector<std::uint64_t> newWords(_bitmap_words, 0);
+    for_each_run([&newWords](const std::uint32_t first, const std::uint32_t last)
+		 {
+		     for(std::uint32_t p = first; p <= last; p++)
+			 newWords[p / 64] |= std::uint64_t(1) << (p % 64);
+		 });
+    words.swap(newWords);
+    positions.clear();
+    positions.shrink_to_fit();
+    runs.clear();
+    runs.shrink_to_fit();
+    type = bitmap;
+}
+
+void roaring_bit_vector::_container::set_full(const bool val)
+{
+    positions.clear();
+    positions.shrink_to_fit();
+    words.clear();
+    words.shrink_to_fit();
+    runs.clear();
+    if(val)
+    {
+	runs.push_back(_run{0, (std::uint16_t)(chunk_bits - 1)});
+	type = run;
+	cardinality = chunk_bits;
+    }
+    else
+    {
+	runs.shrink_to_fit();
+	type = array;
+	cardinality = 0;
+    }
+    arrayRuns = 0;
+}
+
+bool roaring_bit_vector::_container::_array_set_range(const std::uint32_t first, const std::uint32_t last, const bool val)
+{
+    assert(type == array);
+    const std::vector<std::uint16_t>::iterator lo = std::lower_bound(positions.begin(), positions.end(), (std::uint16_t)first);
+    const std::vector<std::uint16_t>::iterator hi = std::upper_bound(lo, positions.end(), (std::uint16_t)last);
+    const std::uint32_t inside = (std::uint32_t)(hi - lo);
+    const std::uint32_t span = last - first + 1;
+    const std::uint32_t newCardinality = cardinality - inside + (val ? span : 0);
+    if(newCardinality > _array_max)
+	return false;
+
+    // only the run starts in [first, last + 1] change
+    const bool prevSet = lo != positions.begin() && (std::uint32_t)*(lo - 1) + 1 == first;
+    const bool nextSet = hi != positions.end() && (std::uint32_t)*hi == last + 1;
+    const bool lastSet = hi != lo && *(hi - 1) == last;
+    std::uint32_t startsBefore = nextSet && !lastSet ? 1 : 0;
+    for(std::vector<std::uint16_t>::iterator it = lo; it != hi; ++it)
+    {
+	if(it == positions.begin() || (std::uint32_t)*(it - 1) + 1 != *it)
+	    startsBefore++;
+    }
+    const std::uint32_t startsAfter = val ? (prevSet ? 0 : 1) : (nextSet ? 1 : 0);
+
+    if(val)
+    {
+	const std::vector<std::uint16_t>::iterator at = positions.insert(positions.erase(lo, hi), span, 0);
+	for(std::uint32_t p = 0; p < span; p++)
+	    at[p] = (std::uint16_t)(first + p);
+    }
+    else
+	positions.erase(lo, hi);
+    cardinality = newCardinality;
+    arrayRuns = arrayRuns - startsBefore + startsAfter;
+
+    // the array stays the container unless runs got cheaper
+    if(cardinality == 0)
+	set_full(false);
+    else if(arrayRuns * sizeof(_run) < cardinality * sizeof(std::uint16_t))
+	_to_runs();
+    return true;
+}
+
+void roaring_bit_vector::_container::set_range(const std::uint32_t first, const std::uint32_t last, const bool val)
+{
+    assert(first <= last && last < chunk_bits);
+
+    if(type == bitmap)
+    {
+	const std::uint32_t headWord = first / 64;
+	const std::uint32_t tailWord = last / 64;
+	for(std::uint32_t w = headWord; w <= tailWord; w++)
+	{
+	    std::uint64_t mask = ~std::uint64_t(0);
+	    if(w == headWord)
+		mask &= ~std::uint64_t(0) << (first % 64);
+	    if(w == tailWord && last % 64 != 63)
+		mask &= (std::uint64_t(1) << (last % 64 + 1)) - 1;
+
+	    std::uint64_t& word = words[w];
+	    cardinality -= popcount64(word);
+	    word = val ? (word | mask) : (word & ~mask);
+	    cardinality += popcount64(word);
+	}
+
+	if(cardinality == 0 || cardinality == chunk_bits)
+	    set_full(cardinality != 0);
+	return;
+    }
+
+    if(type == array && _array_set_range(first, last, val))
+	return;
+
+    // run containers(and arrays outgrowing _array_max) are edited as runs, then the cheapest container is kept
+    _to_runs();
+
+    // first run that ends at or after first - 1(adjacent runs merge when setting)
+    std::vector<_run>::iterator b = std::lower_bound(runs.begin(), runs.end(), first,
+						     [val](const _run& r, const std::uint32_t p)
+						     {
+							 return (std::uint32_t)r.last + (val ? 1 : 0) < p;
+						     });
+    std::vector<_run>::iterator e = b;
+    // one past the last run that starts at or before last + 1
+    while(e != runs.end() && (std::uint32_t)e->first <= last + (val ? 1 : 0))
+	++e;
+
+    std::vector<_run> middle;
+    if(val)
+    {
+	std::uint32_t mFirst = first;
+	std::uint32_t mLast = last;
+	if(b != e)
+	{
+	    mFirst = std::min<std::uint32_t>(mFirst, b->first);
+	    mLast = std::max<std::uint32_t>(mLast, (e - 1)->last);
+	}
+	middle.push_back(_run{(std::uint16_t)mFirst, (std::uint16_t)mLast});
+    }
+    else if(b != e)
+    {
+	// keep the parts of the overlapped runs outside [first, last]
+	if(b->first < first)
+	    middle.push_back(_run{b->first, (std::uint16_t)(first - 1)});
+	if((e - 1)->last > last)
+	    middle.push_back(_run{(std::uint16_t)(last + 1), (e - 1)->last});
+    }
+
+    for(std::vector<_run>::iterator it = b; it != e; ++it)
+	cardinality -= (std::uint32_t)it->last - it->first + 1;
+    for(const _run& r : middle)
+	cardinality += (std::uint32_t)r.last - r.first + 1;
+    const std::size_t bIdx = b - runs.begin();
+    runs.erase(b, e);
+    runs.insert(runs.begin() + bIdx, middle.begin(), middle.end());
+
+    optimize(false);
+}
+
+void roaring_bit_vector::_container::optimize(const bool includeBitmap)
+{
+    if(cardinality == 0 || cardinality == chunk_bits)
+    {
+	set_full(cardinality != 0);
+	return;
+    }
+    if(type == bitmap && !includeBitmap)
+	return;
+
+    const std::size_t arrayBytes = cardinality * sizeof(std::uint16_t);
+    const std::size_t runBytes = _run_count() * sizeof(_run);
+
+    if(arrayBytes <= runBytes && arrayBytes <= _bitmap_bytes && cardinality <= _array_max)
+	_to_array();
+    else if(runBytes < arrayBytes && runBytes <= _bitmap_bytes)
+	_to_runs();
+    else
+	_to_bitmap();
+}
+
+std::size_t roaring_bit_vector::_container::memory_usage() const
+{
+    return sizeof(_container)
+	+ positions.capacity() * sizeof(std::uint16_t)
+	+ runs.capacity() * sizeof(_run)
+	+ words.capacity() * sizeof(std::uint64_t);
+}
+
+//**************** roaring_bit_vector ****************
+
+roaring_bit_vector::roaring_bit_vector(const bit_vector& bv) :
+    _curSize(0)
+{
+    const std::size_t size = bv.size();
+    reserve(size);
+    _curSize = size;
+
+    const std::uint64_t* src = bv.data();
+    const std::size_t srcWords = (size + 63) / 64;
+    for(std::size_t c = 0; c < _chunks.size(); c++)
+    {
+	_container& chunk = _chunks[c];
+	const std::size_t wBegin = c * _bitmap_words;
+	const std::size_t wEnd = std::min<std::size_t>(wBegin + _bitmap_words, srcWords);
+
+	chunk.words.assign(_bitmap_words, 0);
+	chunk.type = _container::bitmap;
+	chunk.cardinality = 0;
+	for(std::size_t w = wBegin; w < wEnd; w++)
+	{
+	    chunk.words[w - wBegin] = src[w];
+	    chunk.cardinality += popcount64(src[w]);
+	}
+	chunk.optimize(true);
+    }
+}
+
+void roaring_bit_vector::reserve(const std::size_t capacity)
+{
+    const std::size_t chunkCount = capacity / chunk_bits + (capacity % chunk_bits == 0 ? 0 : 1);
+    if(chunkCount > _chunks.size())
+	_chunks.resize(chunkCount);
+}
+
+void roaring_bit_vector::clear()
+{
+    _chunks.clear();
+    _chunks.shrink_to_fit();
+    _curSize = 0;
+}
+
+void roaring_bit_vector::insert(const std::size_t beginIdx, const std::size_t size, const std::uint8_t bitVal)
+{
+    assert(bitVal <= 1);
+    if(size == 0)
+	return;
+
+    const std::size_t endIdx = beginIdx + size;
+    reserve(endIdx);
+
+    const std::size_t headChunk = beginIdx / chunk_bits;
+    const std::size_t tailChunk = (endIdx - 1) / chunk_bits;
+    for(std::size_t c = headChunk; c <= tailChunk; c++)
+    {
+	const std::size_t base = c * chunk_bits;
+	const std::uint32_t first = (std::uint32_t)(std::max(beginIdx, base) - base);
+	const std::uint32_t last = (std::uint32_t)(std::min(endIdx, base + chunk_bits) - base - 1);
+
+	if(first == 0 && last == chunk_bits - 1)
+	    _chunks[c].set_full(bitVal != 0);
+	else
+	    _chunks[c].set_range(first, last, bitVal != 0);
+    }
+
+    if(_curSize < endIdx)
+	_curSize = endIdx;
+}
+
+std::uint8_t roaring_bit_vector::operator[](const std::size_t index) const
+{
+    const std::size_t c = index / chunk_bits;
+    if(c >= _chunks.size())
+	return 0;
+    return _chunks[c].contains((std::uint32_t)(index % chunk_bits)) ? 1 : 0;
+}
+
+std::size_t roaring_bit_vector::count() const
+{
+    std::size_t ret = 0;
+    for(const _container& c : _chunks)
+	ret += c.cardinality;
+    return ret;
+}
+
+std::size_t roaring_bit_vector::memory_usage() const
+{
+    std::size_t ret = sizeof(roaring_bit_vector);
+    for(const _container& c : _chunks)
+	ret += c.memory_usage();
+    return ret;
+}
+
+void roaring_bit_vector::optimize()
+{
+    for(_container& c : _chunks)
+	c.optimize(true);
+}
+
+bit_vector roaring_bit_vector::to_bit_vector() const
+{
+    bit_vector ret;
+    ret.reserve(_curSize);
+    for_each_run([&ret](const std::size_t beginIdx, const std::size_t size)
+		 {
+		     ret.insert(beginIdx, size, 1);
+		 });
+    // trailing zeros still count to the size
+    if(ret.size() < _curSize)
+	ret.insert(ret.size(), _curSize - ret.size(), 0);
+    return ret;
+}
@@ -0,0 +1,170 @@
+// compressed bit array
+
+#pragma once
+
+#include "type.h"
+#include <vector>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, roaring style compressed bit array, same insert/operator[] interface as bit_vector.
+
+  the bit space is cut into chunks of 2^16 bits, and each chunk picks the cheapest container,
+  - array, sorted 16 bits positions of the set bits(2 bytes per set bit, up to 4096 bits)
+  - run, sorted [start, last] runs of set bits(4 bytes per run)
+  - bitmap, plain 2^16 bits(8KB)
+
+  an all empty or all full chunk costs a handful of bytes, so masks which are mostly
+  empty or mostly full take a tiny fraction of bit_vector's size.
+  array containers are edited in place(binary search, then insert/erase) and keep their run count,
+  so switching to runs or to a bitmap is an O(1) check per insert. run containers are re-chosen on
+  every insert, bitmap containers stay bitmaps until optimize() is called(bitmaps are the fastest to write into).
+  ref: https://arxiv.org/abs/1603.06549
+ */
+class roaring_bit_vector
+{
+public:
+    static constexpr std::size_t chunk_bits = std::size_t(1) << 16;
+    static constexpr std::size_t npos = bit_vector::npos;
+
+    roaring_bit_vector() :
+	_curSize(0)
+	{}
+    explicit roaring_bit_vector(const bit_vector& bv);
+
+    void reserve(const std::size_t capacity);
+    // set [beginIdx, beginIdx + size) to bitVal, grows if needed
+    void insert(const std::size_t beginIdx, const std::size_t size, const std::uint8_t bitVal);
+    std::uint8_t operator[](const std::size_t index) const;
+    bool test(const std::size_t index) const
+	{
+	    return operator[](index) != 0;
+	}
+    void clear();
+
+    std::size_t size() const { return _curSize; }
+    // number of set bits
+    std::size_t count() const;
+    // bytes held by the containers
+    std::size_t memory_usage() const;
+    // convert every container to its cheapest form
+    void optimize();
+
+    bit_vector to_bit_vector() const;
+
+    /*
+     *@brief, visit every maximal run of set bits in increasing order
+     *@param func, void func(const std::size_t beginIdx, const std::size_t size)
+     */
+    template<typename Func>
+    void for_each_run(Func func) const
+	{
+	    std::size_t pendingBegin = npos;
+	    std::size_t pendingEnd = 0;
+	    for(std::size_t c = 0; c < _chunks.size(); c++)
+	    {
+		const std::size_t base = c * chunk_bits;
+		_chunks[c].for_each_run([&](const std::uint32_t first, const std::uint32_t last)
+					{
+					    const std::size_t b = base + first;
+					    const std::size_t e = base + last + 1;
+					    // runs touching at a chunk boundary are merged
+					    if(pendingBegin != npos && pendingEnd == b)
+						pendingEnd = e;
+					    else
+					    {
+						if(pendingBegin != npos)
+						    func(pendingBegin, pendingEnd - pendingBegin);
+						pendingBegin = b;
+						pendingEnd = e;
+					    }
+					});
+	    }
+	    if(pendingBegin != npos)
+		func(pendingBegin, pendingEnd - pendingBegin);
+	}
+private:
+    struct _run
+    {
+	std::uint16_t first;
+	std::uint16_t last;//inclusive
+    };
+
+    struct _container
+    {
+	enum kind
+	{
+	    array = 0, run, bitmap
+	};
+
+	_container() :
+	    type(array),
+	    cardinality(0),
+	    arrayRuns(0)
+	    {}
+
+	bool contains(const std::uint32_t pos) const;
+	// [first, last] to val
+	void set_range(const std::uint32_t first, const std::uint32_t last, const bool val);
+	void set_full(const bool val);
+	void optimize(const bool includeBitmap);
+	std::size_t memory_usage() const;
+
+	template<typename Func>
+	void for_each_run(Func func) const
+	    {
+		if(type == run)
+		{
+		    for(const _run& r : runs)
+			func(r.first, r.last);
+		}
+		else if(type == array)
+		{
+		    std::size_t i = 0;
+		    while(i < positions.size())
+		    {
+			std::size_t j = i;
+			while(j + 1 < positions.size() && positions[j + 1] == positions[j] + 1)
+			    j++;
+			func(positions[i], positions[j]);
+			i = j + 1;
+		    }
+		}
+		else
+		{
+		    std::uint32_t pos = 0;
+		    while(pos < chunk_bits)
+		    {
+			const std::uint32_t first = _next(pos, true);
+			if(first >= chunk_bits)
+			    break;
+			const std::uint32_t end = _next(first, false);
+			func(first, end - 1);
+			pos = end;
+		    }
+		}
+	    }
+
+	// first position >= pos holding val in the bitmap, chunk_bits if none
+	std::uint32_t _next(const std::uint32_t pos, const bool val) const;
+	void _to_runs();
+	void _to_array();
+	void _to_bitmap();
+	std::size_t _run_count() const;
+	// set_range of an array container that stays within _array_max, false(nothing done) otherwise
+	bool _array_set_range(const std::uint32_t first, const std::uint32_t last, const bool val);
+
+	std::uint8_t type;
+	std::uint32_t cardinality;
+	std::uint32_t arrayRuns;// runs of set bits of an array container
+	std::vector<std::uint16_t> positions;
+	std::vector<_run> runs;
+	std::vector<std::uint64_t> words;
+    };
+
+    std::vector<_container> _chunks;
+    std::size_t _curSize;//bit size
+};
+
+GB_PHYSICS_NS_END
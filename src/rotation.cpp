@@ -0,0 +1,28 @@
+#include "rotation.h"
+
+using namespace gb::physics;
+
+static void _sinCos(const float* angles, const std::size_t count, const bool bDegree, float* sin, float* cos,
+		    const sincos_accuracy accuracy, const bool bParallel)
+{
+    assert((angles != nullptr && sin != nullptr && cos != nullptr) || count == 0);
+    const stream_kernels& kernels = streamKernels();
+    auto body = [&](const std::size_t begin, const std::size_t end)
+	{
+	    kernels.sincos(angles + begin, end - begin, bDegree, accuracy, sin + begin, cos + begin);
+	};
+    if(bParallel)
+	parallelFor(count, rotation_parallel_chunk, body);
+    else
+	body(0, count);
+}
+
+void gb::physics::sinCos(const float* radians, const std::size_t count, float* sin, float* cos, const sincos_accuracy accuracy, const bool bParallel)
+{
+    _sinCos(radians, count, false, sin, cos, accuracy, bParallel);
+}
+
+void gb::physics::sinCosDegree(const float* degrees, const std::size_t count, float* sin, float* cos, const sincos_accuracy accuracy, const bool bParallel)
+{
+    _sinCos(degrees, count, true, sin, cos, accuracy, bParallel);
+}
@@ -0,0 +1,159 @@
+// batch sin/cos and batch rotation builders
+
+#pragma once
+
+#include "matrix.h"
+#include "parallel.h"
+#include "stream_kernels.h"
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+  sinCos/sinCosDegree, sin[i] and cos[i] of angles[i], in one pass.
+  T = float runs the dispatched sincos kernel(see stream_kernels.h for the accuracy tiers and the valid range),
+  the degree version folds the conversion into the kernel's range reduction.
+  other T call std::sin/std::cos, accuracy is ignored.
+  angles may be sin or cos. bParallel splits inputs above rotation_parallel_chunk elements across threads.
+*/
+
+static constexpr std::size_t rotation_parallel_chunk = 16 * 1024;
+// angles per sincos call of the builders, their sin/cos stay on the stack
+static constexpr std::size_t rotation_chunk = 256;
+
+template<typename T>
+void sinCosScaled(const T* angles, const std::size_t count, const T scale, T* sin, T* cos, const bool bParallel)
+{
+    assert((angles != nullptr && sin != nullptr && cos != nullptr) || count == 0);
+    auto body = [=](const std::size_t begin, const std::size_t end)
+	{
+	    for(std::size_t i = begin; i < end; i++)
+	    {
+		const T radian = angles[i] * scale;
+		sin[i] = std::sin(radian);
+		cos[i] = std::cos(radian);
+	    }
+	};
+    if(bParallel)
+	parallelFor(count, rotation_parallel_chunk, body);
+    else
+	body(0, count);
+}
+
+template<typename T>
+void sinCos(const T* radians, const std::size_t count, T* sin, T* cos, const sincos_accuracy /*accuracy*/ = sincos_precise, const bool bParallel = false)
+{
+    sinCosScaled<T>(radians, count, (T)1, sin, cos, bParallel);
+}
+template<typename T>
+void sinCosDegree(const T* degrees, const std::size_t count, T* sin, T* cos, const sincos_accuracy /*accuracy*/ = sincos_precise, const bool bParallel = false)
+{
+    sinCosScaled<T>(degrees, count, (T)3.14159265358979323846 / 180, sin, cos, bParallel);
+}
+
+// float versions, see rotation.cpp
+void sinCos(const float* radians, const std::size_t count, float* sin, float* cos, const sincos_accuracy accuracy = sincos_precise, const bool bParallel = false);
+void sinCosDegree(const float* degrees, const std::size_t count, float* sin, float* cos, const sincos_accuracy accuracy = sincos_precise, const bool bParallel = false);
+
+enum rotation_axis : std::uint8_t
+{
+    rotation_x = 0,
+    rotation_y,
+    rotation_z
+};
+
+namespace detail
+{
+    // same matrices as rotateXAxisMat/rotateYAxisMat/rotateZAxisMat
+    template<typename T>
+    mat3<T> axisRotation(const rotation_axis axis, const T s, const T c)
+    {
+	if(axis == rotation_x)
+	    return mat3<T>{{{1, 0, 0}, {0, c, s}, {0, -s, c}}};
+	else if(axis == rotation_y)
+	    return mat3<T>{{{c, 0, -s}, {0, 1, 0}, {s, 0, c}}};
+	else
+	    return mat3<T>{{{c, s, 0}, {-s, c, 0}, {0, 0, 1}}};
+    }
+
+    // Rodrigues, c * I + (1 - c) * a * a^T + s * [a]x, a must be unit
+    template<typename T>
+    mat3<T> axisAngleRotation(const vec3<T>& a, const T s, const T c)
+    {
+	const T t = 1 - c;
+	const T xy = t * a.x * a.y, xz = t * a.x * a.z, yz = t * a.y * a.z;
+	return mat3<T>{{{c + t * a.x * a.x, xy + s * a.z, xz - s * a.y},
+			{xy - s * a.z, c + t * a.y * a.y, yz + s * a.x},
+			    {xz + s * a.y, yz - s * a.x, c + t * a.z * a.z}}};
+    }
+
+    template<typename T>
+    void storeRotation(const mat3<T>& r, mat3<T>& out)
+    {
+	out = r;
+    }
+    template<typename T>
+    void storeRotation(const mat3<T>& r, mat4<T>& out)
+    {
+	out = mat4<T>{{{r[0][0], r[0][1], r[0][2], 0},
+		       {r[1][0], r[1][1], r[1][2], 0},
+			   {r[2][0], r[2][1], r[2][2], 0},
+			       {0, 0, 0, 1}}};
+    }
+    template<typename T>
+    void storeRotation(const mat3<T>& r, affine3<T>& out)
+    {
+	out = affine3<T>{{r[0], r[1], r[2], {0, 0, 0}}};
+    }
+
+    // sin/cos of rotation_chunk angles at a time, then out[i] = make(i, sin, cos)
+    template<typename T, typename Mat, typename Make>
+    void buildRotations(const T* degrees, const std::size_t count, Mat* out, const sincos_accuracy accuracy, const bool bParallel, Make make)
+    {
+	assert((degrees != nullptr && out != nullptr) || count == 0);
+	auto body = [=, &make](const std::size_t begin, const std::size_t end)
+	    {
+		T s[rotation_chunk], c[rotation_chunk];
+		for(std::size_t b = begin; b < end; b += rotation_chunk)
+		{
+		    const std::size_t n = end - b < rotation_chunk ? end - b : rotation_chunk;
+		    sinCosDegree(degrees + b, n, s, c, accuracy);
+		    for(std::size_t k = 0; k < n; k++)
+			storeRotation(make(b + k, s[k], c[k]), out[b + k]);
+		}
+	    };
+	if(bParallel)
+	    parallelFor(count, rotation_parallel_chunk, body);
+	else
+	    body(0, count);
+    }
+}
+
+/*
+ *@brief, out[i] = rotation of degrees[i] about axis, as rotateXAxisMat(and co) would build it.
+ out is a mat3, mat4 or affine3 array, the sin/cos of the whole batch go through sinCosDegree.
+ */
+template<typename T, template<typename> class Mat>
+void rotateAxisMats(const rotation_axis axis, const T* degrees, const std::size_t count, Mat<T>* out,
+		    const sincos_accuracy accuracy = sincos_precise, const bool bParallel = false)
+{
+    detail::buildRotations(degrees, count, out, accuracy, bParallel, [axis](const std::size_t, const T s, const T c)
+			   {
+			       return detail::axisRotation<T>(axis, s, c);
+			   });
+}
+
+/*
+ *@brief, out[i] = rotation of degrees[i] about axes[i](normalized here), same as rotateAxisQuat(axes[i], degrees[i]).
+ */
+template<typename T, template<typename> class Mat>
+void rotateAxisMats(const vec3<T>* axes, const T* degrees, const std::size_t count, Mat<T>* out,
+		    const sincos_accuracy accuracy = sincos_precise, const bool bParallel = false)
+{
+    assert(axes != nullptr || count == 0);
+    detail::buildRotations(degrees, count, out, accuracy, bParallel, [axes](const std::size_t i, const T s, const T c)
+			   {
+			       return detail::axisAngleRotation<T>(axes[i].normalize(), s, c);
+			   });
+}
+
+GB_PHYSICS_NS_END
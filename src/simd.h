@@ -0,0 +1,154 @@
+// simd helpers, shared by bulk kernels
+
+#pragma once
+
+#include "physicsNS.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <limits>
+#include <cmath>
+
+#if defined(__AVX__)
+#define GB_PHYSICS_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GB_PHYSICS_SSE
+#endif
+
+#if defined(GB_PHYSICS_AVX)
+#include <immintrin.h>
+#elif defined(GB_PHYSICS_SSE)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#include <intrin.h>
+#endif
+
+// widest vector register(avx-512) in bytes, every bulk buffer is aligned to this
+#define GB_PHYSICS_SIMD_ALIGNMENT 64
+
+GB_PHYSICS_NS_BEGIN
+
+inline void* aligned_malloc(const std::size_t size, const std::size_t alignment = GB_PHYSICS_SIMD_ALIGNMENT)
+{
+#ifdef _MSC_VER
+    void* ret = _aligned_malloc(size, alignment);
+#else
+    void* ret = nullptr;
+    if(posix_memalign(&ret, alignment, size) != 0)
+	ret = nullptr;
+#endif
+    if(ret == nullptr && size != 0)
+	throw std::bad_alloc();
+    return ret;
+}
+
+inline void aligned_free(void* ptr)
+{
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+inline unsigned popcount64(const std::uint64_t v)
+{
+#ifdef _MSC_VER
+    return (unsigned)__popcnt64(v);
+#else
+    return (unsigned)__builtin_popcountll(v);
+#endif
+}
+
+// index of the lowest set bit, v must not be 0
+inline unsigned ctz64(const std::uint64_t v)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctzll(v);
+#endif
+}
+
+/*
+ *@brief, std allocator handing out GB_PHYSICS_SIMD_ALIGNMENT aligned blocks
+ */
+template<typename T>
+struct aligned_allocator
+{
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind
+    {
+	typedef aligned_allocator<U> other;
+    };
+
+    aligned_allocator() noexcept {}
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U>&) noexcept {}
+
+    T* allocate(const std::size_t n)
+	{
+	    if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+		throw std::bad_alloc();
+	    return static_cast<T*>(aligned_malloc(n * sizeof(T)));
+	}
+    void deallocate(T* p, const std::size_t)
+	{
+	    aligned_free(p);
+	}
+
+    template<typename U>
+    bool operator==(const aligned_allocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const aligned_allocator<U>&) const { return false; }
+};
+
+#if defined(GB_PHYSICS_SSE)
+/*
+  AoS <-> SoA for 4 tightly packed vec3f(12 floats, no alignment needed)
+  x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3  <->  x0..x3 | y0..y3 | z0..z3
+*/
+inline void loadSoA4(const float* p, __m128& x, __m128& y, __m128& z)
+{
+    const __m128 a0 = _mm_loadu_ps(p);
+    const __m128 a1 = _mm_loadu_ps(p + 4);
+    const __m128 a2 = _mm_loadu_ps(p + 8);
+    const __m128 t = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 1, 3, 2));// x2 y2 x3 y3
+    const __m128 u = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 0, 2, 1));// y0 z0 y1 z1
+    x = _mm_shuffle_ps(a0, t, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(u, a2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void storeAoS4(float* p, const __m128 x, const __m128 y, const __m128 z)
+{
+    const __m128 xyLo = _mm_unpacklo_ps(x, y);// x0 y0 x1 y1
+    const __m128 xyHi = _mm_unpackhi_ps(x, y);// x2 y2 x3 y3
+    const __m128 t0 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));// z0 z0 x1 x1
+    const __m128 t1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));// y1 y1 z1 z1
+    const __m128 t2 = _mm_shuffle_ps(z, xyHi, _MM_SHUFFLE(2, 2, 2, 2));// z2 z2 x3 x3
+    const __m128 t3 = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 3, 3, 3));// y3 y3 z3 z3
+    _mm_storeu_ps(p, _mm_shuffle_ps(xyLo, t0, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(t1, xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline float hsum4(const __m128 v)
+{
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+#endif
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,114 @@
+// float packs, a thin uniform face over one register width,
+// kernels are written once against a pack and instantiated for every width the unit's flags allow.
+// loads and stores are unaligned, they cost nothing on aligned data.
+// everything lives in an anonymous namespace so that a unit built with wider -m flags(stream_avx2.cpp, ...)
+// never shares an instance with the baseline ones, include it from kernel .cpp units only, never from a header.
+
+#pragma once
+
+#include "physicsNS.h"
+#include <cstddef>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+GB_PHYSICS_NS_BEGIN
+
+namespace
+{
+    struct _pack1
+    {
+	typedef float type;
+	static constexpr std::size_t width = 1;
+	static type load(const float* p) { return *p; }
+	static void store(float* p, const type v) { *p = v; }
+	static type set1(const float v) { return v; }
+	static type add(const type a, const type b) { return a + b; }
+	static type sub(const type a, const type b) { return a - b; }
+	static type mul(const type a, const type b) { return a * b; }
+	static type div(const type a, const type b) { return a / b; }
+	static type min(const type a, const type b) { return a < b ? a : b; }
+	static type max(const type a, const type b) { return a > b ? a : b; }
+	static type sqrt(const type a) { return sqrtf(a); }
+	// to the nearest integer, ties to even
+	static type round(const type a) { return nearbyintf(a); }
+	// bit l set where lane l of a == b(< b, <= b)
+	static unsigned eq_mask(const type a, const type b) { return a == b ? 1u : 0u; }
+	static unsigned lt_mask(const type a, const type b) { return a < b ? 1u : 0u; }
+	static unsigned le_mask(const type a, const type b) { return a <= b ? 1u : 0u; }
+    };
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    struct _pack4
+    {
+	typedef __m128 type;
+	static constexpr std::size_t width = 4;
+	static type load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, const type v) { _mm_storeu_ps(p, v); }
+	static type set1(const float v) { return _mm_set1_ps(v); }
+	static type add(const type a, const type b) { return _mm_add_ps(a, b); }
+	static type sub(const type a, const type b) { return _mm_sub_ps(a, b); }
+	static type mul(const type a, const type b) { return _mm_mul_ps(a, b); }
+	static type div(const type a, const type b) { return _mm_div_ps(a, b); }
+	static type min(const type a, const type b) { return _mm_min_ps(a, b); }
+	static type max(const type a, const type b) { return _mm_max_ps(a, b); }
+	static type sqrt(const type a) { return _mm_sqrt_ps(a); }
+	// |a| < 2^31
+	static type round(const type a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+	static unsigned eq_mask(const type a, const type b) { return (unsigned)_mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+	static unsigned lt_mask(const type a, const type b) { return (unsigned)_mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+	static unsigned le_mask(const type a, const type b) { return (unsigned)_mm_movemask_ps(_mm_cmple_ps(a, b)); }
+    };
+#endif
+
+#if defined(__AVX__)
+    struct _pack8
+    {
+	typedef __m256 type;
+	static constexpr std::size_t width = 8;
+	static type load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, const type v) { _mm256_storeu_ps(p, v); }
+	static type set1(const float v) { return _mm256_set1_ps(v); }
+	static type add(const type a, const type b) { return _mm256_add_ps(a, b); }
+	static type sub(const type a, const type b) { return _mm256_sub_ps(a, b); }
+	static type mul(const type a, const type b) { return _mm256_mul_ps(a, b); }
+	static type div(const type a, const type b) { return _mm256_div_ps(a, b); }
+	static type min(const type a, const type b) { return _mm256_min_ps(a, b); }
+	static type max(const type a, const type b) { return _mm256_max_ps(a, b); }
+	static type sqrt(const type a) { return _mm256_sqrt_ps(a); }
+	static type round(const type a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static unsigned eq_mask(const type a, const type b) { return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+	static unsigned lt_mask(const type a, const type b) { return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	static unsigned le_mask(const type a, const type b) { return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+    };
+#endif
+
+#if defined(__AVX512F__)
+    struct _pack16
+    {
+	typedef __m512 type;
+	static constexpr std::size_t width = 16;
+	static type load(const float* p) { return _mm512_loadu_ps(p); }
+	static void store(float* p, const type v) { _mm512_storeu_ps(p, v); }
+	static type set1(const float v) { return _mm512_set1_ps(v); }
+	static type add(const type a, const type b) { return _mm512_add_ps(a, b); }
+	static type sub(const type a, const type b) { return _mm512_sub_ps(a, b); }
+	static type mul(const type a, const type b) { return _mm512_mul_ps(a, b); }
+	static type div(const type a, const type b) { return _mm512_div_ps(a, b); }
+	static type min(const type a, const type b) { return _mm512_min_ps(a, b); }
+	static type max(const type a, const type b) { return _mm512_max_ps(a, b); }
+	static type sqrt(const type a) { return _mm512_sqrt_ps(a); }
+	static type round(const type a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static unsigned eq_mask(const type a, const type b) { return (unsigned)_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+	static unsigned lt_mask(const type a, const type b) { return (unsigned)_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static unsigned le_mask(const type a, const type b) { return (unsigned)_mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    };
+#endif
+}
+
+GB_PHYSICS_NS_END
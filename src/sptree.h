@@ -233,43 +233,13 @@ class octree
 public:
     octree(const aabb<_BB_Unit>& bb, octree* parent = nullptr, const std::uint8_t siblingIdx = 0) :
 	_bb(bb)
-	, _childLenSide(_octanBB[0].lenSide)
-	, _centre(_octanBB[7].diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX])
+	, _childLenSide(bb.lenSide / 2)
+	, _centre((bb.diagonal[0] + bb.diagonal[1]) / 2)
 	, _children{ nullptr }
 	, _parent(parent)
 	, _siblingIdx(siblingIdx)
 	, _minOctanLenSide(bb.lenSide / _Depth)
     {
-	const vec3<_BB_Unit>(&diagonal)[2] = bb.diagonal;
-	
-	const vec3<_BB_Unit> centre = (diagonal[0] + diagonal[1]) / 2;
-	const vec3<_BB_Unit> octanLen = bb.lenSide / 2;
-	const vec3<_BB_Unit> lowers[2] = { diagonal[0], centre };
-
-	// store octanBB.lower in (x_l, ((y_l, (z_l, z_u)), (y_u, ...)))(x_u, ...) order
-	// 1st, split by x into (0, 3) (4, 7)
-	// 2nd, split by y into (0, 1) (2, 3) (4, 5) (6, 7)
-	// 3rd, split by z into ...
-	// so the centre of bb is octanBB[7].dia.lower
-	std::uint8_t idx = 0;
-	for (std::uint8_t i = 0; i < 2; i++)
-	    {
-		for (std::uint8_t j = 0; j < 2; j++)
-		    {
-			for (std::uint8_t k = 0; k < 2; k++)
-			    {
-				aabb<_BB_Unit> & octanBB = _octanBB[idx++];
-				octanBB.lenSide = octanLen;
-
-				vec3<_BB_Unit>(&octanDia)[2] = octanBB.diagonal;
-				vec3<_BB_Unit>& lower = octanDia[0];
-				lower.x = lowers[i].x;
-				lower.y = lowers[j].y;
-				lower.z = lowers[k].z;
-				octanDia[1] = lower + octanLen;
-			    }
-		    }
-	    }
     }
     ~octree()
     {
@@ -309,7 +279,7 @@ private:
 	    {
 		const std::uint8_t idx = _getPossiableOctanIdx(ap);
 
-		const aabb<_BB_Unit>& octanBB = _octanBB[idx];
+		const aabb<_BB_Unit> octanBB = _octan(idx);
 
 		// check if octan ctn ele
 		if (_ctn(ele, octanBB))
@@ -345,7 +315,7 @@ private:
 	if (_childLenSide > _minOctanLenSide)
 	    {
 		const std::uint8_t idx = _getPossiableOctanIdx(ap);
-		const aabb<_BB_Unit>& octanBB = _octanBB[idx];
+		const aabb<_BB_Unit> octanBB = _octan(idx);
 		if (_ctn(ele, octanBB))
 		    {
 			octree* & child = _children[idx];
@@ -415,8 +385,8 @@ private:
     void _remove(const _Ele& ele, const vec3<_BB_Unit> & ap)
     {
 	const std::uint8_t idx = _getPossiableOctanIdx(ap);
-	const aabb<_BB_Unit>& octanBB = _octanBB[idx];
-	if(_ctn(ele, octanBB))
+	// the same descent as _insert, leaves never split
+	if(_childLenSide > _minOctanLenSide && _ctn(ele, _octan(idx)))
 	    {
 		octree* & child = _children[idx];
 		assert(child != nullptr);
@@ -459,6 +429,24 @@ public:
 	return ret;
     }
 private:
+    // octan idx lower in (x_l, ((y_l, (z_l, z_u)), (y_u, ...)))(x_u, ...) order
+    // 1st, split by x into (0, 3) (4, 7)
+    // 2nd, split by y into (0, 1) (2, 3) (4, 5) (6, 7)
+    // 3rd, split by z into ...
+    // derived on demand rather than stored, so a node doesn't carry 8 aabbs
+    aabb<_BB_Unit> _octan(const std::uint8_t idx) const
+    {
+	const vec3<_BB_Unit>& lower = _bb.diagonal[GB_PHYSICS_DIAGONAL_LOWER_IDX];
+	aabb<_BB_Unit> octanBB;
+	octanBB.lenSide = _childLenSide;
+
+	vec3<_BB_Unit>(&octanDia)[2] = octanBB.diagonal;
+	octanDia[0].x = (idx & 4) ? _centre.x : lower.x;
+	octanDia[0].y = (idx & 2) ? _centre.y : lower.y;
+	octanDia[0].z = (idx & 1) ? _centre.z : lower.z;
+	octanDia[1] = octanDia[0] + _childLenSide;
+	return octanBB;
+    }
     std::uint8_t _getPossiableOctanIdx(const vec3<_BB_Unit>& ap) const
     {
 	// check which octanBB is the ele.centre in
@@ -472,16 +460,9 @@ private:
 private:
     std::set<_Ele> _eles;
     aabb<_BB_Unit> _bb;
-    // (xl, ((yl, z[l,u]), (yu, z[l, u])))(xu, ...)
-    // for(int i = 0; i <2; i ++)
-    // 	{
-    // 	    for j
-    // 		for k
-    // 		    octanbb.l[idx++] = ls.vec3[i][j][k]
-    // 	}
-    aabb<_BB_Unit> _octanBB[8];
-    const vec3<_BB_Unit> & _childLenSide;
-    const vec3<_BB_Unit> & _centre;
+    const vec3<_BB_Unit> _childLenSide;
+    // the lower corner of octan 7
+    const vec3<_BB_Unit> _centre;
     octree* _children[8];
     
     octree* _parent;
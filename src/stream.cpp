@@ -0,0 +1,100 @@
+#include "stream.h"
+#include "stream_kernels.h"
+
+using namespace gb::physics;
+
+/*
+  the float kernels are built once per instruction set(stream_sse2.cpp, stream_avx2.cpp, stream_avx512.cpp)
+  and picked at run time from activeSimdLevel().
+  sse4.1 brings nothing to these kernels, it runs the sse2 ones.
+*/
+
+const stream_kernels& gb::physics::streamKernels()
+{
+    static const stream_kernels* const byLevel[(std::size_t)simd_level::count] =
+	{
+	    streamKernelsScalar(),
+	    streamKernelsSSE2(),
+	    streamKernelsSSE2(),
+	    streamKernelsAVX2(),
+	    streamKernelsAVX512()
+	};
+    return selectKernels(byLevel);
+}
+
+static inline soa3f_cref _cref(const vec3f_stream& s)
+{
+    return soa3f_cref{s.x(), s.y(), s.z()};
+}
+
+static inline soa3f_ref _ref(vec3f_stream& s)
+{
+    return soa3f_ref{s.x(), s.y(), s.z()};
+}
+
+void gb::physics::add(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    streamKernels().add(_cref(a), _cref(b), _ref(out), count);
+}
+
+void gb::physics::sub(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    streamKernels().sub(_cref(a), _cref(b), _ref(out), count);
+}
+
+void gb::physics::scale(const vec3f_stream& a, const float scalar, vec3f_stream& out)
+{
+    const std::size_t count = a.size();
+    out.resize(count);
+    streamKernels().scale(_cref(a), scalar, _ref(out), count);
+}
+
+void gb::physics::dot(const vec3f_stream& a, const vec3f_stream& b, float* out)
+{
+    assert(a.size() == b.size());
+    assert(out != nullptr || a.empty());
+    streamKernels().dot(_cref(a), _cref(b), out, a.size());
+}
+
+void gb::physics::cross(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    streamKernels().cross(_cref(a), _cref(b), _ref(out), count);
+}
+
+void gb::physics::normalize(const vec3f_stream& a, vec3f_stream& out)
+{
+    const std::size_t count = a.size();
+    out.resize(count);
+    streamKernels().normalize(_cref(a), _ref(out), count);
+}
+
+void gb::physics::sqDistance(const vec3f_stream& a, const vec3f& point, float* out)
+{
+    assert(out != nullptr || a.empty());
+    streamKernels().sq_distance(_cref(a), point.data(), out, a.size());
+}
+
+vec3f gb::physics::reduceMin(const vec3f_stream& a)
+{
+    assert(!a.empty());
+    vec3f ret;
+    streamKernels().reduce_min(_cref(a), a.size(), ret.data());
+    return ret;
+}
+
+vec3f gb::physics::reduceMax(const vec3f_stream& a)
+{
+    assert(!a.empty());
+    vec3f ret;
+    streamKernels().reduce_max(_cref(a), a.size(), ret.data());
+    return ret;
+}
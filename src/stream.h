@@ -0,0 +1,287 @@
+// structure of arrays containers and their bulk kernels
+
+#pragma once
+
+#include "type.h"
+#include "simd.h"
+#include <vector>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+ *@brief, vec3 stream in SoA layout,
+ x, y, z components are kept in three separate GB_PHYSICS_SIMD_ALIGNMENT aligned arrays,
+ so that bulk kernels can load a full register of one component per instruction.
+
+  AoS: x0 y0 z0 x1 y1 z1 x2 y2 z2 ...
+  SoA: x0 x1 x2 ...
+       y0 y1 y2 ...
+       z0 z1 z2 ...
+ */
+template<typename T>
+class vec3_stream
+{
+public:
+    typedef std::vector<T, aligned_allocator<T>> component_type;
+
+    vec3_stream(){}
+    explicit vec3_stream(const std::size_t size):
+	_x(size),
+	_y(size),
+	_z(size)
+	{}
+    vec3_stream(const vec3<T>* data, const std::size_t count)
+	{
+	    assign(data, count);
+	}
+    vec3_stream(const std::vector<vec3<T>>& v)
+	{
+	    assign(v.data(), v.size());
+	}
+
+    void assign(const vec3<T>* data, const std::size_t count)
+	{
+	    assert(data != nullptr || count == 0);
+	    resize(count);
+	    T* x = _x.data();
+	    T* y = _y.data();
+	    T* z = _z.data();
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		const vec3<T>& v = data[i];
+		x[i] = v.x;
+		y[i] = v.y;
+		z[i] = v.z;
+	    }
+	}
+
+    // scatter back to AoS, out must hold size() elements
+    void store(vec3<T>* out) const
+	{
+	    assert(out != nullptr || size() == 0);
+	    const std::size_t count = size();
+	    const T* x = _x.data();
+	    const T* y = _y.data();
+	    const T* z = _z.data();
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		vec3<T>& v = out[i];
+		v.x = x[i];
+		v.y = y[i];
+		v.z = z[i];
+	    }
+	}
+
+    std::vector<vec3<T>> to_vector() const
+	{
+	    std::vector<vec3<T>> ret(size());
+	    store(ret.data());
+	    return ret;
+	}
+    operator std::vector<vec3<T>>() const
+	{
+	    return to_vector();
+	}
+
+    void resize(const std::size_t size)
+	{
+	    _x.resize(size);
+	    _y.resize(size);
+	    _z.resize(size);
+	}
+    void reserve(const std::size_t capacity)
+	{
+	    _x.reserve(capacity);
+	    _y.reserve(capacity);
+	    _z.reserve(capacity);
+	}
+    void push_back(const vec3<T>& v)
+	{
+	    _x.push_back(v.x);
+	    _y.push_back(v.y);
+	    _z.push_back(v.z);
+	}
+    void clear()
+	{
+	    _x.clear();
+	    _y.clear();
+	    _z.clear();
+	}
+
+    std::size_t size() const { return _x.size(); }
+    bool empty() const { return _x.empty(); }
+
+    vec3<T> operator[](const std::size_t idx) const
+	{
+	    assert(idx < size());
+	    return vec3<T>(_x[idx], _y[idx], _z[idx]);
+	}
+    void set(const std::size_t idx, const vec3<T>& v)
+	{
+	    assert(idx < size());
+	    _x[idx] = v.x;
+	    _y[idx] = v.y;
+	    _z[idx] = v.z;
+	}
+
+    T* x() { return _x.data(); }
+    T* y() { return _y.data(); }
+    T* z() { return _z.data(); }
+    const T* x() const { return _x.data(); }
+    const T* y() const { return _y.data(); }
+    const T* z() const { return _z.data(); }
+private:
+    component_type _x;
+    component_type _y;
+    component_type _z;
+};
+
+typedef vec3_stream<float> vec3f_stream;
+
+/*
+  bulk kernels
+  out may alias any input, sizes must match(out is resized to fit)
+  T = float has SSE2/AVX2/AVX-512 versions picked at run time, see cpu.h
+*/
+
+template<typename T>
+void add(const vec3_stream<T>& a, const vec3_stream<T>& b, vec3_stream<T>& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	out.x()[i] = a.x()[i] + b.x()[i];
+	out.y()[i] = a.y()[i] + b.y()[i];
+	out.z()[i] = a.z()[i] + b.z()[i];
+    }
+}
+
+template<typename T>
+void sub(const vec3_stream<T>& a, const vec3_stream<T>& b, vec3_stream<T>& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	out.x()[i] = a.x()[i] - b.x()[i];
+	out.y()[i] = a.y()[i] - b.y()[i];
+	out.z()[i] = a.z()[i] - b.z()[i];
+    }
+}
+
+template<typename T>
+void scale(const vec3_stream<T>& a, const T scalar, vec3_stream<T>& out)
+{
+    const std::size_t count = a.size();
+    out.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	out.x()[i] = a.x()[i] * scalar;
+	out.y()[i] = a.y()[i] * scalar;
+	out.z()[i] = a.z()[i] * scalar;
+    }
+}
+
+/*
+ *@param out, must hold a.size() elements
+ */
+template<typename T>
+void dot(const vec3_stream<T>& a, const vec3_stream<T>& b, T* out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    for(std::size_t i = 0; i < count; i++)
+	out[i] = a.x()[i] * b.x()[i] + a.y()[i] * b.y()[i] + a.z()[i] * b.z()[i];
+}
+
+template<typename T>
+void cross(const vec3_stream<T>& a, const vec3_stream<T>& b, vec3_stream<T>& out)
+{
+    assert(a.size() == b.size());
+    const std::size_t count = a.size();
+    out.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const T ax = a.x()[i], ay = a.y()[i], az = a.z()[i];
+	const T bx = b.x()[i], by = b.y()[i], bz = b.z()[i];
+	out.x()[i] = ay * bz - az * by;
+	out.y()[i] = az * bx - ax * bz;
+	out.z()[i] = ax * by - ay * bx;
+    }
+}
+
+template<typename T>
+void normalize(const vec3_stream<T>& a, vec3_stream<T>& out)
+{
+    const std::size_t count = a.size();
+    out.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const T x = a.x()[i], y = a.y()[i], z = a.z()[i];
+	const T oneOverMag = ((T)1) / std::sqrt(x * x + y * y + z * z);
+	out.x()[i] = x * oneOverMag;
+	out.y()[i] = y * oneOverMag;
+	out.z()[i] = z * oneOverMag;
+    }
+}
+
+/*
+ *@brief, squared distance from every element to point
+ *@param out, must hold a.size() elements
+ */
+template<typename T>
+void sqDistance(const vec3_stream<T>& a, const vec3<T>& point, T* out)
+{
+    const std::size_t count = a.size();
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const T dx = a.x()[i] - point.x, dy = a.y()[i] - point.y, dz = a.z()[i] - point.z;
+	out[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+// component-wise min/max over the whole stream, a must not be empty
+template<typename T>
+vec3<T> reduceMin(const vec3_stream<T>& a)
+{
+    assert(!a.empty());
+    vec3<T> ret = a[0];
+    const std::size_t count = a.size();
+    for(std::size_t i = 1; i < count; i++)
+    {
+	if(a.x()[i] < ret.x) ret.x = a.x()[i];
+	if(a.y()[i] < ret.y) ret.y = a.y()[i];
+	if(a.z()[i] < ret.z) ret.z = a.z()[i];
+    }
+    return ret;
+}
+
+template<typename T>
+vec3<T> reduceMax(const vec3_stream<T>& a)
+{
+    assert(!a.empty());
+    vec3<T> ret = a[0];
+    const std::size_t count = a.size();
+    for(std::size_t i = 1; i < count; i++)
+    {
+	if(a.x()[i] > ret.x) ret.x = a.x()[i];
+	if(a.y()[i] > ret.y) ret.y = a.y()[i];
+	if(a.z()[i] > ret.z) ret.z = a.z()[i];
+    }
+    return ret;
+}
+
+void add(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out);
+void sub(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out);
+void scale(const vec3f_stream& a, const float scalar, vec3f_stream& out);
+void dot(const vec3f_stream& a, const vec3f_stream& b, float* out);
+void cross(const vec3f_stream& a, const vec3f_stream& b, vec3f_stream& out);
+void normalize(const vec3f_stream& a, vec3f_stream& out);
+void sqDistance(const vec3f_stream& a, const vec3f& point, float* out);
+vec3f reduceMin(const vec3f_stream& a);
+vec3f reduceMax(const vec3f_stream& a);
+
+GB_PHYSICS_NS_END
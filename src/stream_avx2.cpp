@@ -0,0 +1,11 @@
+// built with avx2 flags, see CMakeLists.txt
+#include "stream_kernels.inl"
+
+const gb::physics::stream_kernels* gb::physics::streamKernelsAVX2()
+{
+#if defined(__AVX2__)
+    return _stream_kernels<_pack8>();
+#else
+    return nullptr;
+#endif
+}
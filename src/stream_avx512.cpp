@@ -0,0 +1,11 @@
+// built with avx-512f flags, see CMakeLists.txt
+#include "stream_kernels.inl"
+
+const gb::physics::stream_kernels* gb::physics::streamKernelsAVX512()
+{
+#if defined(__AVX512F__)
+    return _stream_kernels<_pack16>();
+#else
+    return nullptr;
+#endif
+}
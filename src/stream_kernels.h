@@ -0,0 +1,101 @@
+// per instruction set vec3f stream kernels, see cpu.h for the dispatch
+
+#pragma once
+
+#include "physicsNS.h"
+#include "cpu.h"
+#include <cstddef>
+#include <cstdint>
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+  raw component pointers, so that the per isa translation units(built with their own -m/arch flags)
+  include nothing with external inline functions which could leak wider instructions into the rest
+*/
+struct soa3f_cref
+{
+    const float* x;
+    const float* y;
+    const float* z;
+};
+struct soa3f_ref
+{
+    float* x;
+    float* y;
+    float* z;
+};
+
+struct stream_kernels
+{
+    void (*add)(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count);
+    void (*sub)(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count);
+    void (*scale)(const soa3f_cref a, const float scalar, const soa3f_ref out, const std::size_t count);
+    void (*dot)(const soa3f_cref a, const soa3f_cref b, float* out, const std::size_t count);
+    void (*cross)(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count);
+    void (*normalize)(const soa3f_cref a, const soa3f_ref out, const std::size_t count);
+    // count must not be 0, out: x y z
+    void (*reduce_min)(const soa3f_cref a, const std::size_t count, float out[3]);
+    void (*reduce_max)(const soa3f_cref a, const std::size_t count, float out[3]);
+    /*
+     *@brief, out = m * in, m column major(m[col * 4 + row]), mode: transform_mode
+     */
+    void (*transform)(const float* m, const std::uint8_t mode, const soa3f_cref in, const soa3f_ref out, const std::size_t count);
+    /*
+     *@brief, whole blocks of mat4_stream_lanes matrices(see mat4_stream), in and out may be the same.
+     singular gets one mask per block, bit l set where the determinant of lane l is 0(its inverse is then meaningless)
+     */
+    void (*mat4_inverse)(const float* in, const std::size_t blocks, float* out, std::uint16_t* singular);
+    // out: mat4_stream_lanes determinants per block
+    void (*mat4_determinant)(const float* in, const std::size_t blocks, float* out);
+    /*
+     *@brief, sin and cos of in[i], radians(|in[i]| < 1e5) or degrees(|in[i]| < 1e7), accuracy: sincos_accuracy.
+     in may be sin or cos
+     */
+    void (*sincos)(const float* in, const std::size_t count, const bool bDegree, const std::uint8_t accuracy, float* sin, float* cos);
+    /*
+     *@brief, one query against count packs of aabb_pack_lanes boxes(see aabb_pack), one mask per pack.
+     aabb query: lower x y z, upper x y z. sphere query: centre x y z, radius
+     */
+    void (*aabb_overlap)(const float* packs, const std::size_t count, const float query[6], std::uint16_t* masks);
+    void (*sphere_overlap)(const float* packs, const std::size_t count, const float query[4], std::uint16_t* masks);
+    // bounds of count(not 0) interleaved x y z points, out: lower x y z, upper x y z
+    void (*points_bounds)(const float* xyz, const std::size_t count, float out[6]);
+    // out[i] = squared distance from a[i] to point(x y z)
+    void (*sq_distance)(const soa3f_cref a, const float point[3], float* out, const std::size_t count);
+};
+
+/*
+  mat4 batches are stored in blocks of mat4_stream_lanes matrices, element j(col * 4 + row) of lane l
+  at block[j * mat4_stream_lanes + l], one register of any level holds the same element of 4, 8 or 16 matrices
+*/
+static constexpr std::size_t mat4_stream_lanes = 16;
+
+// boxes per pack of the overlap kernels, a pack is 6 rows(lower x y z, upper x y z) of aabb_pack_lanes floats
+static constexpr std::size_t aabb_pack_lanes = 16;
+
+// how a vec3 is widened before the mat4 product
+enum transform_mode : std::uint8_t
+{
+    transform_point = 0,	// w = 1, w of the result is ignored
+    transform_direction,	// w = 0, translation is skipped
+    transform_projective	// w = 1, then divided by the resulting w
+};
+
+// error tiers of the sincos kernel(absolute, |sin| and |cos| <= 1)
+enum sincos_accuracy : std::uint8_t
+{
+    sincos_precise = 0,	// < 3e-7, Cephes sinf/cosf polynomials
+    sincos_fast		// < 5e-5, one term less in each polynomial
+};
+
+// tables built into this binary, nullptr if the compiler can't target the level
+const stream_kernels* streamKernelsScalar();
+const stream_kernels* streamKernelsSSE2();
+const stream_kernels* streamKernelsAVX2();
+const stream_kernels* streamKernelsAVX512();
+
+// table for activeSimdLevel()
+const stream_kernels& streamKernels();
+
+GB_PHYSICS_NS_END
@@ -0,0 +1,629 @@
+// vec3f stream kernel bodies, included once per instruction set translation unit.
+// everything lives in an anonymous namespace so every unit keeps its own copy.
+
+#include "stream_kernels.h"
+#include "simd_packs.inl"
+#include <cstdint>
+#include <math.h>
+
+namespace
+{
+    using namespace gb::physics;
+
+    /*
+      every kernel walks full registers and leaves the tail(count % Pack::width) to _pack1,
+      no fma so that every level gives the same bits.
+    */
+    template<typename Pack>
+    void _add(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count)
+    {
+	std::size_t i = 0;
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    Pack::store(out.x + i, Pack::add(Pack::load(a.x + i), Pack::load(b.x + i)));
+	    Pack::store(out.y + i, Pack::add(Pack::load(a.y + i), Pack::load(b.y + i)));
+	    Pack::store(out.z + i, Pack::add(Pack::load(a.z + i), Pack::load(b.z + i)));
+	}
+	for(; i < count; i++)
+	{
+	    out.x[i] = a.x[i] + b.x[i];
+	    out.y[i] = a.y[i] + b.y[i];
+	    out.z[i] = a.z[i] + b.z[i];
+	}
+    }
+
+    template<typename Pack>
+    void _sub(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count)
+    {
+	std::size_t i = 0;
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    Pack::store(out.x + i, Pack::sub(Pack::load(a.x + i), Pack::load(b.x + i)));
+	    Pack::store(out.y + i, Pack::sub(Pack::load(a.y + i), Pack::load(b.y + i)));
+	    Pack::store(out.z + i, Pack::sub(Pack::load(a.z + i), Pack::load(b.z + i)));
+	}
+	for(; i < count; i++)
+	{
+	    out.x[i] = a.x[i] - b.x[i];
+	    out.y[i] = a.y[i] - b.y[i];
+	    out.z[i] = a.z[i] - b.z[i];
+	}
+    }
+
+    template<typename Pack>
+    void _scale(const soa3f_cref a, const float scalar, const soa3f_ref out, const std::size_t count)
+    {
+	const typename Pack::type s = Pack::set1(scalar);
+	std::size_t i = 0;
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    Pack::store(out.x + i, Pack::mul(Pack::load(a.x + i), s));
+	    Pack::store(out.y + i, Pack::mul(Pack::load(a.y + i), s));
+	    Pack::store(out.z + i, Pack::mul(Pack::load(a.z + i), s));
+	}
+	for(; i < count; i++)
+	{
+	    out.x[i] = a.x[i] * scalar;
+	    out.y[i] = a.y[i] * scalar;
+	    out.z[i] = a.z[i] * scalar;
+	}
+    }
+
+    template<typename Pack>
+    typename Pack::type _dot(const soa3f_cref a, const soa3f_cref b, const std::size_t i)
+    {
+	return Pack::add(Pack::add(Pack::mul(Pack::load(a.x + i), Pack::load(b.x + i)),
+				   Pack::mul(Pack::load(a.y + i), Pack::load(b.y + i))),
+			 Pack::mul(Pack::load(a.z + i), Pack::load(b.z + i)));
+    }
+
+    template<typename Pack>
+    void _dot(const soa3f_cref a, const soa3f_cref b, float* out, const std::size_t count)
+    {
+	std::size_t i = 0;
+	for(; i + Pack::width <= count; i += Pack::width)
+	    Pack::store(out + i, _dot<Pack>(a, b, i));
+	for(; i < count; i++)
+	    _pack1::store(out + i, _dot<_pack1>(a, b, i));
+    }
+
+    template<typename Pack>
+    void _cross(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, std::size_t i, const std::size_t count)
+    {
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    const typename Pack::type ax = Pack::load(a.x + i), ay = Pack::load(a.y + i), az = Pack::load(a.z + i);
+	    const typename Pack::type bx = Pack::load(b.x + i), by = Pack::load(b.y + i), bz = Pack::load(b.z + i);
+	    Pack::store(out.x + i, Pack::sub(Pack::mul(ay, bz), Pack::mul(az, by)));
+	    Pack::store(out.y + i, Pack::sub(Pack::mul(az, bx), Pack::mul(ax, bz)));
+	    Pack::store(out.z + i, Pack::sub(Pack::mul(ax, by), Pack::mul(ay, bx)));
+	}
+	if(Pack::width != 1)
+	    _cross<_pack1>(a, b, out, i, count);
+    }
+
+    template<typename Pack>
+    void _cross(const soa3f_cref a, const soa3f_cref b, const soa3f_ref out, const std::size_t count)
+    {
+	_cross<Pack>(a, b, out, 0, count);
+    }
+
+    template<typename Pack>
+    void _normalize(const soa3f_cref a, const soa3f_ref out, std::size_t i, const std::size_t count)
+    {
+	const typename Pack::type one = Pack::set1(1.0f);
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    const typename Pack::type x = Pack::load(a.x + i), y = Pack::load(a.y + i), z = Pack::load(a.z + i);
+	    const typename Pack::type oneOverMag = Pack::div(one, Pack::sqrt(Pack::add(Pack::add(Pack::mul(x, x), Pack::mul(y, y)), Pack::mul(z, z))));
+	    Pack::store(out.x + i, Pack::mul(x, oneOverMag));
+	    Pack::store(out.y + i, Pack::mul(y, oneOverMag));
+	    Pack::store(out.z + i, Pack::mul(z, oneOverMag));
+	}
+	if(Pack::width != 1)
+	    _normalize<_pack1>(a, out, i, count);
+    }
+
+    template<typename Pack>
+    void _normalize(const soa3f_cref a, const soa3f_ref out, const std::size_t count)
+    {
+	_normalize<Pack>(a, out, 0, count);
+    }
+
+    template<typename Pack, bool bMin>
+    void _reduce(const soa3f_cref a, const std::size_t count, float out[3])
+    {
+	const float* comps[3] = {a.x, a.y, a.z};
+	std::size_t i = 1;
+	for(std::uint8_t c = 0; c < 3; c++)
+	    out[c] = comps[c][0];
+
+	if(count >= Pack::width)
+	{
+	    typename Pack::type r[3] = {Pack::load(a.x), Pack::load(a.y), Pack::load(a.z)};
+	    for(i = Pack::width; i + Pack::width <= count; i += Pack::width)
+	    {
+		for(std::uint8_t c = 0; c < 3; c++)
+		    r[c] = bMin ? Pack::min(r[c], Pack::load(comps[c] + i)) : Pack::max(r[c], Pack::load(comps[c] + i));
+	    }
+
+	    float lanes[Pack::width];
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		Pack::store(lanes, r[c]);
+		for(std::size_t l = 0; l < Pack::width; l++)
+		{
+		    if(bMin ? lanes[l] < out[c] : lanes[l] > out[c])
+			out[c] = lanes[l];
+		}
+	    }
+	}
+
+	for(; i < count; i++)
+	{
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		if(bMin ? comps[c][i] < out[c] : comps[c][i] > out[c])
+		    out[c] = comps[c][i];
+	    }
+	}
+    }
+
+    template<typename Pack, std::uint8_t Mode>
+    void _transform(const float* m, const soa3f_cref in, const soa3f_ref out, std::size_t i, const std::size_t count)
+    {
+	typename Pack::type c[16];
+	for(std::uint8_t j = 0; j < 16; j++)
+	    c[j] = Pack::set1(m[j]);
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    const typename Pack::type x = Pack::load(in.x + i), y = Pack::load(in.y + i), z = Pack::load(in.z + i);
+	    typename Pack::type r[3];
+	    for(std::uint8_t row = 0; row < 3; row++)
+	    {
+		r[row] = Pack::add(Pack::add(Pack::mul(c[row], x), Pack::mul(c[4 + row], y)), Pack::mul(c[8 + row], z));
+		if(Mode != transform_direction)
+		    r[row] = Pack::add(r[row], c[12 + row]);
+	    }
+	    if(Mode == transform_projective)
+	    {
+		const typename Pack::type w = Pack::add(Pack::add(Pack::add(Pack::mul(c[3], x), Pack::mul(c[7], y)), Pack::mul(c[11], z)), c[15]);
+		for(std::uint8_t row = 0; row < 3; row++)
+		    r[row] = Pack::div(r[row], w);
+	    }
+	    Pack::store(out.x + i, r[0]);
+	    Pack::store(out.y + i, r[1]);
+	    Pack::store(out.z + i, r[2]);
+	}
+	if(Pack::width != 1)
+	    _transform<_pack1, Mode>(m, in, out, i, count);
+    }
+
+    template<typename Pack>
+    void _transform(const float* m, const std::uint8_t mode, const soa3f_cref in, const soa3f_ref out, const std::size_t count)
+    {
+	if(mode == transform_point)
+	    _transform<Pack, transform_point>(m, in, out, 0, count);
+	else if(mode == transform_direction)
+	    _transform<Pack, transform_direction>(m, in, out, 0, count);
+	else
+	    _transform<Pack, transform_projective>(m, in, out, 0, count);
+    }
+
+    /*
+      x = j * pi / 2 + r, |r| <= pi / 4, the quadrant j mod 4 swaps and negates the two polynomials.
+      radians: pi / 2 split in 4 parts(Cody-Waite), the first 3 have at most 8 significant bits
+      so that j * part is exact for |j| < 2^16(|x| < 1e5), the last one carries the remaining bits.
+      degrees: reduced by 90 before the conversion, in - j * 90 is exact, so the result only carries
+      the rounding of r * pi / 180(sin(180) is 0, cos(90) is 0).
+      the quadrant is computed with float ops only: q = j - 4 * floor(j / 4), b1 = q >= 2, b0 = q - 2 * b1.
+      precise: Cephes sinf/cosf polynomials, fast: Taylor to r^5/r^6.
+    */
+    template<typename Pack, bool Precise, bool Degree>
+    void _sincos(const float* in, float* sinOut, float* cosOut, std::size_t i, const std::size_t count)
+    {
+	typedef typename Pack::type type;
+	const type one = Pack::set1(1.0f);
+	const type two = Pack::set1(2.0f);
+	const type four = Pack::set1(4.0f);
+	for(; i + Pack::width <= count; i += Pack::width)
+	{
+	    const type x = Pack::load(in + i);
+	    type j, r;
+	    if(Degree)
+	    {
+		j = Pack::round(Pack::mul(x, Pack::set1(1.0f / 90)));
+		r = Pack::mul(Pack::sub(x, Pack::mul(j, Pack::set1(90.0f))), Pack::set1(0.0174532925199432958f));
+	    }
+	    else
+	    {
+		j = Pack::round(Pack::mul(x, Pack::set1(0.636619772367581343f)));
+		r = Pack::sub(x, Pack::mul(j, Pack::set1(1.5703125f)));
+		r = Pack::sub(r, Pack::mul(j, Pack::set1(4.825592041015625e-4f)));
+		r = Pack::sub(r, Pack::mul(j, Pack::set1(1.26659870147705078125e-6f)));
+		r = Pack::sub(r, Pack::mul(j, Pack::set1(9.920936294705029e-10f)));
+	    }
+	    const type r2 = Pack::mul(r, r);
+
+	    type s, c;
+	    if(Precise)
+	    {
+		s = Pack::add(Pack::mul(Pack::set1(-1.9515295891e-4f), r2), Pack::set1(8.3321608736e-3f));
+		s = Pack::add(Pack::mul(s, r2), Pack::set1(-1.6666654611e-1f));
+		s = Pack::add(Pack::mul(Pack::mul(s, r2), r), r);
+		c = Pack::add(Pack::mul(Pack::set1(2.443315711809948e-5f), r2), Pack::set1(-1.388731625493765e-3f));
+		c = Pack::add(Pack::mul(c, r2), Pack::set1(4.166664568298827e-2f));
+		c = Pack::add(Pack::sub(Pack::mul(Pack::mul(c, r2), r2), Pack::mul(Pack::set1(0.5f), r2)), one);
+	    }
+	    else
+	    {
+		s = Pack::add(Pack::mul(Pack::set1(1.0f / 120), r2), Pack::set1(-1.0f / 6));
+		s = Pack::add(Pack::mul(Pack::mul(s, r2), r), r);
+		c = Pack::add(Pack::mul(Pack::set1(-1.0f / 720), r2), Pack::set1(1.0f / 24));
+		c = Pack::add(Pack::mul(c, r2), Pack::set1(-0.5f));
+		c = Pack::add(Pack::mul(c, r2), one);
+	    }
+
+	    // j / 4 is exact, round(j / 4 - 0.375) is its floor
+	    const type q = Pack::sub(j, Pack::mul(four, Pack::round(Pack::sub(Pack::mul(j, Pack::set1(0.25f)), Pack::set1(0.375f)))));
+	    const type b1 = Pack::round(Pack::sub(Pack::mul(q, Pack::set1(0.5f)), Pack::set1(0.25f)));
+	    const type b0 = Pack::sub(q, Pack::mul(two, b1));
+	    const type b0n = Pack::sub(one, b0);
+	    const type sign = Pack::sub(one, Pack::mul(two, b1));
+	    Pack::store(sinOut + i, Pack::mul(sign, Pack::add(Pack::mul(b0n, s), Pack::mul(b0, c))));
+	    Pack::store(cosOut + i, Pack::mul(sign, Pack::sub(Pack::mul(b0n, c), Pack::mul(b0, s))));
+	}
+	if(Pack::width != 1)
+	    _sincos<_pack1, Precise, Degree>(in, sinOut, cosOut, i, count);
+    }
+
+    template<typename Pack>
+    void _sincos(const float* in, const std::size_t count, const bool bDegree, const std::uint8_t accuracy, float* sinOut, float* cosOut)
+    {
+	if(accuracy == sincos_fast)
+	{
+	    if(bDegree)
+		_sincos<Pack, false, true>(in, sinOut, cosOut, 0, count);
+	    else
+		_sincos<Pack, false, false>(in, sinOut, cosOut, 0, count);
+	}
+	else
+	{
+	    if(bDegree)
+		_sincos<Pack, true, true>(in, sinOut, cosOut, 0, count);
+	    else
+		_sincos<Pack, true, false>(in, sinOut, cosOut, 0, count);
+	}
+    }
+
+    /*
+      mat4 lanes, e[j] holds element j(col * 4 + row) of Pack::width matrices.
+      a lane group whose last rows are all(0, 0, 0, 1) takes the affine path:
+      3x3 inverse by cofactors and -inv(L) * t, the general path expands by 2x2 minors.
+    */
+    template<typename Pack>
+    bool _mat4_affine(const typename Pack::type e[16])
+    {
+	const unsigned full = (unsigned)((1u << Pack::width) - 1);
+	const typename Pack::type zero = Pack::set1(0.0f);
+	return (Pack::eq_mask(e[3], zero) & Pack::eq_mask(e[7], zero)
+		& Pack::eq_mask(e[11], zero) & Pack::eq_mask(e[15], Pack::set1(1.0f))) == full;
+    }
+
+    // a(r, c) = e[c * 4 + r]
+    template<typename Pack>
+    struct _mat4_minors
+    {
+	typedef typename Pack::type type;
+
+	explicit _mat4_minors(const type e[16])
+	    {
+#define GB_A(r, c) e[(c) * 4 + (r)]
+		s[0] = Pack::sub(Pack::mul(GB_A(0, 0), GB_A(1, 1)), Pack::mul(GB_A(1, 0), GB_A(0, 1)));
+		s[1] = Pack::sub(Pack::mul(GB_A(0, 0), GB_A(1, 2)), Pack::mul(GB_A(1, 0), GB_A(0, 2)));
+		s[2] = Pack::sub(Pack::mul(GB_A(0, 0), GB_A(1, 3)), Pack::mul(GB_A(1, 0), GB_A(0, 3)));
+		s[3] = Pack::sub(Pack::mul(GB_A(0, 1), GB_A(1, 2)), Pack::mul(GB_A(1, 1), GB_A(0, 2)));
+		s[4] = Pack::sub(Pack::mul(GB_A(0, 1), GB_A(1, 3)), Pack::mul(GB_A(1, 1), GB_A(0, 3)));
+		s[5] = Pack::sub(Pack::mul(GB_A(0, 2), GB_A(1, 3)), Pack::mul(GB_A(1, 2), GB_A(0, 3)));
+		c[5] = Pack::sub(Pack::mul(GB_A(2, 2), GB_A(3, 3)), Pack::mul(GB_A(3, 2), GB_A(2, 3)));
+		c[4] = Pack::sub(Pack::mul(GB_A(2, 1), GB_A(3, 3)), Pack::mul(GB_A(3, 1), GB_A(2, 3)));
+		c[3] = Pack::sub(Pack::mul(GB_A(2, 1), GB_A(3, 2)), Pack::mul(GB_A(3, 1), GB_A(2, 2)));
+		c[2] = Pack::sub(Pack::mul(GB_A(2, 0), GB_A(3, 3)), Pack::mul(GB_A(3, 0), GB_A(2, 3)));
+		c[1] = Pack::sub(Pack::mul(GB_A(2, 0), GB_A(3, 2)), Pack::mul(GB_A(3, 0), GB_A(2, 2)));
+		c[0] = Pack::sub(Pack::mul(GB_A(2, 0), GB_A(3, 1)), Pack::mul(GB_A(3, 0), GB_A(2, 1)));
+#undef GB_A
+	    }
+
+	type determinant() const
+	    {
+		return Pack::add(Pack::add(Pack::sub(Pack::mul(s[0], c[5]), Pack::mul(s[1], c[4])),
+					   Pack::add(Pack::mul(s[2], c[3]), Pack::mul(s[3], c[2]))),
+				 Pack::sub(Pack::mul(s[5], c[0]), Pack::mul(s[4], c[1])));
+	    }
+
+	// x * p - y * q + z * r
+	static type _term(const type x, const type p, const type y, const type q, const type z, const type r)
+	    {
+		return Pack::add(Pack::sub(Pack::mul(x, p), Pack::mul(y, q)), Pack::mul(z, r));
+	    }
+
+	void inverse(const type e[16], const type oneOverDet, type out[16]) const
+	    {
+#define GB_A(r, c) e[(c) * 4 + (r)]
+#define GB_B(r, c) out[(c) * 4 + (r)]
+		const type zero = Pack::set1(0.0f);
+		const type negOneOverDet = Pack::sub(zero, oneOverDet);
+		GB_B(0, 0) = Pack::mul(_term(GB_A(1, 1), c[5], GB_A(1, 2), c[4], GB_A(1, 3), c[3]), oneOverDet);
+		GB_B(0, 1) = Pack::mul(_term(GB_A(0, 1), c[5], GB_A(0, 2), c[4], GB_A(0, 3), c[3]), negOneOverDet);
+		GB_B(0, 2) = Pack::mul(_term(GB_A(3, 1), s[5], GB_A(3, 2), s[4], GB_A(3, 3), s[3]), oneOverDet);
+		GB_B(0, 3) = Pack::mul(_term(GB_A(2, 1), s[5], GB_A(2, 2), s[4], GB_A(2, 3), s[3]), negOneOverDet);
+		GB_B(1, 0) = Pack::mul(_term(GB_A(1, 0), c[5], GB_A(1, 2), c[2], GB_A(1, 3), c[1]), negOneOverDet);
+		GB_B(1, 1) = Pack::mul(_term(GB_A(0, 0), c[5], GB_A(0, 2), c[2], GB_A(0, 3), c[1]), oneOverDet);
+		GB_B(1, 2) = Pack::mul(_term(GB_A(3, 0), s[5], GB_A(3, 2), s[2], GB_A(3, 3), s[1]), negOneOverDet);
+		GB_B(1, 3) = Pack::mul(_term(GB_A(2, 0), s[5], GB_A(2, 2), s[2], GB_A(2, 3), s[1]), oneOverDet);
+		GB_B(2, 0) = Pack::mul(_term(GB_A(1, 0), c[4], GB_A(1, 1), c[2], GB_A(1, 3), c[0]), oneOverDet);
+		GB_B(2, 1) = Pack::mul(_term(GB_A(0, 0), c[4], GB_A(0, 1), c[2], GB_A(0, 3), c[0]), negOneOverDet);
+		GB_B(2, 2) = Pack::mul(_term(GB_A(3, 0), s[4], GB_A(3, 1), s[2], GB_A(3, 3), s[0]), oneOverDet);
+		GB_B(2, 3) = Pack::mul(_term(GB_A(2, 0), s[4], GB_A(2, 1), s[2], GB_A(2, 3), s[0]), negOneOverDet);
+		GB_B(3, 0) = Pack::mul(_term(GB_A(1, 0), c[3], GB_A(1, 1), c[1], GB_A(1, 2), c[0]), negOneOverDet);
+		GB_B(3, 1) = Pack::mul(_term(GB_A(0, 0), c[3], GB_A(0, 1), c[1], GB_A(0, 2), c[0]), oneOverDet);
+		GB_B(3, 2) = Pack::mul(_term(GB_A(3, 0), s[3], GB_A(3, 1), s[1], GB_A(3, 2), s[0]), negOneOverDet);
+		GB_B(3, 3) = Pack::mul(_term(GB_A(2, 0), s[3], GB_A(2, 1), s[1], GB_A(2, 2), s[0]), oneOverDet);
+#undef GB_B
+#undef GB_A
+	    }
+
+	type s[6];
+	type c[6];
+    };
+
+    // adjugate of the upper 3x3, adj[c * 3 + r] = cofactor(c, r), returns the determinant
+    template<typename Pack>
+    typename Pack::type _mat3_adjugate(const typename Pack::type e[16], typename Pack::type adj[9])
+    {
+#define GB_A(r, c) e[(c) * 4 + (r)]
+	adj[0] = Pack::sub(Pack::mul(GB_A(1, 1), GB_A(2, 2)), Pack::mul(GB_A(1, 2), GB_A(2, 1)));
+	adj[1] = Pack::sub(Pack::mul(GB_A(1, 2), GB_A(2, 0)), Pack::mul(GB_A(1, 0), GB_A(2, 2)));
+	adj[2] = Pack::sub(Pack::mul(GB_A(1, 0), GB_A(2, 1)), Pack::mul(GB_A(1, 1), GB_A(2, 0)));
+	adj[3] = Pack::sub(Pack::mul(GB_A(0, 2), GB_A(2, 1)), Pack::mul(GB_A(0, 1), GB_A(2, 2)));
+	adj[4] = Pack::sub(Pack::mul(GB_A(0, 0), GB_A(2, 2)), Pack::mul(GB_A(0, 2), GB_A(2, 0)));
+	adj[5] = Pack::sub(Pack::mul(GB_A(0, 1), GB_A(2, 0)), Pack::mul(GB_A(0, 0), GB_A(2, 1)));
+	adj[6] = Pack::sub(Pack::mul(GB_A(0, 1), GB_A(1, 2)), Pack::mul(GB_A(0, 2), GB_A(1, 1)));
+	adj[7] = Pack::sub(Pack::mul(GB_A(0, 2), GB_A(1, 0)), Pack::mul(GB_A(0, 0), GB_A(1, 2)));
+	adj[8] = Pack::sub(Pack::mul(GB_A(0, 0), GB_A(1, 1)), Pack::mul(GB_A(0, 1), GB_A(1, 0)));
+	// row 0 against its cofactors
+	return Pack::add(Pack::add(Pack::mul(GB_A(0, 0), adj[0]), Pack::mul(GB_A(0, 1), adj[1])), Pack::mul(GB_A(0, 2), adj[2]));
+#undef GB_A
+    }
+
+    template<typename Pack>
+    void _mat4_determinant(const float* in, const std::size_t blocks, float* out)
+    {
+	for(std::size_t b = 0; b < blocks; b++)
+	{
+	    const float* block = in + b * 16 * mat4_stream_lanes;
+	    for(std::size_t l = 0; l < mat4_stream_lanes; l += Pack::width)
+	    {
+		typename Pack::type e[16];
+		for(std::uint8_t j = 0; j < 16; j++)
+		    e[j] = Pack::load(block + j * mat4_stream_lanes + l);
+		typename Pack::type det;
+		if(_mat4_affine<Pack>(e))
+		{
+		    typename Pack::type adj[9];
+		    det = _mat3_adjugate<Pack>(e, adj);
+		}
+		else
+		    det = _mat4_minors<Pack>(e).determinant();
+		Pack::store(out + b * mat4_stream_lanes + l, det);
+	    }
+	}
+    }
+
+    template<typename Pack>
+    void _mat4_inverse(const float* in, const std::size_t blocks, float* out, std::uint16_t* singular)
+    {
+	const typename Pack::type zero = Pack::set1(0.0f);
+	const typename Pack::type one = Pack::set1(1.0f);
+	for(std::size_t b = 0; b < blocks; b++)
+	{
+	    const float* block = in + b * 16 * mat4_stream_lanes;
+	    float* outBlock = out + b * 16 * mat4_stream_lanes;
+	    unsigned mask = 0;
+	    for(std::size_t l = 0; l < mat4_stream_lanes; l += Pack::width)
+	    {
+		typename Pack::type e[16], r[16];
+		for(std::uint8_t j = 0; j < 16; j++)
+		    e[j] = Pack::load(block + j * mat4_stream_lanes + l);
+
+		typename Pack::type det;
+		if(_mat4_affine<Pack>(e))
+		{
+		    typename Pack::type adj[9];
+		    det = _mat3_adjugate<Pack>(e, adj);
+		    const typename Pack::type oneOverDet = Pack::div(one, det);
+		    for(std::uint8_t c = 0; c < 3; c++)
+		    {
+			for(std::uint8_t row = 0; row < 3; row++)
+			    r[c * 4 + row] = Pack::mul(adj[c * 3 + row], oneOverDet);
+			r[c * 4 + 3] = zero;
+		    }
+		    // -inv(L) * t
+		    for(std::uint8_t row = 0; row < 3; row++)
+			r[12 + row] = Pack::sub(zero, Pack::add(Pack::add(Pack::mul(r[row], e[12]), Pack::mul(r[4 + row], e[13])), Pack::mul(r[8 + row], e[14])));
+		    r[15] = one;
+		}
+		else
+		{
+		    const _mat4_minors<Pack> minors(e);
+		    det = minors.determinant();
+		    minors.inverse(e, Pack::div(one, det), r);
+		}
+		mask |= Pack::eq_mask(det, zero) << l;
+		for(std::uint8_t j = 0; j < 16; j++)
+		    Pack::store(outBlock + j * mat4_stream_lanes + l, r[j]);
+	    }
+	    singular[b] = (std::uint16_t)mask;
+	}
+    }
+
+    /*
+      aabb_pack<16> blocks, lower x y z then upper x y z rows of aabb_pack_lanes floats.
+      boxes overlap when lower < query upper and upper > query lower on every axis(as aabb::intersect),
+      the sphere test is exact: squared distance from the centre to the box <= radius^2.
+      empty lanes(lower +inf, upper -inf) fail both.
+    */
+    template<typename Pack>
+    void _aabb_overlap(const float* packs, const std::size_t count, const float query[6], std::uint16_t* masks)
+    {
+	typename Pack::type q[6];
+	for(std::uint8_t j = 0; j < 6; j++)
+	    q[j] = Pack::set1(query[j]);
+	for(std::size_t b = 0; b < count; b++)
+	{
+	    const float* p = packs + b * 6 * aabb_pack_lanes;
+	    unsigned mask = 0;
+	    for(std::size_t l = 0; l < aabb_pack_lanes; l += Pack::width)
+	    {
+		unsigned m = ~0u;
+		for(std::uint8_t c = 0; c < 3; c++)
+		{
+		    m &= Pack::lt_mask(Pack::load(p + c * aabb_pack_lanes + l), q[3 + c]);
+		    m &= Pack::lt_mask(q[c], Pack::load(p + (3 + c) * aabb_pack_lanes + l));
+		}
+		mask |= m << l;
+	    }
+	    masks[b] = (std::uint16_t)mask;
+	}
+    }
+
+    template<typename Pack>
+    void _sphere_overlap(const float* packs, const std::size_t count, const float query[4], std::uint16_t* masks)
+    {
+	typename Pack::type centre[3];
+	for(std::uint8_t c = 0; c < 3; c++)
+	    centre[c] = Pack::set1(query[c]);
+	const typename Pack::type sqRadius = Pack::set1(query[3] * query[3]);
+	const typename Pack::type zero = Pack::set1(0.0f);
+	for(std::size_t b = 0; b < count; b++)
+	{
+	    const float* p = packs + b * 6 * aabb_pack_lanes;
+	    unsigned mask = 0;
+	    for(std::size_t l = 0; l < aabb_pack_lanes; l += Pack::width)
+	    {
+		typename Pack::type sqDist = zero;
+		for(std::uint8_t c = 0; c < 3; c++)
+		{
+		    // distance outside the slab, 0 inside
+		    const typename Pack::type below = Pack::sub(Pack::load(p + c * aabb_pack_lanes + l), centre[c]);
+		    const typename Pack::type above = Pack::sub(centre[c], Pack::load(p + (3 + c) * aabb_pack_lanes + l));
+		    const typename Pack::type d = Pack::max(Pack::max(below, above), zero);
+		    sqDist = Pack::add(sqDist, Pack::mul(d, d));
+		}
+		mask |= Pack::le_mask(sqDist, sqRadius) << l;
+	    }
+	    masks[b] = (std::uint16_t)mask;
+	}
+    }
+
+    /*
+      the points are read as a flat float array, 3 registers hold Pack::width points
+      and float j of register k is component (k * Pack::width + j) % 3,
+      so 3 min and 3 max accumulators need no shuffle, the lanes are sorted out once at the end.
+    */
+    template<typename Pack>
+    void _points_bounds(const float* xyz, const std::size_t count, float out[6])
+    {
+	for(std::uint8_t c = 0; c < 3; c++)
+	    out[c] = out[3 + c] = xyz[c];
+
+	std::size_t i = 0;
+	if(count >= Pack::width)
+	{
+	    typename Pack::type lower[3], upper[3];
+	    for(std::uint8_t k = 0; k < 3; k++)
+		lower[k] = upper[k] = Pack::load(xyz + k * Pack::width);
+	    for(i = Pack::width; i + Pack::width <= count; i += Pack::width)
+	    {
+		const float* p = xyz + i * 3;
+		for(std::uint8_t k = 0; k < 3; k++)
+		{
+		    const typename Pack::type v = Pack::load(p + k * Pack::width);
+		    lower[k] = Pack::min(lower[k], v);
+		    upper[k] = Pack::max(upper[k], v);
+		}
+	    }
+
+	    float lanes[2][3 * Pack::width];
+	    for(std::uint8_t k = 0; k < 3; k++)
+	    {
+		Pack::store(lanes[0] + k * Pack::width, lower[k]);
+		Pack::store(lanes[1] + k * Pack::width, upper[k]);
+	    }
+	    for(std::size_t j = 0; j < 3 * Pack::width; j++)
+	    {
+		const std::size_t c = j % 3;
+		if(lanes[0][j] < out[c])
+		    out[c] = lanes[0][j];
+		if(lanes[1][j] > out[3 + c])
+		    out[3 + c] = lanes[1][j];
+	    }
+	}
+
+	for(; i < count; i++)
+	{
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		const float v = xyz[i * 3 + c];
+		if(v < out[c])
+		    out[c] = v;
+		if(v > out[3 + c])
+		    out[3 + c] = v;
+	    }
+	}
+    }
+
+    template<typename Pack>
+    typename Pack::type _sq_distance(const soa3f_cref a, const float point[3], const std::size_t i)
+    {
+	const typename Pack::type dx = Pack::sub(Pack::load(a.x + i), Pack::set1(point[0]));
+	const typename Pack::type dy = Pack::sub(Pack::load(a.y + i), Pack::set1(point[1]));
+	const typename Pack::type dz = Pack::sub(Pack::load(a.z + i), Pack::set1(point[2]));
+	return Pack::add(Pack::add(Pack::mul(dx, dx), Pack::mul(dy, dy)), Pack::mul(dz, dz));
+    }
+
+    template<typename Pack>
+    void _sq_distance(const soa3f_cref a, const float point[3], float* out, const std::size_t count)
+    {
+	std::size_t i = 0;
+	for(; i + Pack::width <= count; i += Pack::width)
+	    Pack::store(out + i, _sq_distance<Pack>(a, point, i));
+	for(; i < count; i++)
+	    _pack1::store(out + i, _sq_distance<_pack1>(a, point, i));
+    }
+
+    template<typename Pack>
+    const stream_kernels* _stream_kernels()
+    {
+	static const stream_kernels ret =
+	    {
+		&_add<Pack>,
+		&_sub<Pack>,
+		&_scale<Pack>,
+		&_dot<Pack>,
+		&_cross<Pack>,
+		&_normalize<Pack>,
+		&_reduce<Pack, true>,
+		&_reduce<Pack, false>,
+		&_transform<Pack>,
+		&_mat4_inverse<Pack>,
+		&_mat4_determinant<Pack>,
+		&_sincos<Pack>,
+		&_aabb_overlap<Pack>,
+		&_sphere_overlap<Pack>,
+		&_points_bounds<Pack>,
+		&_sq_distance<Pack>
+	    };
+	return &ret;
+    }
+}
@@ -0,0 +1,16 @@
+// built with the baseline flags, scalar and sse2 tables
+#include "stream_kernels.inl"
+
+const gb::physics::stream_kernels* gb::physics::streamKernelsScalar()
+{
+    return _stream_kernels<_pack1>();
+}
+
+const gb::physics::stream_kernels* gb::physics::streamKernelsSSE2()
+{
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return _stream_kernels<_pack4>();
+#else
+    return nullptr;
+#endif
+}
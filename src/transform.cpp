@@ -0,0 +1,107 @@
+#include "transform.h"
+
+using namespace gb::physics;
+
+/*
+  arrays: 4 points per step, deinterleaved to x y z registers(loadSoA4), transformed, interleaved back.
+  streams: the per isa kernels of stream_kernels.inl.
+*/
+
+template<std::uint8_t Mode>
+static void _transform(const mat4f& m, const vec3f* in, std::size_t i, const std::size_t count, vec3f* out)
+{
+#if defined(GB_PHYSICS_SSE)
+    __m128 c[16];
+    for(std::uint8_t col = 0; col < 4; col++)
+    {
+	for(std::uint8_t row = 0; row < 4; row++)
+	    c[col * 4 + row] = _mm_set1_ps(m[col][row]);
+    }
+    for(; i + 4 <= count; i += 4)
+    {
+	__m128 x, y, z;
+	loadSoA4(in[i].data(), x, y, z);
+	__m128 r[3];
+	for(std::uint8_t row = 0; row < 3; row++)
+	{
+	    r[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[row], x), _mm_mul_ps(c[4 + row], y)), _mm_mul_ps(c[8 + row], z));
+	    if(Mode != transform_direction)
+		r[row] = _mm_add_ps(r[row], c[12 + row]);
+	}
+	if(Mode == transform_projective)
+	{
+	    const __m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c[3], x), _mm_mul_ps(c[7], y)), _mm_mul_ps(c[11], z)), c[15]);
+	    for(std::uint8_t row = 0; row < 3; row++)
+		r[row] = _mm_div_ps(r[row], w);
+	}
+	storeAoS4(out[i].data(), r[0], r[1], r[2]);
+    }
+#endif
+    for(; i < count; i++)
+    {
+	float r[3];
+	transformVec3<Mode>(m, in[i].x, in[i].y, in[i].z, r);
+	out[i] = vec3f(r[0], r[1], r[2]);
+    }
+}
+
+template<std::uint8_t Mode>
+static void _transform(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    assert((in != nullptr && out != nullptr) || count == 0);
+    if(bParallel)
+	parallelFor(count, transform_parallel_chunk, [&m, in, out](const std::size_t begin, const std::size_t end)
+		    {
+			_transform<Mode>(m, in, begin, end, out);
+		    });
+    else
+	_transform<Mode>(m, in, 0, count, out);
+}
+
+static void _transform(const mat4f& m, const std::uint8_t mode, const vec3f_stream& in, vec3f_stream& out, const bool bParallel)
+{
+    out.resize(in.size());
+    const float* mData = m[0].data();
+    const stream_kernels& kernels = streamKernels();
+    auto body = [&](const std::size_t begin, const std::size_t end)
+	{
+	    kernels.transform(mData, mode,
+			      soa3f_cref{in.x() + begin, in.y() + begin, in.z() + begin},
+			      soa3f_ref{out.x() + begin, out.y() + begin, out.z() + begin},
+			      end - begin);
+	};
+    if(bParallel)
+	parallelFor(in.size(), transform_parallel_chunk, body);
+    else
+	body(0, in.size());
+}
+
+void gb::physics::transformPoints(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    _transform<transform_point>(m, in, count, out, bParallel);
+}
+
+void gb::physics::transformDirections(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    _transform<transform_direction>(m, in, count, out, bParallel);
+}
+
+void gb::physics::transformPointsProjective(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel)
+{
+    _transform<transform_projective>(m, in, count, out, bParallel);
+}
+
+void gb::physics::transformPoints(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel)
+{
+    _transform(m, transform_point, in, out, bParallel);
+}
+
+void gb::physics::transformDirections(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel)
+{
+    _transform(m, transform_direction, in, out, bParallel);
+}
+
+void gb::physics::transformPointsProjective(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel)
+{
+    _transform(m, transform_projective, in, out, bParallel);
+}
@@ -0,0 +1,120 @@
+// batch transforms of points and directions by one mat4
+
+#pragma once
+
+#include "matrix.h"
+#include "stream.h"
+#include "parallel.h"
+#include "stream_kernels.h"
+
+GB_PHYSICS_NS_BEGIN
+
+/*
+  out[i] = m * in[i], no vec4 round trip:
+  - transformPoints, w = 1, the resulting w is ignored(affine m)
+  - transformDirections, w = 0, only the upper 3x3 applies
+  - transformPointsProjective, w = 1, the result is divided by its w
+  out may be in. bParallel splits inputs above transform_parallel_chunk elements across threads.
+  T = float runs SSE for arrays and the dispatched stream kernels for streams(see cpu.h).
+*/
+
+static constexpr std::size_t transform_parallel_chunk = 32 * 1024;
+
+// r = m * (x, y, z, w), w by Mode
+template<std::uint8_t Mode, typename T>
+inline void transformVec3(const mat4<T>& m, const T x, const T y, const T z, T r[3])
+{
+    for(std::uint8_t row = 0; row < 3; row++)
+    {
+	r[row] = m[0][row] * x + m[1][row] * y + m[2][row] * z;
+	if(Mode != transform_direction)
+	    r[row] += m[3][row];
+    }
+    if(Mode == transform_projective)
+    {
+	const T w = m[0][3] * x + m[1][3] * y + m[2][3] * z + m[3][3];
+	for(std::uint8_t row = 0; row < 3; row++)
+	    r[row] /= w;
+    }
+}
+
+template<typename T, std::uint8_t Mode>
+void transformVec3(const mat4<T>& m, const vec3<T>* in, const std::size_t count, vec3<T>* out, const bool bParallel)
+{
+    auto body = [&m, in, out](const std::size_t begin, const std::size_t end)
+	{
+	    for(std::size_t i = begin; i < end; i++)
+	    {
+		T r[3];
+		transformVec3<Mode>(m, in[i].x, in[i].y, in[i].z, r);
+		out[i] = vec3<T>(r[0], r[1], r[2]);
+	    }
+	};
+    if(bParallel)
+	parallelFor(count, transform_parallel_chunk, body);
+    else
+	body(0, count);
+}
+
+template<typename T, std::uint8_t Mode>
+void transformVec3(const mat4<T>& m, const vec3_stream<T>& in, vec3_stream<T>& out, const bool bParallel)
+{
+    out.resize(in.size());
+    auto body = [&m, &in, &out](const std::size_t begin, const std::size_t end)
+	{
+	    for(std::size_t i = begin; i < end; i++)
+	    {
+		T r[3];
+		transformVec3<Mode>(m, in.x()[i], in.y()[i], in.z()[i], r);
+		out.x()[i] = r[0];
+		out.y()[i] = r[1];
+		out.z()[i] = r[2];
+	    }
+	};
+    if(bParallel)
+	parallelFor(in.size(), transform_parallel_chunk, body);
+    else
+	body(0, in.size());
+}
+
+template<typename T>
+void transformPoints(const mat4<T>& m, const vec3<T>* in, const std::size_t count, vec3<T>* out, const bool bParallel = false)
+{
+    transformVec3<T, transform_point>(m, in, count, out, bParallel);
+}
+template<typename T>
+void transformDirections(const mat4<T>& m, const vec3<T>* in, const std::size_t count, vec3<T>* out, const bool bParallel = false)
+{
+    transformVec3<T, transform_direction>(m, in, count, out, bParallel);
+}
+template<typename T>
+void transformPointsProjective(const mat4<T>& m, const vec3<T>* in, const std::size_t count, vec3<T>* out, const bool bParallel = false)
+{
+    transformVec3<T, transform_projective>(m, in, count, out, bParallel);
+}
+
+template<typename T>
+void transformPoints(const mat4<T>& m, const vec3_stream<T>& in, vec3_stream<T>& out, const bool bParallel = false)
+{
+    transformVec3<T, transform_point>(m, in, out, bParallel);
+}
+template<typename T>
+void transformDirections(const mat4<T>& m, const vec3_stream<T>& in, vec3_stream<T>& out, const bool bParallel = false)
+{
+    transformVec3<T, transform_direction>(m, in, out, bParallel);
+}
+template<typename T>
+void transformPointsProjective(const mat4<T>& m, const vec3_stream<T>& in, vec3_stream<T>& out, const bool bParallel = false)
+{
+    transformVec3<T, transform_projective>(m, in, out, bParallel);
+}
+
+// float versions, see transform.cpp
+void transformPoints(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel = false);
+void transformDirections(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel = false);
+void transformPointsProjective(const mat4f& m, const vec3f* in, const std::size_t count, vec3f* out, const bool bParallel = false);
+void transformPoints(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel = false);
+void transformDirections(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel = false);
+void transformPointsProjective(const mat4f& m, const vec3f_stream& in, vec3f_stream& out, const bool bParallel = false);
+
+GB_PHYSICS_NS_END
@@ -1,7 +1,76 @@
 #include "type.h"
+#include <algorithm>
 
 using namespace gb::physics;
 
+constexpr std::size_t bit_vector::word_bits;
+constexpr std::size_t bit_vector::npos;
+
+static inline bit_vector::word_type _low_mask(const std::size_t bits)
+{
+    // bits [0, bits), bits < 64
+    return (bit_vector::word_type(1) << bits) - 1;
+}
+
+bit_vector::bit_vector(const bit_vector& other) :
+    _data(nullptr),
+    _curSize(0),
+    _capacity(0),
+    _rankSampleWords(0)
+{
+    *this = other;
+}
+
+bit_vector::bit_vector(bit_vector&& other) noexcept :
+    _file(std::move(other._file)),
+    _data(other._data),
+    _curSize(other._curSize),
+    _capacity(other._capacity),
+    _rankSampleWords(other._rankSampleWords),
+    _rankSamples(std::move(other._rankSamples))
+{
+    other._data = nullptr;
+    other._curSize = 0;
+    other._capacity = 0;
+}
+
+bit_vector& bit_vector::operator=(const bit_vector& other)
+{
+    if(this == &other)
+	return *this;
+
+    clear();
+    if(other._capacity != 0)
+    {
+	_data = new word_type[other._capacity / word_bits];
+	std::memcpy(_data, other._data, other._capacity / 8);
+    }
+    _curSize = other._curSize;
+    _capacity = other._capacity;
+    _rankSampleWords = other._rankSampleWords;
+    _rankSamples = other._rankSamples;
+    return *this;
+}
+
+bit_vector& bit_vector::operator=(bit_vector&& other) noexcept
+{
+    if(this == &other)
+	return *this;
+
+    clear();
+    _file = std::move(other._file);
+    _data = other._data;
+    _curSize = other._curSize;
+    _capacity = other._capacity;
+    _rankSampleWords = other._rankSampleWords;
+    _rankSamples = std::move(other._rankSamples);
+
+    other._data = nullptr;
+    other._curSize = 0;
+    other._capacity = 0;
+    return *this;
+}
+
 bit_vector::~bit_vector()
 {
     clear();
@@ -9,107 +78,344 @@ bit_vector::~bit_vector()
 
 void bit_vector::clear()
 {
-    delete [] _data;
+    if(_file.is_open())
+    {
+	_sync_header();
+	_file.close();
+    }
+    else
+	delete [] _data;
     _data = nullptr;
 
     _capacity = 0;
     _curSize = 0;
+    _rankSamples.clear();
 }
 
-void bit_vector::reserve(const size_t capacity)
+bool bit_vector::reserve(const size_t capacity)
 {
-    if(capacity == _capacity)
-	return;
-    
-    const size_t byteSize = capacity / 8 + (capacity % 8 == 0 ? 0 : 1);
-    _capacity = byteSize * 8;
-    std::uint8_t* newData = new std::uint8_t[byteSize]{0};
-    
+    const size_t wordSize = capacity / word_bits + (capacity % word_bits == 0 ? 0 : 1);
+    if(wordSize * word_bits == _capacity)
+	return true;
+
+    if(_file.is_open())
+    {
+	// the file grows in place, new words read as zeros
+	if(!_file.writable() || !_file.resize(sizeof(mapped_header) + wordSize * sizeof(word_type)))
+	    return false;
+	_data = (word_type*)((mapped_header*)_file.data())->payload();
+	_capacity = wordSize * word_bits;
+	if(_curSize > _capacity)
+	    _curSize = _capacity;
+	_clear_tail();
+	_sync_header();
+	_rankSamples.clear();
+	return true;
+    }
+
+    word_type* newData = new word_type[wordSize]{0};
+
     const size_t cpSize = _curSize <= capacity ? _curSize : capacity;
     _curSize = cpSize;
-    
+
     if(cpSize != 0)
     {
 	assert(_data != nullptr);
-	
-	const size_t preFullByteSize = cpSize / 8 ;
-	memcpy(newData, _data, preFullByteSize);
-
-	//tail fragment bits
-	std::uint8_t tailSize = cpSize % 8;
 
-	std::uint8_t& tailByte_dst = *(newData + preFullByteSize);
-	std::uint8_t& tailByte_src = *(_data + preFullByteSize);
-	for(int i = 0; i < tailSize; i++)
-	{
-	    _set_byte_uint(tailByte_dst, i, _get_byte_uint(tailByte_src, i));
-	}
+	const size_t cpWordSize = cpSize / word_bits + (cpSize % word_bits == 0 ? 0 : 1);
+	std::memcpy(newData, _data, cpWordSize * sizeof(word_type));
     }
 
     delete [] _data;
 
     _data = newData;
+    _capacity = wordSize * word_bits;
+    _clear_tail();
+    _rankSamples.clear();
+    return true;
 }
 
-void bit_vector::insert(const size_t beginIdx, const size_t size, const std::uint8_t bitVal)
+bool bit_vector::_grow(const std::size_t capacity)
+{
+    if(capacity <= _capacity)
+	return true;
+
+    std::size_t newCapacity = _capacity < word_bits ? word_bits : _capacity;
+    while(newCapacity < capacity)
+	newCapacity *= 2;
+    return reserve(newCapacity);
+}
+
+void bit_vector::_clear_tail()
+{
+    // bits beyond _curSize are kept 0, so word ops and popcount can ignore the size
+    const std::size_t tailBits = _curSize % word_bits;
+    const std::size_t lastWord = _curSize / word_bits;
+    const std::size_t words = word_count();
+    if(lastWord >= words)
+	return;
+    _data[lastWord] &= tailBits == 0 ? 0 : _low_mask(tailBits);
+    std::fill(_data + lastWord + 1, _data + words, word_type(0));
+}
+
+bool bit_vector::insert(const size_t beginIdx, const size_t size, const std::uint8_t bitVal)
 {
     assert(bitVal <= 1);
     if(size == 0)
-	return;
-    
-    if(beginIdx + size > _capacity)
-	reserve( 2 * _capacity);
-
-    size_t leftSize = size;
-    size_t byteIdx = beginIdx / 8;
-    
-    //head fragment bits
-    std::uint8_t head_bit_idx = beginIdx % 8;
-    
-    if(head_bit_idx != 0)
+	return true;
+
+    const std::size_t endIdx = beginIdx + size;
+    if(!_grow(endIdx))
+	return false;
+
+    const std::size_t headWord = beginIdx / word_bits;
+    const std::size_t tailWord = (endIdx - 1) / word_bits;
+    const std::size_t headBit = beginIdx % word_bits;
+    const std::size_t tailBit = endIdx % word_bits;
+
+    // masks of the bits to touch in the first and the last word
+    word_type headMask = ~word_type(0) << headBit;
+    const word_type tailMask = tailBit == 0 ? ~word_type(0) : _low_mask(tailBit);
+
+    if(headWord == tailWord)
+	headMask &= tailMask;
+
+    if(bitVal != 0)
+	_data[headWord] |= headMask;
+    else
+	_data[headWord] &= ~headMask;
+
+    if(tailWord != headWord)
     {
-	std::uint8_t head_bit_size = 8 - head_bit_idx;
-	if(leftSize < head_bit_size)
-	    head_bit_size = (std::uint8_t)leftSize;
-	
-	std::uint8_t& curByte = _data[byteIdx];
-	for(int i = 0; i < head_bit_size; i ++)
-	{
-	    _set_byte_uint(curByte, head_bit_idx + i, bitVal);
-	}
+	// full words in between
+	std::fill(_data + headWord + 1, _data + tailWord, bitVal != 0 ? ~word_type(0) : word_type(0));
 
-	leftSize = leftSize - head_bit_size;
-	byteIdx += 1;
+	if(bitVal != 0)
+	    _data[tailWord] |= tailMask;
+	else
+	    _data[tailWord] &= ~tailMask;
     }
 
-    if(leftSize != 0)
+    if(_curSize < endIdx)
+	_curSize = endIdx;
+    _rankSamples.clear();
+    return true;
+}
+
+void bit_vector::fill(const std::uint8_t bitVal)
+{
+    assert(bitVal <= 1);
+    std::fill(_data, _data + word_count(), bitVal != 0 ? ~word_type(0) : word_type(0));
+    _clear_tail();
+    _rankSamples.clear();
+}
+
+std::size_t bit_vector::count() const
+{
+    std::size_t ret = 0;
+    const std::size_t words = word_count();
+    for(std::size_t i = 0; i < words; i++)
+	ret += popcount64(_data[i]);
+    return ret;
+}
+
+std::size_t bit_vector::rank(const std::size_t index) const
+{
+    assert(index <= _capacity);
+    const std::size_t word = index / word_bits;
+
+    std::size_t ret = 0;
+    std::size_t i = 0;
+    if(!_rankSamples.empty())
+    {
+	const std::size_t sample = std::min(word / _rankSampleWords, _rankSamples.size() - 1);
+	ret = _rankSamples[sample];
+	i = sample * _rankSampleWords;
+    }
+
+    for(; i < word; i++)
+	ret += popcount64(_data[i]);
+
+    const std::size_t bit = index % word_bits;
+    if(bit != 0)
+	ret += popcount64(_data[word] & _low_mask(bit));
+
+    return ret;
+}
+
+std::size_t bit_vector::select(const std::size_t k) const
+{
+    const std::size_t words = word_count();
+    std::size_t left = k;
+    std::size_t i = 0;
+    if(!_rankSamples.empty())
+    {
+	// last sample with prefix count <= k
+	const std::vector<std::size_t>::const_iterator it =
+	    std::upper_bound(_rankSamples.begin(), _rankSamples.end(), k) - 1;
+	left = k - *it;
+	i = (it - _rankSamples.begin()) * _rankSampleWords;
+    }
+
+    for(; i < words; i++)
     {
-	const size_t fullByteSize = leftSize / 8;
-	if(fullByteSize != 0)
+	const std::size_t c = popcount64(_data[i]);
+	if(left < c)
 	{
-	    const std::uint8_t byteVal = (bitVal == 0 ? 0 : 0xff);
-	    memset(_data + byteIdx, byteVal, fullByteSize);
-	    byteIdx += fullByteSize;
+	    // select inside the word, drop the lowest left set bits
+	    word_type w = _data[i];
+	    for(std::size_t j = 0; j < left; j++)
+		w &= w - 1;
+	    return i * word_bits + ctz64(w);
 	}
+	left -= c;
+    }
+    return npos;
+}
+
+std::size_t bit_vector::find_next(const std::size_t from) const
+{
+    if(from >= _curSize)
+	return npos;
 
-	//tail fragment bits
-	const std::uint8_t tailBitSize = leftSize % 8;
-	if(tailBitSize != 0)
+    std::size_t word = from / word_bits;
+    word_type w = _data[word] & (~word_type(0) << (from % word_bits));
+
+    const std::size_t words = word_count();
+    for(;;)
+    {
+	if(w != 0)
 	{
-	    std::uint8_t& curByte = _data[byteIdx];
-	    for(int i = 0; i < tailBitSize; i++)
-	    {
-		_set_byte_uint(curByte, i, bitVal);
-	    }
+	    const std::size_t ret = word * word_bits + ctz64(w);
+	    return ret < _curSize ? ret : npos;
 	}
+	if(++word >= words)
+	    return npos;
+	w = _data[word];
     }
+}
 
-    _curSize += size;
+void bit_vector::build_rank_index(const std::size_t sampleWords)
+{
+    assert(sampleWords != 0);
+    _rankSampleWords = sampleWords;
+
+    const std::size_t words = word_count();
+    _rankSamples.clear();
+    _rankSamples.reserve(words / sampleWords + 1);
+
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < words; i++)
+    {
+	if(i % sampleWords == 0)
+	    _rankSamples.push_back(acc);
+	acc += popcount64(_data[i]);
+    }
+    if(_rankSamples.empty())
+	_rankSamples.push_back(0);
+}
+
+bit_vector& bit_vector::operator&=(const bit_vector& o)
+{
+    const std::size_t words = std::min(word_count(), o.word_count());
+    for(std::size_t i = 0; i < words; i++)
+	_data[i] &= o._data[i];
+    std::fill(_data + words, _data + word_count(), word_type(0));
+
+    if(_curSize > o._curSize)
+	_curSize = o._curSize;
+    _rankSamples.clear();
+    return *this;
+}
+
+bit_vector& bit_vector::operator|=(const bit_vector& o)
+{
+    if(_capacity < o._curSize && !reserve(o._curSize))
+	return *this;
+    const std::size_t words = std::min(word_count(), o.word_count());
+    for(std::size_t i = 0; i < words; i++)
+	_data[i] |= o._data[i];
+
+    if(_curSize < o._curSize)
+	_curSize = o._curSize;
+    _rankSamples.clear();
+    return *this;
+}
+
+bit_vector& bit_vector::operator^=(const bit_vector& o)
+{
+    if(_capacity < o._curSize && !reserve(o._curSize))
+	return *this;
+    const std::size_t words = std::min(word_count(), o.word_count());
+    for(std::size_t i = 0; i < words; i++)
+	_data[i] ^= o._data[i];
+
+    if(_curSize < o._curSize)
+	_curSize = o._curSize;
+    _rankSamples.clear();
+    return *this;
+}
+
+bit_vector& bit_vector::and_not(const bit_vector& o)
+{
+    const std::size_t words = std::min(word_count(), o.word_count());
+    for(std::size_t i = 0; i < words; i++)
+	_data[i] &= ~o._data[i];
+    _rankSamples.clear();
+    return *this;
+}
+
+void bit_vector::_sync_header()
+{
+    if(!_file.is_open() || !_file.writable())
+	return;
+    mapped_header* header = (mapped_header*)_file.data();
+    header->dims[0] = _curSize;
+    header->dims[1] = _capacity;
+    header->payload_size = word_count() * sizeof(word_type);
+}
+
+bool bit_vector::create_mapped(const char* path, const std::size_t capacity)
+{
+    clear();
+    const std::size_t wordSize = capacity / word_bits + (capacity % word_bits == 0 ? 0 : 1);
+    if(!_file.open(path, mapped_file::create, sizeof(mapped_header) + wordSize * sizeof(word_type)))
+	return false;
+
+    mapped_header* header = (mapped_header*)_file.data();
+    header->magic = mapped_header::magic_value;
+    header->kind = mapped_bit_vector;
+    header->elem_size = sizeof(word_type);
+    _data = (word_type*)header->payload();
+    _capacity = wordSize * word_bits;
+    _curSize = 0;
+    _sync_header();
+    return true;
+}
+
+bool bit_vector::open_mapped(const char* path, const bool readOnly)
+{
+    clear();
+    if(!_file.open(path, readOnly ? mapped_file::read_only : mapped_file::read_write))
+	return false;
+
+    mapped_header* header = mapped_header::get(_file, mapped_bit_vector);
+    if(header == nullptr || header->elem_size != sizeof(word_type)
+       || header->dims[1] % word_bits != 0
+       || header->dims[0] > header->dims[1]
+       || header->payload_size != header->dims[1] / 8)
+    {
+	_file.close();
+	return false;
+    }
+    _data = (word_type*)header->payload();
+    _curSize = (std::size_t)header->dims[0];
+    _capacity = (std::size_t)header->dims[1];
+    return true;
 }
 
-std::uint8_t bit_vector::operator[](const size_t index)const
+void bit_vector::flush()
 {
-    assert(index < _capacity);
-    const size_t byteIdx = index / 8;
-    return _get_byte_uint(_data[byteIdx], index % 8);
+    _sync_header();
+    _file.flush();
 }
@@ -3,6 +3,8 @@
 #pragma once
 
 #include "physicsNS.h"
+#include "simd.h"
+#include "mmap.h"
 #include <cassert>
 #include <array>
 #include <cfloat>
@@ -11,6 +13,7 @@
 #include <limits>
 #include <vector>
 #include <type_traits>
+#include <utility>
 #include <cstring>
 
 
@@ -138,70 +141,393 @@ namespace std
 
 GB_PHYSICS_NS_BEGIN
 
+/*
+ *@brief, bit array stored in 64 bits words,
+ bit i is (word[i / 64] >> (i % 64)) & 1, i.e. saved from right to left in every word.
+ rank/select are popcount based, build_rank_index() adds a sampled prefix count
+ so that both become O(1)/O(log n) instead of a linear word scan.
+ the words live on the heap, or in a file after create_mapped()/open_mapped().
+ */
 class bit_vector
 {
 public:
+    typedef std::uint64_t word_type;
+    static constexpr std::size_t word_bits = 64;
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
     inline bit_vector() :
 	_data(nullptr),
 	_curSize(0),
-	_capacity(0)
+	_capacity(0),
+	_rankSampleWords(0)
 	{}
+    bit_vector(const bit_vector& other);
+    bit_vector(bit_vector&& other) noexcept;
+    bit_vector& operator=(const bit_vector& other);
+    bit_vector& operator=(bit_vector&& other) noexcept;
     ~bit_vector();
-    void reserve(const std::size_t capacity);
-    void insert(const std::size_t beginIdx, const std::size_t size, const std::uint8_t bitVal);
-    std::uint8_t operator[](const std::size_t index) const;
+    /*
+     *@return, false if a mapped vector can't be resized(read only or I/O failure), it's then left unchanged.
+     */
+    bool reserve(const std::size_t capacity);
+    // set [beginIdx, beginIdx + size) to bitVal, grows if needed, false(nothing set) if it can't
+    bool insert(const std::size_t beginIdx, const std::size_t size, const std::uint8_t bitVal);
     void clear();
+
+    inline std::uint8_t operator[](const std::size_t index) const
+	{
+	    assert(index < _capacity);
+	    return (std::uint8_t)((_data[index / word_bits] >> (index % word_bits)) & 1);
+	}
+    inline bool test(const std::size_t index) const
+	{
+	    return operator[](index) != 0;
+	}
+    inline void set(const std::size_t index)
+	{
+	    assert(index < _capacity);
+	    _data[index / word_bits] |= word_type(1) << (index % word_bits);
+	    if(_curSize <= index)
+		_curSize = index + 1;
+	    _rankSamples.clear();
+	}
+    inline void reset(const std::size_t index)
+	{
+	    assert(index < _capacity);
+	    _data[index / word_bits] &= ~(word_type(1) << (index % word_bits));
+	    _rankSamples.clear();
+	}
+    // whole array to bitVal, size is kept
+    void fill(const std::uint8_t bitVal);
+
+    std::size_t size() const { return _curSize; }
+    std::size_t capacity() const { return _capacity; }
+    std::size_t word_count() const { return _capacity / word_bits; }
+    const word_type* data() const { return _data; }
+    word_type* data() { return _data; }
+
+    // number of set bits
+    std::size_t count() const;
+    // number of set bits in [0, index)
+    std::size_t rank(const std::size_t index) const;
+    // position of the (k + 1)th set bit, npos if there are not that many
+    std::size_t select(const std::size_t k) const;
+    // first set bit in [from, size()), npos if none
+    std::size_t find_next(const std::size_t from) const;
+    /*
+     *@brief, sample the prefix popcount every sampleWords words,
+     rank and select use it until the next modification.
+     */
+    void build_rank_index(const std::size_t sampleWords = 8);
+
+    // bulk boolean ops, word by word. the result has max(size) bits(min for &=),
+    // a mapped vector that can't grow to o's size is left unchanged
+    bit_vector& operator&=(const bit_vector& o);
+    bit_vector& operator|=(const bit_vector& o);
+    bit_vector& operator^=(const bit_vector& o);
+    // this & ~o
+    bit_vector& and_not(const bit_vector& o);
+
+    /*
+     *@brief, drop the current bits and back the words with a new file at path,
+     capacity bits are reserved, growing later on extends the file.
+     */
+    bool create_mapped(const char* path, const std::size_t capacity);
+    // map a file written by create_mapped(), no copy
+    bool open_mapped(const char* path, const bool readOnly = false);
+    // write size and dirty pages back to the file
+    void flush();
+    bool mapped() const { return _file.is_open(); }
 private:
-    std::uint8_t* _data;
-    std::size_t _curSize;//bit size
-    std::size_t _capacity;//bit capacity
+    bool _grow(const std::size_t capacity);
+    void _clear_tail();
+    void _sync_header();
 private:
-    //save from right to left( the higher index the more left-shift)
-    static inline void _set_byte_uint(std::uint8_t& byte, const std::uint8_t index, const std::uint8_t bitVal)
+    mapped_file _file;
+    word_type* _data;
+    std::size_t _curSize;//bit size
+    std::size_t _capacity;//bit capacity, always a multiple of word_bits
+    std::size_t _rankSampleWords;
+    std::vector<std::size_t> _rankSamples;//popcount of words [0, i * _rankSampleWords)
+};
+
+inline bit_vector operator&(bit_vector l, const bit_vector& r) { return l &= r; }
+inline bit_vector operator|(bit_vector l, const bit_vector& r) { return l |= r; }
+inline bit_vector operator^(bit_vector l, const bit_vector& r) { return l ^= r; }
+
+/*
+ *@brief, 2d array layouts, map (row, col) to an element offset.
+ every layout is built from (row, col, sizeof(T)) and provides
+ - index(r, c), offset of the element
+ - storage_size(), elements to allocate(padding included)
+ - row_contiguous, whether a row is a run of consecutive elements(pitch() apart)
+ - banded, whether band_rows rows are stored as one run of band_pitch() elements,
+ the columns [0, c) of a band being its first band_span(c) elements
+ */
+struct layout_row_major
+{
+    static constexpr bool row_contiguous = true;
+    static constexpr bool banded = true;
+    static constexpr std::uint32_t band_rows = 1;
+
+    layout_row_major() :
+	_pitch(0),
+	_rows(0)
+	{}
+    layout_row_major(const std::uint32_t row, const std::uint32_t col, const std::size_t) :
+	_pitch(col),
+	_rows(row)
+	{}
+
+    inline std::size_t index(const std::uint32_t r, const std::uint32_t c) const
 	{
-	    assert(index <= 7);
-	    assert(bitVal <= 1);
+	    return (std::size_t)r * _pitch + c;
+	}
+    std::size_t storage_size() const { return (std::size_t)_rows * _pitch; }
+    // elements from one row to the next
+    std::uint32_t pitch() const { return _pitch; }
+    std::size_t band_pitch() const { return _pitch; }
+    std::size_t band_span(const std::uint32_t c) const { return c; }
+protected:
+    std::uint32_t _pitch;
+    std::uint32_t _rows;
+};
 
-	    byte |= bitVal << index;
+/*
+ *@brief, row major with every row padded to Alignment bytes,
+ so rows start aligned whenever the first one does and SIMD loads never straddle two rows.
+ */
+template<std::size_t Alignment = GB_PHYSICS_SIMD_ALIGNMENT>
+struct layout_pitched : public layout_row_major
+{
+    layout_pitched() {}
+    layout_pitched(const std::uint32_t row, const std::uint32_t col, const std::size_t elemSize) :
+	layout_row_major(row, _padded_col(col, elemSize), elemSize)
+	{}
+private:
+    static std::uint32_t _padded_col(const std::uint32_t col, const std::size_t elemSize)
+	{
+	    // smallest multiple of step whose byte size is a multiple of Alignment
+	    std::size_t a = Alignment, b = elemSize;
+	    while(b != 0)
+	    {
+		const std::size_t t = a % b;
+		a = b;
+		b = t;
+	    }
+	    const std::uint32_t step = (std::uint32_t)(Alignment / a);
+	    return (col + step - 1) / step * step;
 	}
+};
+
+/*
+ *@brief, Tile x Tile blocks stored one after another(row major inside and between blocks),
+ a small window around (r, c) touches a few cache lines instead of one per row.
+ */
+template<std::uint32_t Tile = 8>
+struct layout_tiled
+{
+    static_assert(Tile != 0 && (Tile & (Tile - 1)) == 0, "Tile must be a power of 2");
+    static constexpr bool row_contiguous = false;
+    static constexpr bool banded = true;
+    static constexpr std::uint32_t band_rows = Tile;
+
+    layout_tiled() :
+	_tileRows(0),
+	_tileCols(0)
+	{}
+    layout_tiled(const std::uint32_t row, const std::uint32_t col, const std::size_t) :
+	_tileRows((row + Tile - 1) / Tile),
+	_tileCols((col + Tile - 1) / Tile)
+	{}
 
-    static inline std::uint8_t _get_byte_uint(const std::uint8_t& byte, const std::uint8_t index)
+    inline std::size_t index(const std::uint32_t r, const std::uint32_t c) const
 	{
-	    assert(index <= 7);
+	    return ((std::size_t)(r / Tile) * _tileCols + c / Tile) * (Tile * Tile)
+		+ (r % Tile) * Tile + c % Tile;
+	}
+    std::size_t storage_size() const { return (std::size_t)_tileRows * _tileCols * Tile * Tile; }
+    // a row of tiles
+    std::size_t band_pitch() const { return (std::size_t)_tileCols * Tile * Tile; }
+    std::size_t band_span(const std::uint32_t c) const { return (std::size_t)((c + Tile - 1) / Tile) * Tile * Tile; }
+private:
+    std::uint32_t _tileRows;
+    std::uint32_t _tileCols;
+};
+
+/*
+ *@brief, Morton(Z) order, bits of c and r interleaved(c in the even bits),
+ neighbours in both directions stay close at every scale.
+ each side is padded to a power of 2, the extra high bits of the longer side
+ go above the interleaved ones.
+ */
+struct layout_morton
+{
+    static constexpr bool row_contiguous = false;
+    static constexpr bool banded = false;
 
-	    const std::uint8_t mask = 1 << index;
-	    return (byte & mask) >> index;
+    layout_morton() :
+	_rowBits(0),
+	_colBits(0)
+	{}
+    layout_morton(const std::uint32_t row, const std::uint32_t col, const std::size_t) :
+	_rowBits(_bits(row)),
+	_colBits(_bits(col))
+	{}
+
+    inline std::size_t index(const std::uint32_t r, const std::uint32_t c) const
+	{
+	    const std::uint8_t common = _rowBits < _colBits ? _rowBits : _colBits;
+	    const std::uint32_t lowMask = (std::uint32_t)((std::uint64_t(1) << common) - 1);
+	    const std::uint64_t low = _spread(c & lowMask) | (_spread(r & lowMask) << 1);
+	    // at most one of them is non zero
+	    const std::uint64_t high = (std::uint64_t)((r >> common) | (c >> common));
+	    return (std::size_t)(low | (high << (2 * common)));
+	}
+    std::size_t storage_size() const { return std::size_t(1) << (_rowBits + _colBits); }
+private:
+    // bits needed to index [0, n)
+    static std::uint8_t _bits(const std::uint32_t n)
+	{
+	    std::uint8_t ret = 0;
+	    while((std::uint64_t(1) << ret) < n)
+		ret++;
+	    return ret;
+	}
+    // bit i to bit 2i
+    static inline std::uint64_t _spread(const std::uint32_t v)
+	{
+	    std::uint64_t x = v;
+	    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+	    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+	    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	    x = (x | (x << 2)) & 0x3333333333333333ull;
+	    x = (x | (x << 1)) & 0x5555555555555555ull;
+	    return x;
 	}
 
+    std::uint8_t _rowBits;
+    std::uint8_t _colBits;
 };
+
 /*
- *@brief, a static 2d array type
+ *@brief, contiguous elements of one row
  */
 template<typename T>
+struct row_span
+{
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    T& operator[](const std::uint32_t i) const
+	{
+	    assert(i < size);
+	    return data[i];
+	}
+
+    T* data;
+    std::uint32_t size;
+};
+
+/*
+ *@brief, non-owning window [row0, row0 + rows) x [col0, col0 + cols) into an array_2d,
+ valid as long as the array is neither destroyed nor reallocated.
+ T may be const for a read only view.
+ */
+template<typename T, typename Layout>
+class array_2d_view
+{
+public:
+    array_2d_view(T* data, const Layout& layout,
+		  const std::uint32_t row0, const std::uint32_t col0,
+		  const std::uint32_t rows, const std::uint32_t cols) :
+	row(rows),
+	col(cols),
+	_data(data),
+	_layout(&layout),
+	_row0(row0),
+	_col0(col0)
+	{}
+    // a mutable view is a read only one too
+    operator array_2d_view<const T, Layout>() const
+	{
+	    return array_2d_view<const T, Layout>(_data, *_layout, _row0, _col0, row, col);
+	}
+
+    inline T& operator()(const std::uint32_t r, const std::uint32_t c) const
+	{
+	    assert(r < row && c < col);
+	    return _data[_layout->index(_row0 + r, _col0 + c)];
+	}
+    template<typename L = Layout, typename = typename std::enable_if<L::row_contiguous>::type>
+    row_span<T> row_at(const std::uint32_t r) const
+	{
+	    assert(r < row);
+	    return row_span<T>{_data + _layout->index(_row0 + r, _col0), col};
+	}
+    array_2d_view view(const std::uint32_t row0, const std::uint32_t col0,
+		       const std::uint32_t rows, const std::uint32_t cols) const
+	{
+	    assert(row0 + rows <= row && col0 + cols <= col);
+	    return array_2d_view(_data, *_layout, _row0 + row0, _col0 + col0, rows, cols);
+	}
+
+    union
+    {
+	std::uint32_t row;
+	std::uint32_t height;
+	std::uint32_t y;
+    };
+
+    union
+    {
+	std::uint32_t col;
+	std::uint32_t width;
+	std::uint32_t x;
+    };
+private:
+    T* _data;
+    const Layout* _layout;
+    std::uint32_t _row0;
+    std::uint32_t _col0;
+};
+
+/*
+ *@brief, a static 2d array type, element placement is decided by Layout
+ (layout_row_major, layout_pitched, layout_tiled or layout_morton).
+ the elements live on the heap, or in a file after create_mapped()/open_mapped()
+ (trivially copyable T only), the file keeps the shape so it can be reopened as is.
+ */
+template<typename T, typename Layout = layout_row_major>
 class array_2d
 {
 private:
     struct _proxy
     {
-	_proxy(T* data, const std::uint32_t col) :
+	_proxy(T* data, const Layout& layout, const std::uint32_t rowIdx, const std::uint32_t col) :
 	    _data(data),
+	    _layout(layout),
+	    _rowIdx(rowIdx),
 	    _col(col)
 	    {}
 	T& operator[](const std::uint32_t colIdx)
 	    {
 		assert(colIdx < _col);
-		return _data[colIdx];
+		return _data[_layout.index(_rowIdx, colIdx)];
 	    }
 
 	T* const _data;
+	const Layout& _layout;
+	std::uint32_t _rowIdx;
 	std::uint32_t _col;
     };
 
 public:
+    typedef array_2d_view<T, Layout> view_type;
+    typedef array_2d_view<const T, Layout> const_view_type;
+
     ~array_2d()
 	{
-	    delete[] _data;
-	    _data = nullptr;
+	    _release();
 	}
     array_2d() :
 	row(0),
@@ -211,96 +537,229 @@ public:
     array_2d(const std::uint32_t row_, const std::uint32_t col_):
 	row(row_),
 	col(col_),
-	_data(new T[row_ * col_]{})
+	_layout(row_, col_, sizeof(T)),
+	_data(new T[_layout.storage_size()]{})
 	{
 	}
 
     array_2d(const std::uint32_t row_, const std::uint32_t col_, const std::uint8_t initValue) :
 	row(row_),
 	col(col_),
-	_data(new T[row_ * col_])
+	_layout(row_, col_, sizeof(T)),
+	_data(new T[_layout.storage_size()])
 	{
-	    std::memset(_data, initValue, row_ * col_);
+	    std::memset(_data, initValue, _layout.storage_size() * sizeof(T));
 	}
 
     array_2d(array_2d&& other) :
 	row(other.row),
 	col(other.col),
+	_layout(other._layout),
+	_file(std::move(other._file)),
 	_data(other._data)
 	{
 	    other._data = nullptr;
+	    other.row = 0;
+	    other.col = 0;
 	}
 
     void operator=(array_2d&& other)
 	{
+	    if(this == &other)
+		return;
+	    _release();
 	    row = other.row;
 	    col = other.col;
+	    _layout = other._layout;
+	    _file = std::move(other._file);
 	    _data = other._data;
 	    other._data = nullptr;
+	    other.row = 0;
+	    other.col = 0;
 	}
     _proxy operator[](const std::uint32_t rowIdx)
 	{
 	    assert(rowIdx < row);
-	    return _proxy(_data + rowIdx * col, col);
+	    return _proxy(_data, _layout, rowIdx, col);
+	}
+    inline T& operator()(const std::uint32_t r, const std::uint32_t c)
+	{
+	    assert(r < row && c < col);
+	    return _data[_layout.index(r, c)];
+	}
+    inline const T& operator()(const std::uint32_t r, const std::uint32_t c) const
+	{
+	    assert(r < row && c < col);
+	    return _data[_layout.index(r, c)];
 	}
 
-    void realloc(const std::uint32_t row_, const std::uint32_t col_)
+    /*
+     *@brief, contiguous row r, only for row contiguous layouts
+     */
+    template<typename L = Layout, typename = typename std::enable_if<L::row_contiguous>::type>
+    row_span<T> row_at(const std::uint32_t r)
 	{
-	    std::uint32_t old_row = row;
-	    std::uint32_t old_col = col;
-	    row = row_;
-	    col = col_;
-	    T* tmp = new T[row * col]{};
+	    assert(r < row);
+	    return row_span<T>{_data + _layout.index(r, 0), col};
+	}
+    template<typename L = Layout, typename = typename std::enable_if<L::row_contiguous>::type>
+    row_span<const T> row_at(const std::uint32_t r) const
+	{
+	    assert(r < row);
+	    return row_span<const T>{_data + _layout.index(r, 0), col};
+	}
+
+    /*
+     *@brief, non-owning subregion, no copy
+     */
+    view_type view(const std::uint32_t row0, const std::uint32_t col0,
+		   const std::uint32_t rows, const std::uint32_t cols)
+	{
+	    assert(row0 + rows <= row && col0 + cols <= col);
+	    return view_type(_data, _layout, row0, col0, rows, cols);
+	}
+    const_view_type view(const std::uint32_t row0, const std::uint32_t col0,
+			 const std::uint32_t rows, const std::uint32_t cols) const
+	{
+	    assert(row0 + rows <= row && col0 + cols <= col);
+	    return const_view_type(_data, _layout, row0, col0, rows, cols);
+	}
+    view_type view() { return view(0, 0, row, col); }
+    const_view_type view() const { return view(0, 0, row, col); }
+
+    /*
+     *@brief, resize, the overlapping part is kept, new elements are value initialized.
+     a mapped array stays mapped, its file is resized.
+     *@return, false if a mapped array can't be resized(read only or I/O failure), it's then left unchanged.
+     */
+    bool realloc(const std::uint32_t row_, const std::uint32_t col_)
+	{
+	    const Layout newLayout(row_, col_, sizeof(T));
+	    if(_file.is_open())
+		return _file.writable() && _realloc_mapped(row_, col_, newLayout, std::integral_constant<bool, Layout::banded>());
+	    T* tmp = new T[newLayout.storage_size()]{};
 	    if (_data != nullptr)
 	    {
-		if (old_row > row)
-		    old_row = row;
-		if (old_col > col)
-		    old_col = col;
+		const std::uint32_t cpRow = row < row_ ? row : row_;
+		const std::uint32_t cpCol = col < col_ ? col : col_;
 
-		for (std::uint32_t i = 0; i < old_row; i++)
+		for (std::uint32_t i = 0; i < cpRow; i++)
 		{
-		    for (std::uint32_t j = 0; j < old_col; j++)
+		    for (std::uint32_t j = 0; j < cpCol; j++)
 		    {
-			tmp[i][j] = _data[i][j];
+			tmp[newLayout.index(i, j)] = std::move(_data[_layout.index(i, j)]);
 		    }
 		}
 
-		delete[] _data;
-		_data = nullptr;
+		_release();
 	    }
 
+	    row = row_;
+	    col = col_;
+	    _layout = newLayout;
 	    _data = tmp;
+	    return true;
 	}
 
+    /*
+     *@param, data, new[] allocated, Layout(row_, col_, sizeof(T)).storage_size() elements, owned afterwards.
+     */
     void assign(const std::uint32_t row_, const std::uint32_t col_, T* data)
 	{
 	    row = row_;
 	    col = col_;
-	    delete[] _data;
+	    _layout = Layout(row_, col_, sizeof(T));
+	    _release();
 	    _data = data;
 	}
 
     /*
      *@param, location, location[0]: col idx, location[1]: row idx.
      */
-    void insert(const std::array<std::uint32_t, 2>& location, array_2d<T>& other)
+    template<typename OtherLayout>
+    void insert(const std::array<std::uint32_t, 2>& location, const array_2d_view<const T, OtherLayout>& other)
 	{
 	    const std::uint32_t o_x = location[0];
 	    const std::uint32_t o_y = location[1];
 	    const std::uint32_t height = other.height;
 	    const std::uint32_t width = other.width;
+	    assert(o_y + height <= row && o_x + width <= col);
+
+	    _insert(o_x, o_y, other, std::integral_constant<bool, Layout::row_contiguous && OtherLayout::row_contiguous
+				&& std::is_trivially_copyable<T>::value>());
+	}
+    template<typename OtherLayout>
+    void insert(const std::array<std::uint32_t, 2>& location, const array_2d_view<T, OtherLayout>& other)
+	{
+	    insert(location, array_2d_view<const T, OtherLayout>(other));
+	}
+    template<typename OtherLayout>
+    void insert(const std::array<std::uint32_t, 2>& location, const array_2d<T, OtherLayout>& other)
+	{
+	    insert(location, other.view());
+	}
 
-	    for (std::uint32_t i = 0; i < height; i++)
+    /*
+     *@brief, drop the current elements and back the array with a new file at path,
+     elements are zero filled(the file is sparse until written).
+     *@return, false if the file can't be created, the array is then empty.
+     */
+    bool create_mapped(const char* path, const std::uint32_t row_, const std::uint32_t col_)
+	{
+	    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable T can be mapped");
+	    _release();
+	    const Layout layout(row_, col_, sizeof(T));
+	    const std::size_t payload = layout.storage_size() * sizeof(T);
+	    if(!_file.open(path, mapped_file::create, sizeof(mapped_header) + payload))
+		return false;
+
+	    mapped_header* header = (mapped_header*)_file.data();
+	    header->magic = mapped_header::magic_value;
+	    header->kind = mapped_array_2d;
+	    header->elem_size = sizeof(T);
+	    header->dims[0] = row_;
+	    header->dims[1] = col_;
+	    header->payload_size = payload;
+	    row = row_;
+	    col = col_;
+	    _layout = layout;
+	    _data = (T*)header->payload();
+	    return true;
+	}
+    /*
+     *@brief, map a file written by create_mapped() with the same T and Layout, no copy.
+     */
+    bool open_mapped(const char* path, const bool readOnly = false)
+	{
+	    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable T can be mapped");
+	    _release();
+	    if(!_file.open(path, readOnly ? mapped_file::read_only : mapped_file::read_write))
+		return false;
+
+	    mapped_header* header = mapped_header::get(_file, mapped_array_2d);
+	    const Layout layout = header != nullptr ?
+		Layout((std::uint32_t)header->dims[0], (std::uint32_t)header->dims[1], sizeof(T)) : Layout();
+	    if(header == nullptr || header->elem_size != sizeof(T)
+	       || header->payload_size != layout.storage_size() * sizeof(T))
 	    {
-		for (std::uint32_t j = 0; j < width; j++)
-		{
-		    this->operator[](o_y + i)[o_x + j] = other[i][j];
-		}
+		_file.close();
+		return false;
 	    }
+	    row = (std::uint32_t)header->dims[0];
+	    col = (std::uint32_t)header->dims[1];
+	    _layout = layout;
+	    _data = (T*)header->payload();
+	    return true;
 	}
+    // write dirty pages back to the file, no-op on the heap
+    void flush() { _file.flush(); }
+    bool mapped() const { return _file.is_open(); }
 
     const T* data()const { return _data; }
+    T* data() { return _data; }
+    const Layout& layout() const { return _layout; }
+    // elements allocated, layout padding included
+    std::size_t storage_size() const { return _layout.storage_size(); }
     union
     {
 	std::uint32_t row;
@@ -315,268 +774,719 @@ public:
 	std::uint32_t x;
     };
 private:
+    template<typename OtherLayout>
+    void _insert(const std::uint32_t o_x, const std::uint32_t o_y,
+		 const array_2d_view<const T, OtherLayout>& other, std::true_type)
+	{
+	    // row by row memcpy
+	    for (std::uint32_t i = 0; i < other.height; i++)
+	    {
+		const row_span<const T> src = other.row_at(i);
+		std::memcpy(_data + _layout.index(o_y + i, o_x), src.data, src.size * sizeof(T));
+	    }
+	}
+    template<typename OtherLayout>
+    void _insert(const std::uint32_t o_x, const std::uint32_t o_y,
+		 const array_2d_view<const T, OtherLayout>& other, std::false_type)
+	{
+	    for (std::uint32_t i = 0; i < other.height; i++)
+	    {
+		for (std::uint32_t j = 0; j < other.width; j++)
+		{
+		    _data[_layout.index(o_y + i, o_x + j)] = other(i, j);
+		}
+	    }
+	}
+
+    void _release()
+	{
+	    if(_file.is_open())
+		_file.close();
+	    else
+		delete[] _data;
+	    _data = nullptr;
+	}
+    bool _realloc_mapped(const std::uint32_t row_, const std::uint32_t col_, const Layout& newLayout, std::true_type)
+	{
+	    // bands move as whole runs inside the mapping, last to first once the file has grown
+	    // when they spread out, first to last before it's cut when they pack closer
+	    const std::uint32_t cpRow = row < row_ ? row : row_;
+	    const std::uint32_t cpCol = col < col_ ? col : col_;
+	    const std::size_t bands = (cpRow + Layout::band_rows - 1) / Layout::band_rows;
+	    const std::size_t span = newLayout.band_span(cpCol);
+	    const std::size_t oldPitch = _layout.band_pitch();
+	    const std::size_t newPitch = newLayout.band_pitch();
+	    const std::size_t oldSize = _layout.storage_size();
+	    const std::size_t newSize = newLayout.storage_size();
+	    if(newSize > oldSize && !_resize_mapped(newSize))
+		return false;
+	    if(newPitch > oldPitch)
+	    {
+		for (std::size_t b = bands; b-- > 1;)
+		    std::memmove(_data + b * newPitch, _data + b * oldPitch, span * sizeof(T));
+	    }
+	    else if(newPitch < oldPitch)
+	    {
+		for (std::size_t b = 1; b < bands; b++)
+		    std::memmove(_data + b * newPitch, _data + b * oldPitch, span * sizeof(T));
+	    }
+
+	    // everything but the kept corner is value initialized, first between the runs
+	    for (std::size_t b = 0; b < bands; b++)
+		std::fill(_data + b * newPitch + span, _data + (b + 1) * newPitch, T());
+	    std::fill(_data + bands * newPitch, _data + newSize, T());
+	    // then the padding rows and columns inside the runs(tiles cut by the corner)
+	    const std::uint32_t spanRows = (std::uint32_t)bands * Layout::band_rows;
+	    const std::uint32_t spanCols = (std::uint32_t)(span / Layout::band_rows);
+	    for (std::uint32_t i = 0; i < spanRows; i++)
+	    {
+		for (std::uint32_t j = i < cpRow ? cpCol : 0; j < spanCols; j++)
+		    _data[newLayout.index(i, j)] = T();
+	    }
+
+	    // a failed cut keeps the longer file, it still reopens
+	    if(newSize < oldSize)
+		_resize_mapped(newSize);
+	    _set_mapped_shape(row_, col_, newLayout);
+	    return true;
+	}
+    bool _realloc_mapped(const std::uint32_t row_, const std::uint32_t col_, const Layout& newLayout, std::false_type)
+	{
+	    // every element may move, the kept ones wait in a temporary mapped file(row major)
+	    const std::uint32_t cpRow = row < row_ ? row : row_;
+	    const std::uint32_t cpCol = col < col_ ? col : col_;
+	    const std::size_t kept = (std::size_t)cpRow * cpCol;
+	    mapped_file tmp;
+	    if(kept != 0 && !tmp.open_temporary(kept * sizeof(T)))
+		return false;
+	    T* aside = (T*)tmp.data();
+	    for (std::uint32_t i = 0; i < cpRow; i++)
+	    {
+		for (std::uint32_t j = 0; j < cpCol; j++)
+		    aside[(std::size_t)i * cpCol + j] = _data[_layout.index(i, j)];
+	    }
+	    const std::size_t newSize = newLayout.storage_size();
+	    if(!_resize_mapped(newSize))
+		return false;
+
+	    std::fill(_data, _data + newSize, T());
+	    for (std::uint32_t i = 0; i < cpRow; i++)
+	    {
+		for (std::uint32_t j = 0; j < cpCol; j++)
+		    _data[newLayout.index(i, j)] = aside[(std::size_t)i * cpCol + j];
+	    }
+	    _set_mapped_shape(row_, col_, newLayout);
+	    return true;
+	}
+    bool _resize_mapped(const std::size_t elems)
+	{
+	    if(!_file.resize(sizeof(mapped_header) + elems * sizeof(T)))
+		return false;
+	    _data = (T*)((mapped_header*)_file.data())->payload();
+	    return true;
+	}
+    void _set_mapped_shape(const std::uint32_t row_, const std::uint32_t col_, const Layout& newLayout)
+	{
+	    mapped_header* header = (mapped_header*)_file.data();
+	    header->dims[0] = row_;
+	    header->dims[1] = col_;
+	    header->payload_size = newLayout.storage_size() * sizeof(T);
+	    row = row_;
+	    col = col_;
+	    _layout = newLayout;
+	}
+
+    Layout _layout;
+    mapped_file _file;
     T* _data;
 };
 
+//**************** vector ****************
+/*
+  vec<N, T> is built from two parts,
+  vec_storage<N, T>, the memory layout(2, 3 and 4 components can be reached by name),
+  vec_expr<E, N, T>, the lazy expression interface.
+
+  arithmetic on vectors doesn't compute anything, it builds a light expression object,
+  e.g. a + b * s - c is a tree of (a, (b, s), c) references,
+  and the whole tree is evaluated component by component in a single pass
+  when it's assigned to(or converted to) a vec, no temporary vec is created in between.
+
+  NOTE: an expression keeps references to its vec operands,
+  so don't hold an expression(auto e = a + b;) longer than its operands.
+*/
+
+template<std::uint8_t N, typename T>
+struct vec;
+
+template<typename E, std::uint8_t N, typename T>
+struct vec_expr;
+
+// variadic reduce helpers for unrolled component loops
 template<typename T>
-struct vec2
+constexpr T vec_sum(const T a)
 {
-    static_assert(std::is_signed<T>::value, "vec2<T>, T must be a signed type");
-    union
-    {
-	struct { T x, y; };
-	struct { T r, g; };
-	struct { T s, t; };
-    };
-    vec2():x(0),y(0){}
-    vec2(T x_, T y_):
-	x(x_),
-	y(y_)
-	{}
+    return a;
+}
+template<typename T, typename ... Args>
+constexpr T vec_sum(const T a, const Args ... args)
+{
+    return a + vec_sum<T>(args ...);
+}
 
-    template <typename o_t>
-    vec2 (const vec2<o_t>& o):
-	x(o.x),
-	y(o.y)
-	{}
-    
-    T& operator[](std::uint8_t idx)
+constexpr bool vec_all(const bool a)
+{
+    return a;
+}
+template<typename ... Args>
+constexpr bool vec_all(const bool a, const Args ... args)
+{
+    return a && vec_all(args ...);
+}
+
+template<typename ... Args>
+struct vec_all_scalar : public std::true_type {};
+template<typename A, typename ... Args>
+struct vec_all_scalar<A, Args ...> :
+    public std::integral_constant<bool, std::is_scalar<A>::value && vec_all_scalar<Args ...>::value> {};
+
+// expressions hold their vec operands by reference, and sub-expressions by value
+template<typename E>
+struct vec_nested
+{
+    typedef const E type;
+};
+template<std::uint8_t N, typename T>
+struct vec_nested<vec<N, T>>
+{
+    typedef const vec<N, T>& type;
+};
+
+template<typename E, typename Op, std::uint8_t N, typename T>
+struct vec_unary_expr;
+
+struct vec_op_add { template<typename A, typename B> static constexpr auto apply(const A a, const B b) -> decltype(a + b) { return a + b; } };
+struct vec_op_sub { template<typename A, typename B> static constexpr auto apply(const A a, const B b) -> decltype(a - b) { return a - b; } };
+struct vec_op_mul { template<typename A, typename B> static constexpr auto apply(const A a, const B b) -> decltype(a * b) { return a * b; } };
+struct vec_op_div { template<typename A, typename B> static constexpr auto apply(const A a, const B b) -> decltype(a / b) { return a / b; } };
+struct vec_op_neg { template<typename A> static constexpr A apply(const A a) { return -a; } };
+struct vec_op_abs { template<typename A> static constexpr A apply(const A a) { return a > 0 ? a : -a; } };
+
+/*
+ *@brief, CRTP base of vec and of every vector expression
+ E must provide template<std::size_t I> T get() const
+ */
+template<typename E, std::uint8_t N, typename T>
+struct vec_expr
+{
+    typedef T value_type;
+    static constexpr std::uint8_t dimension = N;
+
+    constexpr const E& self() const
 	{
-	    assert(idx < 2);
-	    return ((&(this->x))[idx]);
+	    return static_cast<const E&>(*this);
 	}
 
-    const T& operator[](std::uint8_t idx)const
+    // force evaluation
+    constexpr vec<N, T> eval() const
 	{
-	    assert(idx < 2);
-	    return ((&(this->x))[idx]);
+	    return vec<N, T>(*this);
 	}
-    bool operator<(const vec2& o)
+
+    constexpr T sqMagnitude() const
 	{
-	    return (x < o.x) && (y < o.y);
+	    return _sqMagnitude(std::make_index_sequence<N>());
 	}
-    bool operator>(const vec2& o)
+    T magnitude() const
 	{
-	    return (x > o.x) && (y > o.y);
+	    return std::sqrt(sqMagnitude());
 	}
-    bool operator<=(const vec2& o)
+    vec<N, T> normalize() const
 	{
-	    return (this->x <= o.x) && (this-y <= o.y);
+	    const vec<N, T> v(*this);
+	    return v / v.magnitude();
 	}
-    bool operator>=(const vec2& o)
+    constexpr vec_unary_expr<E, vec_op_abs, N, T> abs() const
 	{
-	    return (this->x >= o.x) && (this->y >= o.y);
+	    return vec_unary_expr<E, vec_op_abs, N, T>(self());
 	}
 
-    vec2 operator - (const vec2 & o) const
+    template<typename R>
+    constexpr T sqDistance(const vec_expr<R, N, T>& o) const
 	{
-	    return vec2(x - o.x, y - o.y);
+	    return _sqDistance(o.self(), std::make_index_sequence<N>());
 	}
-    void operator -=(const vec2 & o)
+    template<typename R>
+    T distance(const vec_expr<R, N, T>& o) const
 	{
-	    x -= o.x;
-	    y -= o.y;
+	    return std::sqrt(sqDistance(o));
 	}
-    template <typename S>
-    vec2 operator*(const S scalar) const
+private:
+    static constexpr T _sq(const T v)
+	{
+	    return v * v;
+	}
+    template<std::size_t ... I>
+    constexpr T _sqMagnitude(std::index_sequence<I ...>) const
 	{
-	    return vec2(x * scalar, y * scalar);
+	    return vec_sum<T>(_sq(self().template get<I>()) ...);
 	}
+    template<typename R, std::size_t ... I>
+    constexpr T _sqDistance(const R& o, std::index_sequence<I ...>) const
+	{
+	    return vec_sum<T>(_sq(self().template get<I>() - o.template get<I>()) ...);
+	}
+};
+
+template<typename L, typename R, typename Op, std::uint8_t N, typename T>
+struct vec_binary_expr : public vec_expr<vec_binary_expr<L, R, Op, N, T>, N, T>
+{
+    constexpr vec_binary_expr(const L& l_, const R& r_): l(l_), r(r_) {}
 
-    template <typename S>
-    void operator*=(const S scalar)
+    template<std::size_t I>
+    constexpr T get() const
 	{
-	    x *= scalar;
-	    y *= scalar;
+	    return T(Op::apply(l.template get<I>(), r.template get<I>()));
 	}
 
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec2>::type operator /(const S scalar) const
+    typename vec_nested<L>::type l;
+    typename vec_nested<R>::type r;
+};
+
+template<typename E, typename S, typename Op, std::uint8_t N, typename T>
+struct vec_scalar_expr : public vec_expr<vec_scalar_expr<E, S, Op, N, T>, N, T>
+{
+    constexpr vec_scalar_expr(const E& e_, const S scalar_): e(e_), scalar(scalar_) {}
+
+    template<std::size_t I>
+    constexpr T get() const
 	{
-	    return vec2(x / scalar, y / scalar);
+	    return T(Op::apply(e.template get<I>(), scalar));
 	}
-    
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec2&>::type operator /=(const S scalar)
+
+    typename vec_nested<E>::type e;
+    const S scalar;
+};
+
+template<typename E, typename Op, std::uint8_t N, typename T>
+struct vec_unary_expr : public vec_expr<vec_unary_expr<E, Op, N, T>, N, T>
+{
+    constexpr vec_unary_expr(const E& e_): e(e_) {}
+
+    template<std::size_t I>
+    constexpr T get() const
 	{
-	    x /= scalar;
-	    y /= scalar;
+	    return T(Op::apply(e.template get<I>()));
+	}
 
-	    return *this;
+    typename vec_nested<E>::type e;
+};
+
+template<std::uint8_t N, typename T>
+struct vec_storage : public vec_expr<vec<N, T>, N, T>
+{
+    template<typename ... Args>
+    constexpr vec_storage(const Args ... args): v{args ...} {}
+
+    template<std::size_t I>
+    constexpr const T& get() const
+	{
+	    return v[I];
 	}
-    T magnitude() const
+    template<std::size_t I>
+    T& get()
 	{
-	    return std::sqrt(x * x + y * y);
+	    return v[I];
 	}
-};
+    T* data() { return v; }
+    const T* data() const { return v; }
 
-typedef vec2<float> vec2f;
+    T v[N];
+};
 
 template<typename T>
-struct vec3
+struct vec_storage<2, T> : public vec_expr<vec<2, T>, 2, T>
 {
-    static_assert(std::is_signed<T>::value, "vec3<T>, T must be a signed type");
+    constexpr vec_storage(const T x_, const T y_): x(x_), y(y_) {}
     union
     {
-	struct { T x, y, z; };
-	struct { T r, g, b; };
-	struct { T s, t, u; };
+	struct { T x, y; };
+	struct { T r, g; };
+	struct { T s, t; };
     };
-    vec3():x(0),y(0), z(0){}
-    vec3(T x_, T y_, T z_):
-	x(x_),
-	y(y_),
-	z(z_)
-	{} 
-    
-    constexpr vec3(const T& o):
-	x(o),
-	y(o),
-	z(o)
-	{}
 
-    vec3(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v):
-	x(v[0]),
-	y(v[1]),
-	z(v[2])
+    template<std::size_t I>
+    constexpr const T& get() const
 	{
-	    assert(v.size() >= 3);
+	    static_assert(I < 2, "vec<2, T>::get<I>, I out of range");
+	    return I == 0 ? x : y;
 	}
-
-    void operator=(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v)
+    template<std::size_t I>
+    T& get()
 	{
-	    assert(v.size() >= 3);
-	    std::memcpy(this, v.data(), 3 * sizeof(T));
+	    return const_cast<T&>(static_cast<const vec_storage&>(*this).template get<I>());
 	}
-    
-    T sqDistance(const vec3 & o) const
+    T* data() { return &x; }
+    const T* data() const { return &x; }
+};
+
+template<typename T>
+struct vec_storage<3, T> : public vec_expr<vec<3, T>, 3, T>
+{
+    constexpr vec_storage(const T x_, const T y_, const T z_): x(x_), y(y_), z(z_) {}
+    union
+    {
+	struct { T x, y, z; };
+	struct { T r, g, b; };
+	struct { T s, t, u; };
+    };
+
+    template<std::size_t I>
+    constexpr const T& get() const
 	{
-	    return std::pow(x - o.x, 2) + std::pow(y - o.y, 2) + std::pow(z - z.z, 2);
+	    static_assert(I < 3, "vec<3, T>::get<I>, I out of range");
+	    return I == 0 ? x : (I == 1 ? y : z);
 	}
-    T distance(const vec3 & o) const
+    template<std::size_t I>
+    T& get()
 	{
-	    return std::sqrt(std::pow(x - o.x, 2) + std::pow(y - o.y, 2) + std::pow(z - z.z, 2));
+	    return const_cast<T&>(static_cast<const vec_storage&>(*this).template get<I>());
 	}
-    T sqMagnitude() const
+    T* data() { return &x; }
+    const T* data() const { return &x; }
+};
+
+template<typename T>
+struct vec_storage<4, T> : public vec_expr<vec<4, T>, 4, T>
+{
+    constexpr vec_storage(const T x_, const T y_, const T z_, const T w_): x(x_), y(y_), z(z_), w(w_) {}
+    union
+    {
+	struct { T x, y, z, w; };
+	struct { T r, g, b, a; };
+	struct { T s, t, p, q; };
+    };
+
+    template<std::size_t I>
+    constexpr const T& get() const
 	{
-	    return x * x + y * y + z * z;
+	    static_assert(I < 4, "vec<4, T>::get<I>, I out of range");
+	    return I == 0 ? x : (I == 1 ? y : (I == 2 ? z : w));
 	}
-    T magnitude() const
+    template<std::size_t I>
+    T& get()
 	{
-	    return std::sqrt(sqMagnitude());
+	    return const_cast<T&>(static_cast<const vec_storage&>(*this).template get<I>());
 	}
+    T* data() { return &x; }
+    const T* data() const { return &x; }
+};
+
+template<std::uint8_t N, typename T>
+struct vec_register
+{
+    struct type {};
+};
 
-    vec3 normalize() const
+#if defined(GB_PHYSICS_SSE)
+template<>
+struct vec_register<4, float>
+{
+    typedef __m128 type;
+};
+
+/*
+ *@brief, vec<4, float> lives in one xmm register,
+ same interface as vec<4, T>, but +, -, *, / are single SSE instructions(see bellow)
+ */
+template <>
+struct alignas(16) vec_storage<4, float> : public vec_expr<vec<4, float>, 4, float>
+{
+    constexpr vec_storage(const float x_, const float y_, const float z_, const float w_): x(x_), y(y_), z(z_), w(w_) {}
+    vec_storage(const __m128 m_): m(m_) {}
+    union
+    {
+	struct { float x, y, z, w; };
+	struct { float r, g, b, a; };
+	struct { float s, t, p, q; };
+	__m128 m;
+    };
+
+    template<std::size_t I>
+    constexpr const float& get() const
 	{
-	    const T mag = magnitude();
-	    return vec3(x / mag, y / mag, z / mag);
+	    static_assert(I < 4, "vec<4, T>::get<I>, I out of range");
+	    return I == 0 ? x : (I == 1 ? y : (I == 2 ? z : w));
 	}
-    T& operator[](std::uint8_t idx)
+    template<std::size_t I>
+    float& get()
 	{
-	    assert(idx < 3);
-	    return ((&(this->x))[idx]);
+	    return const_cast<float&>(static_cast<const vec_storage&>(*this).template get<I>());
 	}
+    float* data() { return &x; }
+    const float* data() const { return &x; }
+};
+#endif
 
-    const T& operator[](std::uint8_t idx)const
+template<std::uint8_t N, typename T>
+struct vec : public vec_storage<N, T>
+{
+    static_assert(std::is_signed<T>::value, "vec<N, T>, T must be a signed type");
+    typedef vec_storage<N, T> storage_type;
+private:
+    struct _fill_tag {};
+    struct _eval_tag {};
+    struct _convert_tag {};
+    template<std::size_t ... I>
+    constexpr vec(const T& o, _fill_tag, std::index_sequence<I ...>):
+	storage_type(((void)I, o) ...)
+	{}
+    template<typename E, std::size_t ... I>
+    constexpr vec(const E& e, _eval_tag, std::index_sequence<I ...>):
+	storage_type(e.template get<I>() ...)
+	{}
+    template<typename U, std::size_t ... I>
+    constexpr vec(const vec<N, U>& o, _convert_tag, std::index_sequence<I ...>):
+	storage_type(T(o.template get<I>()) ...)
+	{}
+    template<typename E, std::size_t ... I>
+    void _assign(const E& e, std::index_sequence<I ...>)
 	{
-	    assert(idx < 3);
-	    return ((&(this->x))[idx]);
+	    // each component only reads the same component of its operands, so aliasing is fine
+	    const int swallow[] = {0, ((this->template get<I>() = e.template get<I>()), 0) ...};
+	    (void)swallow;
 	}
-    vec3 operator+(const vec3& o) const
+public:
+    constexpr vec(): vec(T(0)) {}
+
+    // broadcast
+    constexpr vec(const T& o): vec(o, _fill_tag(), std::make_index_sequence<N>()) {}
+
+    // component wise, vec3f(x, y, z)
+    template<typename ... Args,
+	     typename = typename std::enable_if<sizeof...(Args) == N && (N > 1) && vec_all_scalar<Args ...>::value>::type>
+    constexpr vec(const Args ... args):
+	storage_type(T(args) ...)
+	{}
+
+    // evaluate an expression in one pass
+    template<typename E>
+    constexpr vec(const vec_expr<E, N, T>& e): vec(e.self(), _eval_tag(), std::make_index_sequence<N>()) {}
+
+    template<typename U, typename = typename std::enable_if<!std::is_same<U, T>::value>::type>
+    constexpr vec(const vec<N, U>& o): vec(o, _convert_tag(), std::make_index_sequence<N>()) {}
+
+    // homogeneous point, vec4(vec3) = (x, y, z, 1)
+    template<std::uint8_t M, typename = typename std::enable_if<N == 4 && M == 3>::type>
+    constexpr vec(const vec<M, T>& o): storage_type(o.x, o.y, o.z, T(1)) {}
+
+    // straight from a simd register, only vec<4, float> has one
+    vec(const typename vec_register<N, T>::type m_): storage_type(m_) {}
+
+    vec(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v):
+	vec()
 	{
-	    return vec3(x + o.x, y + o.y, z + o.z);
+	    assert(v.size() >= N);
+	    std::memcpy(this->data(), v.data(), N * sizeof(T));
 	}
-    vec3 & operator +=(const vec3& o)
-	{
-	    x += o.x;
-	    y += o.y;
-	    z += o.z;
 
-	    return *this;
-	}
-    vec3 operator-(const vec3& o) const
+    void operator=(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v)
 	{
-	    return vec3(x - o.x, y - o.y, z - o.z);
+	    assert(v.size() >= N);
+	    std::memcpy(this->data(), v.data(), N * sizeof(T));
 	}
-    void operator-=(const vec3 & o)
+
+    template<typename E>
+    vec& operator=(const vec_expr<E, N, T>& e)
 	{
-	    x -= o.x;
-	    y -= o.y;
-	    z -= o.z;
+	    _assign(e.self(), std::make_index_sequence<N>());
+	    return *this;
 	}
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec3>::type operator*(const S scalar) const
+
+    // assign the leading M components, the rest keep their value
+    template<std::uint8_t M, typename = typename std::enable_if<(M < N)>::type>
+    void operator=(const vec<M, T>& o)
 	{
-	    return vec3(x * scalar, y * scalar, z * scalar);
+	    std::memcpy(this->data(), o.data(), M * sizeof(T));
 	}
-    template <typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec3&>::type operator *=(const S scalar)
-	{
-	    x *= scalar;
-	    y *= scalar;
-	    z *= scalar;
 
-	    return *this;
-	}
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec3>::type operator/(const S scalar) const
+    // truncation, (vec3<T>)v4
+    template<std::uint8_t M, typename = typename std::enable_if<(M < N)>::type>
+    explicit operator vec<M, T>() const
 	{
-	    return vec3(x / scalar, y / scalar, z / scalar);
+	    vec<M, T> ret;
+	    std::memcpy(ret.data(), this->data(), M * sizeof(T));
+	    return ret;
 	}
 
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec3&>::type operator/=(const S scalar)
+    T& operator[](const std::uint8_t idx)
 	{
-	    x /= scalar;
-	    y /= scalar;
-	    z /= scalar;
-	    return *this;
+	    assert(idx < N);
+	    return this->data()[idx];
 	}
-    bool operator<(const vec3& o) const
+    const T& operator[](const std::uint8_t idx) const
 	{
-	    return (x < o.x) && (y < o.y) && (z < o.z);
+	    assert(idx < N);
+	    return this->data()[idx];
 	}
-    bool operator<=(const vec3& o) const
+
+    template<typename E>
+    vec& operator+=(const vec_expr<E, N, T>& e)
 	{
-	    return (x <= o.x) && (y < o.y) && (z < o.z);
+	    return *this = *this + e;
 	}
-    bool operator>(const vec3& o) const
+    template<typename E>
+    vec& operator-=(const vec_expr<E, N, T>& e)
 	{
-	    return (x > o.x) && (y > o.y) && (z > o.z);
+	    return *this = *this - e;
 	}
-    bool operator >=(const vec3& o) const
+    template<typename S>
+    typename std::enable_if<std::is_scalar<S>::value, vec&>::type operator*=(const S scalar)
 	{
-	    return (x >= o.x) && (y > o.y) && (z >= o.z);
+	    return *this = *this * scalar;
 	}
-
-    vec3 abs() const
+    template<typename S>
+    typename std::enable_if<std::is_scalar<S>::value, vec&>::type operator/=(const S scalar)
 	{
-	    return vec3(x > 0 ? x : -x, y > 0 ? y : -y, z > 0 ? z : -z);
+	    return *this = *this / scalar;
 	}
 };
 
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr vec_binary_expr<L, R, vec_op_add, N, T> operator+(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_binary_expr<L, R, vec_op_add, N, T>(l.self(), r.self());
+}
+
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr vec_binary_expr<L, R, vec_op_sub, N, T> operator-(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_binary_expr<L, R, vec_op_sub, N, T>(l.self(), r.self());
+}
+
+template<typename E, std::uint8_t N, typename T>
+constexpr vec_unary_expr<E, vec_op_neg, N, T> operator-(const vec_expr<E, N, T>& e)
+{
+    return vec_unary_expr<E, vec_op_neg, N, T>(e.self());
+}
+
+template<typename E, typename S, std::uint8_t N, typename T>
+constexpr typename std::enable_if<std::is_scalar<S>::value, vec_scalar_expr<E, S, vec_op_mul, N, T>>::type
+operator*(const vec_expr<E, N, T>& e, const S scalar)
+{
+    return vec_scalar_expr<E, S, vec_op_mul, N, T>(e.self(), scalar);
+}
+
+template<typename E, typename S, std::uint8_t N, typename T>
+constexpr typename std::enable_if<std::is_scalar<S>::value, vec_scalar_expr<E, S, vec_op_mul, N, T>>::type
+operator*(const S scalar, const vec_expr<E, N, T>& e)
+{
+    return vec_scalar_expr<E, S, vec_op_mul, N, T>(e.self(), scalar);
+}
+
+template<typename E, typename S, std::uint8_t N, typename T>
+constexpr typename std::enable_if<std::is_scalar<S>::value, vec_scalar_expr<E, S, vec_op_div, N, T>>::type
+operator/(const vec_expr<E, N, T>& e, const S scalar)
+{
+    return vec_scalar_expr<E, S, vec_op_div, N, T>(e.self(), scalar);
+}
+
+template<typename L, typename R, std::size_t ... I>
+constexpr bool vec_all_less(const L& l, const R& r, std::index_sequence<I ...>)
+{
+    return vec_all((l.template get<I>() < r.template get<I>()) ...);
+}
+template<typename L, typename R, std::size_t ... I>
+constexpr bool vec_all_less_equal(const L& l, const R& r, std::index_sequence<I ...>)
+{
+    return vec_all((l.template get<I>() <= r.template get<I>()) ...);
+}
+
+// component wise, true only if it holds for every component
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr bool operator<(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_all_less(l.self(), r.self(), std::make_index_sequence<N>());
+}
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr bool operator>(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_all_less(r.self(), l.self(), std::make_index_sequence<N>());
+}
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr bool operator<=(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_all_less_equal(l.self(), r.self(), std::make_index_sequence<N>());
+}
+template<typename L, typename R, std::uint8_t N, typename T>
+constexpr bool operator>=(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_all_less_equal(r.self(), l.self(), std::make_index_sequence<N>());
+}
+
+#if defined(GB_PHYSICS_SSE)
+// vec<4, float> is evaluated eagerly, one instruction is cheaper than any expression
+inline vec<4, float> operator+(const vec<4, float>& l, const vec<4, float>& r)
+{
+    return _mm_add_ps(l.m, r.m);
+}
+inline vec<4, float> operator-(const vec<4, float>& l, const vec<4, float>& r)
+{
+    return _mm_sub_ps(l.m, r.m);
+}
+template<typename S>
+typename std::enable_if<std::is_scalar<S>::value, vec<4, float>>::type operator*(const vec<4, float>& v, const S scalar)
+{
+    return _mm_mul_ps(v.m, _mm_set1_ps((float)scalar));
+}
+template<typename S>
+typename std::enable_if<std::is_scalar<S>::value, vec<4, float>>::type operator/(const vec<4, float>& v, const S scalar)
+{
+    return _mm_div_ps(v.m, _mm_set1_ps((float)scalar));
+}
+#endif
+
+template<typename T>
+using vec2 = vec<2, T>;
+template<typename T>
+using vec3 = vec<3, T>;
+template<typename T>
+using vec4 = vec<4, T>;
+
+typedef vec2<float> vec2f;
 typedef vec3<float> vec3f;
+typedef vec4<float> vec4f;
+
+static_assert(sizeof(vec3f) == 3 * sizeof(float), "vec3f must be tightly packed");
+static_assert(sizeof(vec4f) == 4 * sizeof(float), "vec4f must be tightly packed");
 
 template<typename T>
 vec3<T> meanVec3(const vec3<T> * data, const std::size_t count)
 {
+    // sum first, divide once
     vec3<T> ret;
     for(std::size_t i = 0; i < count; i++)
     {
-	ret += data[i] / count;
+	ret += data[i];
     }
 
-    return ret;
+    return ret / count;
 }
 
-template <typename T>
-T dot(const vec3<T>& l, const vec3<T>& r)
+template<typename L, typename R, std::size_t ... I>
+constexpr typename L::value_type vec_dot(const L& l, const R& r, std::index_sequence<I ...>)
 {
-    return l.x * r.x + l.y * r.y + l.z * r.z;
+    return vec_sum<typename L::value_type>((l.template get<I>() * r.template get<I>()) ...);
 }
 
-template <typename T>
-vec3<T> cross(const vec3<T> & a, const vec3<T> & b)
+template <typename L, typename R, std::uint8_t N, typename T>
+constexpr T dot(const vec_expr<L, N, T>& l, const vec_expr<R, N, T>& r)
+{
+    return vec_dot(l.self(), r.self(), std::make_index_sequence<N>());
+}
+
+template <typename L, typename R, typename T>
+constexpr vec3<T> cross(const vec_expr<L, 3, T>& a_, const vec_expr<R, 3, T>& b_)
 {
     /*
 			| i  j  k  |
@@ -584,97 +1494,11 @@ vec3<T> cross(const vec3<T> & a, const vec3<T> & b)
 		        | Bx By Bz |
 
      */
-    
-    return vec3<T>(a.y * b.z - a.z * b.y, a.x * b.z - a.z * b.x, a.x * b.y - a.y * b.x);
+    return vec3<T>(a_.self().template get<1>() * b_.self().template get<2>() - a_.self().template get<2>() * b_.self().template get<1>(),
+		   a_.self().template get<2>() * b_.self().template get<0>() - a_.self().template get<0>() * b_.self().template get<2>(),
+		   a_.self().template get<0>() * b_.self().template get<1>() - a_.self().template get<1>() * b_.self().template get<0>());
 }
 
-template <typename T>
-struct vec4
-{
-    static_assert(std::is_signed<T>::value, "vec4<T>, T must be a signed type");
-    union
-    {
-	struct { T x, y, z, w; };
-	struct { T r, g, b, a; };
-	struct { T s, t, p, q; };
-    };
-
-    vec4(): x(0), y(0), z(0), w(0){}
-    vec4(T x_, T y_, T z_, T w_): x(x_), y(y_), z(z_), w(w_){}
-    
-    vec4(const vec3<T>& o):
-	x(o.x), y(o.y), z(o.z), w(1)
-	{}
-    vec4(const T val):
-	x(val),
-	y(val),
-	z(val),
-	w(val)
-	{}
-    
-    vec4(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v):
-	x(v[0]),
-	y(v[1]),
-	z(v[2]),
-	w(v[3])
-    {
-	assert(v.size() >= 4);
-    }
-
-    void operator=(const typename std::conditional<is_Float<T>::value, std::vector<float>, std::vector<T>>::type& v)
-    {
-	assert(v.size() >= 4);
-	std::memcpy(this, v.data(), 4 * sizeof(T));
-    }
-    
-    explicit operator vec3<T>() const
-	{
-	    return vec3<T>(x, y, z);
-	}
-    void operator=(const vec3<T>& v3)
-	{
-	    std::memcpy(this, &v3, 3 * sizeof(T));
-	}
-
-    const T & operator[](const std::uint8_t idx) const
-	{
-	    assert(idx <=3);
-	    return (&(this->x))[idx];
-	}
-    T & operator[] (const std::uint8_t idx)
-	{
-	    assert(idx <=3);
-	    return (&(this->x))[idx];
-	}
-
-    vec4<T> operator + (const vec4<T>& o) const
-	{
-	    return vec4( x + o.x, y + o.y, z + o.z, w + o.w);
-	}
-    template<typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec4<T>>::type operator * (const S scalar) const
-	{
-	    return vec4(x * scalar, y * scalar, z * scalar, w * scalar);
-	}
-
-    template <typename S>
-    typename std::enable_if<std::is_scalar<S>::value, void>::type operator *= (const S scalar)
-	{
-	    x *= scalar;
-	    y *= scalar;
-	    z *= scalar;
-	    w *= scalar;
-	}
-
-    template <typename S>
-    typename std::enable_if<std::is_scalar<S>::value, vec4<T>>::type operator / (const S scalar) const
-	{
-	    return vec4(x / scalar, y / scalar, z / scalar, w / scalar);
-	}
-};
-
-typedef vec4<float> vec4f;
-
 template<typename T>
 std::int8_t sign(const T val)
 {
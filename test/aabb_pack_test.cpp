@@ -0,0 +1,115 @@
+#include "../src/aabb_pack.h"
+#include "../src/cpu.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+static aabb<float> aabb_pack_random_box()
+{
+    const vec3f lower((float)(rand() % 200 - 100), (float)(rand() % 200 - 100), (float)(rand() % 200 - 100));
+    const vec3f size((float)(rand() % 40), (float)(rand() % 40), (float)(rand() % 40));
+    return aabb<float>(lower, lower + size);
+}
+
+// exact sphere/box test, the reference of the sphere kernels
+static bool aabb_pack_sphere_overlap(const aabb<float>& bb, const spherebb<float>& s)
+{
+    float sqDist = 0;
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	const float l = bb.diagonal[0][c], u = bb.diagonal[1][c], x = s.centre[c];
+	const float d = x < l ? l - x : (x > u ? x - u : 0);
+	sqDist += d * d;
+    }
+    return sqDist <= s.radius * s.radius;
+}
+
+template<std::size_t N>
+static int aabb_pack_inline_test(const std::vector<aabb<float>>& boxes, const std::vector<aabb<float>>& queries, const std::vector<spherebb<float>>& spheres)
+{
+    // last lane left empty
+    aabb_pack<N> p = aabb_pack<N>::make_empty();
+    for(std::size_t l = 0; l + 1 < N; l++)
+	p.set(l, boxes[l]);
+    if(p.get(1).diagonal[1].y != boxes[1].diagonal[1].y || p.get(1).diagonal[0].z != boxes[1].diagonal[0].z)
+	return 1;
+    for(std::size_t q = 0; q < queries.size(); q++)
+    {
+	unsigned expected = 0, expectedSphere = 0;
+	for(std::size_t l = 0; l + 1 < N; l++)
+	{
+	    expected |= (boxes[l].intersect(queries[q]) ? 1u : 0u) << l;
+	    expectedSphere |= (aabb_pack_sphere_overlap(boxes[l], spheres[q]) ? 1u : 0u) << l;
+	}
+	if(overlapMask(p, queries[q]) != expected || overlapMask(p, spheres[q]) != expectedSphere)
+	    return 1;
+    }
+    return 0;
+}
+
+static int aabb_pack_level_test(const std::vector<aabb<float>>& boxes, const std::vector<aabb<float>>& queries, const std::vector<spherebb<float>>& spheres)
+{
+    // the last pack half full
+    const std::size_t count = (boxes.size() + 15) / 16;
+    std::vector<aabb16> packs(count, aabb16::make_empty());
+    for(std::size_t i = 0; i < boxes.size(); i++)
+	packs[i / 16].set(i % 16, boxes[i]);
+
+    std::vector<std::uint16_t> masks(count);
+    for(std::uint8_t p = 0; p < 2; p++)
+    {
+	for(std::size_t q = 0; q < 8; q++)
+	{
+	    overlapMasks(packs.data(), count, queries[q], masks.data(), p != 0);
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		if(masks[i] != overlapMask(packs[i], queries[q]))
+		    return 1;
+	    }
+	    overlapMasks(packs.data(), count, spheres[q], masks.data(), p != 0);
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		if(masks[i] != overlapMask(packs[i], spheres[q]))
+		    return 1;
+	    }
+	}
+    }
+    return 0;
+}
+
+int aabb_pack_test(const std::size_t count = 20008)
+{
+    std::vector<aabb<float>> boxes(count), queries(256);
+    std::vector<spherebb<float>> spheres(256);
+    for(std::size_t i = 0; i < count; i++)
+	boxes[i] = aabb_pack_random_box();
+    for(std::size_t i = 0; i < queries.size(); i++)
+    {
+	queries[i] = aabb_pack_random_box();
+	spheres[i] = spherebb<float>(vec3f((float)(rand() % 200 - 100), (float)(rand() % 200 - 100), (float)(rand() % 200 - 100)), (float)(rand() % 60));
+    }
+    // touching boxes don't overlap, a touching sphere does
+    queries[0] = aabb<float>(boxes[0].diagonal[1], boxes[0].diagonal[1] + vec3f(1, 1, 1));
+    spheres[0] = spherebb<float>(boxes[0].diagonal[1] + vec3f(3, 4, 0), 5);
+
+    if(aabb_pack_inline_test<4>(boxes, queries, spheres) != 0
+       || aabb_pack_inline_test<8>(boxes, queries, spheres) != 0
+       || aabb_pack_inline_test<16>(boxes, queries, spheres) != 0)
+	return 1;
+    if((overlapMask(aabb4::make_empty(), queries[1]) | overlapMask(aabb4::make_empty(), spheres[1])) != 0)
+	return 1;
+
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	if(aabb_pack_level_test(boxes, queries, spheres) != 0)
+	{
+	    std::cout << "aabb_pack_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
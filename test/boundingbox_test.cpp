@@ -0,0 +1,394 @@
+#include "../src/boundingbox.h"
+#include "../src/sptree.h"
+#include "../src/cpu.h"
+#include "../src/quat.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+// even integer extents, so the centre/half boxes are exact
+static aabb<float> boundingbox_random_box()
+{
+    const vec3f lower((float)(rand() % 200 - 100), (float)(rand() % 200 - 100), (float)(rand() % 200 - 100));
+    const vec3f size((float)(rand() % 20 * 2), (float)(rand() % 20 * 2), (float)(rand() % 20 * 2));
+    return aabb<float>(lower, lower + size);
+}
+
+static bool boundingbox_same(const aabb<float>& a, const aabb<float>& b)
+{
+    for(std::uint8_t d = 0; d < 2; d++)
+    {
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    if(a.diagonal[d][c] != b.diagonal[d][c] || a.lenSide[c] != b.lenSide[c])
+		return false;
+	}
+    }
+    return true;
+}
+
+static int boundingbox_compact_test(const std::vector<aabb<float>>& boxes, const std::vector<spherebb<float>>& spheres)
+{
+    for(std::size_t i = 0; i + 1 < boxes.size(); i++)
+    {
+	const aabb<float>& a = boxes[i];
+	const aabb<float>& b = boxes[i + 1];
+	const aabb_minmax<float> ma(a), mb(b);
+	const aabb_centre<float> ca(a), cb(b);
+	if(!boundingbox_same(ma.to_aabb(), a) || !boundingbox_same(ca.to_aabb(), a))
+	    return 1;
+
+	const bool intersect = a.intersect(b), contain = a.contain(b);
+	if(ma.intersect(mb) != intersect || ca.intersect(cb) != intersect
+	   || ma.contain(mb) != contain || ca.contain(cb) != contain)
+	    return 1;
+
+	const spherebb<float>& s = spheres[i];
+	const bool sIntersect = a.intersect(s), sContain = a.contain(s);
+	if(ma.intersect(s) != sIntersect || ca.intersect(s) != sIntersect
+	   || ma.contain(s) != sContain || ca.contain(s) != sContain)
+	    return 1;
+    }
+
+    // a box in itself, touching boxes
+    const aabb_minmax<float> unit(vec3f(0, 0, 0), vec3f(1, 1, 1)), next(vec3f(1, 0, 0), vec3f(2, 1, 1));
+    if(!unit.contain(unit) || unit.intersect(next) || aabb_centre<float>(unit).intersect(aabb_centre<float>(next)))
+	return 1;
+    return 0;
+}
+
+static int boundingbox_q8_test(const std::vector<aabb<float>>& boxes)
+{
+    const aabb_minmax<float> parent(vec3f(-110, -110, -110), vec3f(150, 150, 150));
+    for(std::size_t i = 0; i + 1 < boxes.size(); i++)
+    {
+	const aabb_minmax<float> a(boxes[i]), b(boxes[i + 1]);
+	const aabb_q8 qa = aabb_q8::encode(a, parent), qb = aabb_q8::encode(b, parent);
+
+	// conservative: the decoded box holds the original one
+	const aabb_minmax<float> da = qa.decode(parent), db = qb.decode(parent);
+	if(!da.contain(a))
+	    return 1;
+	// the integer tests are the decoded box tests
+	if(qa.intersect(qb) != da.intersect(db) || qa.contain(qb) != da.contain(db))
+	    return 1;
+	// never misses an overlap
+	if(a.intersect(b) && !qa.intersect(qb))
+	    return 1;
+    }
+
+    // outside the parent clamps to its border, the whole parent is 0..255
+    const aabb_q8 whole = aabb_q8::encode(aabb_minmax<float>(vec3f(-200, -200, -200), vec3f(200, 200, 200)), parent);
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	if(whole.lower[c] != 0 || whole.upper[c] != 255)
+	    return 1;
+    }
+    return 0;
+}
+
+// octree children boxes are derived from the parent box
+struct boundingbox_element
+{
+    struct contain
+    {
+	bool operator()(const boundingbox_element* e, const aabb<>& o) const
+	    {
+		return o.contain(e->bb);
+	    }
+    };
+    struct arbitrary_point_getter
+    {
+	const vec3f& operator()(const boundingbox_element* e) const
+	    {
+		return e->centre;
+	    }
+    };
+    boundingbox_element(const vec3f& centre_):
+	centre(centre_),
+	bb(centre_ - vec3f(1, 1, 1), centre_ + vec3f(1, 1, 1))
+	{}
+    vec3f centre;
+    aabb<> bb;
+};
+
+static int boundingbox_octree_test()
+{
+    typedef octree<boundingbox_element*, boundingbox_element::contain, boundingbox_element::arbitrary_point_getter> octree_test;
+    octree_test oct(aabb<>(vec3f(0, 0, 0), vec3f(64, 64, 64)));
+    // the smallest octan holding each element
+    boundingbox_element elements[] = {vec3f(1.5f, 1.5f, 1.5f), vec3f(62, 2, 33), vec3f(40, 20, 50)};
+    const vec3f lowers[] = {vec3f(0, 0, 0), vec3f(60, 0, 32), vec3f(32, 16, 48)};
+    const float lenSides[] = {4, 4, 16};
+    for(std::uint8_t i = 0; i < 3; i++)
+    {
+	octree_test* node = nullptr;
+	oct.insert(&elements[i], node);
+	const aabb<float>& bb = node->getBB();
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    if(bb.diagonal[0][c] != lowers[i][c] || bb.diagonal[1][c] != lowers[i][c] + lenSides[i] || bb.lenSide[c] != lenSides[i])
+		return 1;
+	}
+    }
+    if(oct.size() != 3)
+	return 1;
+    for(boundingbox_element& e : elements)
+	oct.remove(&e);
+    return oct.size() == 0 ? 0 : 1;
+}
+
+static int boundingbox_api_test()
+{
+    aabb<float> a(vec3f(0, 0, 0), vec3f(1, 2, 3));
+    const aabb<float> b(vec3f(-1, 1, 1), vec3f(0.5f, 4, 2));
+    const aabb<float> m = a.merge(b);
+    if(!boundingbox_same(m, aabb<float>(vec3f(-1, 0, 0), vec3f(1, 4, 3))) || !m.contain(a) || !m.contain(b))
+	return 1;
+    if(a.surfaceArea() != 22 || a.volume() != 6 || a.centroid().y != 1 || a.centroid().z != 1.5f)
+	return 1;
+    a.expand(vec3f(0.5f, -2, 5));
+    if(!boundingbox_same(a, aabb<float>(vec3f(0, -2, 0), vec3f(1, 2, 5))))
+	return 1;
+    a.expand(b);
+    return boundingbox_same(a, aabb<float>(vec3f(-1, -2, 0), vec3f(1, 4, 5))) ? 0 : 1;
+}
+
+static aabb<float> boundingbox_points_ref(const vec3f* points, const std::size_t count)
+{
+    aabb<float> ret(points[0], points[0]);
+    for(std::size_t i = 1; i < count; i++)
+	ret.expand(points[i]);
+    return ret;
+}
+
+static int boundingbox_points_test(const std::size_t count)
+{
+    std::vector<vec3f> points(count);
+    std::vector<vec3<double>> pointsd(count);
+    for(std::size_t i = 0; i < count; i++)
+	points[i] = vec3f((float)(rand() % 20000 - 10000) / 7.0f, (float)(rand() % 20000 - 10000) / 7.0f, (float)(rand() % 20000 - 10000) / 7.0f);
+    // extremes at both ends, the last one in the tail
+    points[0].x = -2000;
+    points[count - 1].z = 2000;
+    for(std::size_t i = 0; i < count; i++)
+	pointsd[i] = vec3<double>(points[i].x, points[i].y, points[i].z);
+    const aabb<float> ref = boundingbox_points_ref(points.data(), count);
+
+    // generic version
+    for(std::uint8_t p = 0; p < 2; p++)
+    {
+	const aabb<double> bb = aabbFromPoints(pointsd.data(), count, p != 0);
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    if(bb.diagonal[0][c] != ref.diagonal[0][c] || bb.diagonal[1][c] != ref.diagonal[1][c])
+		return 1;
+	}
+    }
+
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	bool bFailed = !boundingbox_same(aabbFromPoints(points.data(), count), ref)
+	    || !boundingbox_same(aabbFromPoints(points.data(), count, true), ref);
+	// every tail length, from an odd start
+	for(std::size_t n = 1; n < 40 && !bFailed; n++)
+	    bFailed = !boundingbox_same(aabbFromPoints(points.data() + 3, n), boundingbox_points_ref(points.data() + 3, n));
+	if(bFailed)
+	{
+	    std::cout << "boundingbox_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
+
+template<typename T>
+static bool boundingbox_sphere_holds(const spherebb<T>& s, const std::vector<vec3<T>>& points)
+{
+    const double r = s.radius * (1 + 1e-5) + 1e-5;
+    for(const vec3<T>& p : points)
+    {
+	const double dx = p.x - (double)s.centre.x, dy = p.y - (double)s.centre.y, dz = p.z - (double)s.centre.z;
+	if(dx * dx + dy * dy + dz * dz > r * r)
+	    return false;
+    }
+    return true;
+}
+
+static int boundingbox_sphere_test(const std::size_t count)
+{
+    // on the sphere(c, 100) in random order, the minimal sphere is about that one
+    const vec3f c(5, -3, 7);
+    std::vector<vec3f> points(count);
+    std::vector<vec3<double>> pointsd(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	vec3<double> d;
+	do
+	    d = vec3<double>(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000);
+	while(d.sqDistance(vec3<double>(0, 0, 0)) < 1);
+	d = d * (100 / d.distance(vec3<double>(0, 0, 0)));
+	points[i] = vec3f((float)d.x + c.x, (float)d.y + c.y, (float)d.z + c.z);
+	pointsd[i] = vec3<double>(points[i].x, points[i].y, points[i].z);
+    }
+
+    for(std::uint8_t p = 0; p < 2; p++)
+    {
+	const spherebb<float> ritter = sphereFromPoints(points.data(), count, sphere_fit_ritter, p != 0);
+	const spherebb<float> tight = sphereFromPoints(points.data(), count, sphere_fit_tight, p != 0);
+	if(!boundingbox_sphere_holds(ritter, points) || !boundingbox_sphere_holds(tight, points))
+	    return 1;
+	if(tight.radius > ritter.radius || ritter.radius > 100 * 1.2f || tight.radius > 100 * 1.05f)
+	    return 1;
+
+	const spherebb<double> ritterd = sphereFromPoints(pointsd.data(), count, sphere_fit_ritter, p != 0);
+	if(!boundingbox_sphere_holds(ritterd, pointsd) || std::abs(ritterd.radius - ritter.radius) > 1e-3)
+	    return 1;
+    }
+
+    // every tail length from an odd start, one point, one point repeated
+    for(std::size_t n = 1; n < 40; n++)
+    {
+	const std::vector<vec3f> sub(points.begin() + 3, points.begin() + 3 + n);
+	if(!boundingbox_sphere_holds(sphereFromPoints(sub.data(), n, sphere_fit_tight), sub))
+	    return 1;
+    }
+    const std::vector<vec3f> same(9, c);
+    const spherebb<float> point = sphereFromPoints(same.data(), same.size());
+    if(point.radius != 0 || point.centre.x != c.x || point.centre.z != c.z)
+	return 1;
+
+    // merge and expand hold both
+    const spherebb<float> a(vec3f(0, 0, 0), 1), b(vec3f(4, 0, 0), 1);
+    const spherebb<float> m = a.merge(b);
+    if(m.radius != 3 || m.centre.x != 2 || !m.contain(a) || !m.contain(b) || a.merge(spherebb<float>(vec3f(0.5f, 0, 0), 0.25f)).radius != 1)
+	return 1;
+    spherebb<float> e = a;
+    e.expand(vec3f(0, 3, 0));
+    if(e.radius != 2 || e.centre.y != 1 || e.centre.x != 0)
+	return 1;
+
+    // a sheared transform stretches up to 1.618, beyond its longest column (sqrt 2)
+    const affine3f shear{{{1, 0, 0}, {1, 1, 0}, {0, 0, 1}, {2, -1, 3}}};
+    const spherebb<float> unit(vec3f(0, 0, 0), 1), sheared = unit * shear;
+    if(sheared.radius < 1.618f || affine3f::make_identity().max_scale() != 1)
+	return 1;
+    float far = 0;
+    for(int k = 0; k < 360; k++)
+    {
+	const float t = k * 0.0174533f;
+	const float d = (shear.transform_point(vec3f(std::cos(t), std::sin(t), 0)) - sheared.centre).magnitude();
+	if(d > far)
+	    far = d;
+    }
+    return far > 1.6f && far <= sheared.radius ? 0 : 1;
+}
+
+template<typename T>
+static bool boundingbox_obb_holds(const obb<T>& bb, const std::vector<vec3<T>>& points)
+{
+    // orthonormal axes
+    for(std::uint8_t i = 0; i < 3; i++)
+    {
+	if(std::abs(dot(bb.slabs[i].normal, bb.slabs[i].normal) - 1) > 1e-4 || std::abs(dot(bb.slabs[i].normal, bb.slabs[(i + 1) % 3].normal)) > 1e-4)
+	    return false;
+    }
+    for(const vec3<T>& p : points)
+    {
+	if(!bb.contain(p, (T)1e-3))
+	    return false;
+    }
+    return true;
+}
+
+static int boundingbox_obb_test(const std::size_t count)
+{
+    // uniform in a rotated 40 x 10 x 4 box
+    const mat3<float> r = rotateAxisQuat(vec3f(1, 2, 3), 37.0f).to_mat3();
+    const vec3f c(10, -20, 5);
+    std::vector<vec3f> box(count);
+    std::vector<vec3<double>> boxd(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const float u = (float)(rand() % 2001 - 1000) / 1000.0f, v = (float)(rand() % 2001 - 1000) / 1000.0f, w = (float)(rand() % 2001 - 1000) / 1000.0f;
+	box[i] = c + r[0] * (u * 20) + r[1] * (v * 5) + r[2] * (w * 2);
+	boxd[i] = vec3<double>(box[i].x, box[i].y, box[i].z);
+    }
+    for(std::uint8_t f = 0; f < 2; f++)
+    {
+	for(std::uint8_t p = 0; p < 2; p++)
+	{
+	    const obb<float> bb = genOrientedBB(box.data(), count, (obb_fit)f, p != 0);
+	    if(!boundingbox_obb_holds(bb, box) || bb.volume() > 40 * 10 * 4 * 1.01f)
+		return 1;
+	    const obb<double> bbd = genOrientedBB(boxd.data(), count, (obb_fit)f, p != 0);
+	    if(!boundingbox_obb_holds(bbd, boxd) || std::abs(bbd.volume() - bb.volume()) > bb.volume() * 1e-3)
+		return 1;
+	}
+    }
+
+    // a cube's corners and a dense line along its diagonal: pca takes the diagonal, dito finds the cube
+    std::vector<vec3f> cube;
+    for(std::uint8_t i = 0; i < 8; i++)
+	cube.push_back(vec3f(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f));
+    for(std::size_t i = 0; i < 1000; i++)
+    {
+	const float t = (float)i / 500 - 1;
+	cube.push_back(vec3f(t, t, t));
+    }
+    const obb<float> pca = genOrientedBB(cube.data(), cube.size(), obb_fit_pca);
+    const obb<float> dito = genOrientedBB(cube.data(), cube.size(), obb_fit_dito);
+    if(!boundingbox_obb_holds(pca, cube) || !boundingbox_obb_holds(dito, cube) || dito.volume() > 8 * 1.01f || pca.volume() < 8 * 1.2f)
+	return 1;
+
+    // one point
+    const obb<float> point = genOrientedBB(&c, 1, obb_fit_dito);
+    if(point.volume() != 0 || !point.contain(c, 1e-5f))
+	return 1;
+
+    // batches, the same boxes as one by one, an empty object in the middle
+    const std::size_t offsets[] = {0, 100, 100, 1337, count / 2, count};
+    const std::size_t objects = sizeof(offsets) / sizeof(offsets[0]) - 1;
+    for(std::uint8_t p = 0; p < 2; p++)
+    {
+	std::vector<obb<float>> out(objects);
+	genOrientedBBs(box.data(), offsets, objects, out.data(), obb_fit_dito, p != 0);
+	for(std::size_t i = 0; i < objects; i++)
+	{
+	    const std::size_t n = offsets[i + 1] - offsets[i];
+	    const obb<float> ref = n == 0 ? obb<float>() : genOrientedBB(box.data() + offsets[i], n, obb_fit_dito);
+	    for(std::uint8_t k = 0; k < 3; k++)
+	    {
+		if(out[i].slabs[k].points[0].x != ref.slabs[k].points[0].x || out[i].slabs[k].points[1].z != ref.slabs[k].points[1].z)
+		    return 1;
+	    }
+	}
+	if(out[1].volume() != 0)
+	    return 1;
+    }
+    return 0;
+}
+
+int boundingbox_test(const std::size_t count = 20000)
+{
+    std::vector<aabb<float>> boxes(count);
+    std::vector<spherebb<float>> spheres(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	boxes[i] = boundingbox_random_box();
+	spheres[i] = spherebb<float>(vec3f((float)(rand() % 200 - 100), (float)(rand() % 200 - 100), (float)(rand() % 200 - 100)), (float)(rand() % 30));
+    }
+    // a box inside the next one
+    boxes[1] = aabb<float>(boxes[0].diagonal[0] - vec3f(2, 2, 2), boxes[0].diagonal[1] + vec3f(2, 2, 2));
+    std::swap(boxes[0], boxes[1]);
+
+    if(boundingbox_compact_test(boxes, spheres) != 0 || boundingbox_q8_test(boxes) != 0
+       || boundingbox_api_test() != 0 || boundingbox_points_test(count * 10 + 7) != 0
+       || boundingbox_sphere_test(count * 10 + 7) != 0 || boundingbox_obb_test(count * 10 + 7) != 0)
+	return 1;
+    return boundingbox_octree_test();
+}
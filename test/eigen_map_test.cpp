@@ -0,0 +1,77 @@
+#include "../src/eigen_map.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+int eigen_map_test(const std::size_t count = 1001)
+{
+    std::vector<vec3f> points(count);
+    for(std::size_t i = 0; i < count; i++)
+	points[i] = vec3f(rand() % 200 - 100, (rand() % 200 - 100) * 0.5f, (rand() % 200 - 100) * 0.1f);
+
+    // same storage, point i is column i
+    const auto p = eigenMap((const vec3f*)points.data(), count);
+    if(p.rows() != 3 || p.cols() != (Eigen::Index)count || p.data() != points[0].data() || p(1, 7) != points[7].y)
+	return 1;
+
+    // covariance through Eigen against ours
+    const Eigen::Vector3f mean = p.rowwise().mean();
+    const Eigen::Matrix3f c = (p.colwise() - mean) * (p.colwise() - mean).transpose() / (float)count;
+    const mat3<float> ref = covarianceMat3(points.data(), count);
+    for(std::uint8_t col = 0; col < 3; col++)
+    {
+	for(std::uint8_t row = 0; row < 3; row++)
+	{
+	    if(std::abs(c(row, col) - ref[col][row]) > 1e-3f * (1.0f + std::abs(ref[col][row])))
+		return 1;
+	}
+    }
+
+    // writes land in the array
+    auto w = eigenMap(points.data(), count);
+    w.row(2).setZero();
+    w.col(3) = Eigen::Vector3f(1, 2, 3);
+    if(points[5].z != 0 || points[3].x != 1 || points[3].y != 2 || points[3].z != 3)
+	return 1;
+
+    // vec4, aligned map
+#if defined(GB_PHYSICS_SSE)
+    static_assert(eigen_map_options<vec4f>::value == Eigen::Aligned16, "vec4f maps must be aligned");
+#endif
+    std::vector<vec4f> v4(count, vec4f(1, 2, 3, 4));
+    auto m4 = eigenMap(v4.data(), count);
+    m4.row(3) *= 0.5f;
+    if(v4[count - 1].w != 2 || v4[0].x != 1)
+	return 1;
+
+    // matrices, mat4 i is middleCols<4>(4 * i)
+    std::vector<mat4f> mats(3, mat4f::make_identity());
+    mats[1] = translateMat(vec3f(1, 2, 3));
+    const auto ms = eigenMap((const mat4f*)mats.data(), mats.size());
+    if(ms.cols() != 12 || ms(2, 7) != 3 || ms.middleCols<4>(4).col(3) != Eigen::Vector4f(1, 2, 3, 1))
+	return 1;
+
+    mat4f m = translateMat(vec3f(4, 5, 6));
+    const Eigen::Vector4f tp = eigenMap(m) * Eigen::Vector4f(1, 1, 1, 1);
+    if(tp != Eigen::Vector4f(5, 6, 7, 1))
+	return 1;
+    eigenMap(m).transposeInPlace();
+    if(m[0][3] != 4 || m[3][0] != 0)
+	return 1;
+
+    // mat3 round trip through an Eigen solve, no copies
+    mat3<double> a{{{4, 1, 0}, {1, 3, 1}, {0, 1, 2}}};
+    mat3<double> inv;
+    eigenMap(inv) = eigenMap(a).inverse();
+    const Eigen::Matrix3d id = eigenMap(a) * eigenMap(inv);
+    if(!id.isIdentity(1e-12))
+	return 1;
+
+    // affine3, 3x4
+    affine3f af = affine3f::make_identity();
+    af.value[3] = vec3f(7, 8, 9);
+    if(eigenMap(af)(1, 3) != 8 || eigenMap(&af, 1).cols() != 4)
+	return 1;
+
+    return 0;
+}
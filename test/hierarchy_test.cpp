@@ -0,0 +1,82 @@
+#include "../src/hierarchy.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+// world by walking up the parents
+static mat4f hierarchy_world(const transform_hierarchyf& h, const std::uint32_t node)
+{
+    const std::uint32_t p = h.parent(node);
+    return p == transform_hierarchyf::npos ? h.local(node) : hierarchy_world(h, p) * h.local(node);
+}
+
+static bool hierarchy_check(const transform_hierarchyf& h)
+{
+    for(std::uint32_t i = 0; i < h.size(); i++)
+    {
+	const mat4f ref = hierarchy_world(h, i);
+	const mat4f& w = h.world(i);
+	for(std::uint8_t c = 0; c < 4; c++)
+	    for(std::uint8_t r = 0; r < 4; r++)
+		if(std::abs(w[c][r] - ref[c][r]) > 1e-3f * (1.0f + std::abs(ref[c][r])))
+		    return false;
+    }
+    return true;
+}
+
+int hierarchy_test(const std::uint32_t count = 20000)
+{
+    transform_hierarchyf h;
+    h.reserve(count);
+    // a few roots, each node hangs off an earlier one
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+	const std::uint32_t parent = i < 4 ? transform_hierarchyf::npos : (std::uint32_t)(rand() % i);
+	h.add(parent, vec3f((float)(i % 5), 1.0f, -(float)(i % 3)),
+	      rotateAxisQuat(vec3f(0, 1, (float)(i % 2)), (float)(i % 90)),
+	      vec3f(1.0f, 1.0f + (float)(i % 2) * 0.01f, 1.0f));
+    }
+    if(h.update() != count || !hierarchy_check(h) || h.update() != 0)
+	return 1;
+
+    // a leaf costs one matrix
+    std::uint32_t leaf = count - 1;
+    h.set_translation(leaf, vec3f(3, 2, 1));
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+	if(h.parent(i) == leaf)
+	    return 1;
+    }
+    if(h.update() != 1 || !hierarchy_check(h))
+	return 1;
+
+    // a node and one of its descendants edited together cost its subtree once
+    std::uint32_t node = count / 2;
+    while(h.parent(node) == transform_hierarchyf::npos)
+	node++;
+    std::size_t subtree = 0;
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+	for(std::uint32_t p = i; p != transform_hierarchyf::npos; p = h.parent(p))
+	{
+	    if(p == node)
+	    {
+		subtree++;
+		break;
+	    }
+	}
+    }
+    h.set_rotation(node, rotateAxisQuat(vec3f(1, 0, 0), 33.0f));
+    h.set_scale(h.parent(node), vec3f(2, 2, 2));
+    h.set_scale(node, vec3f(1, 0.5f, 1));
+    if(h.update(true) < subtree || !hierarchy_check(h))
+	return 1;
+
+    // roots moving every frame, in parallel
+    for(std::uint32_t r = 0; r < 4; r++)
+	h.set_translation(r, vec3f((float)r, 0, 0));
+    if(h.update(true) != count || !hierarchy_check(h))
+	return 1;
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "../src/matrix_stream.h"
+#include "../src/cpu.h"
+#include <iostream>
+#include <cstring>
+
+using namespace gb::physics;
+
+static bool matrix_stream_near(const float a, const double b, const double scale)
+{
+    return std::abs(a - b) <= 1e-3 * (scale + std::abs(b));
+}
+
+static int matrix_stream_level_test(const std::vector<mat4f>& in, const std::vector<mat4<double>>& ind)
+{
+    const std::size_t count = in.size();
+    std::vector<mat4<double>> ref(count);
+    std::vector<double> refDet(count);
+    std::vector<std::uint8_t> refSingular(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	refSingular[i] = ind[i].inverse(ref[i]) ? 0 : 1;
+	refDet[i] = ind[i].determinant();
+    }
+
+    const mat4f_stream sin(in);
+    for(std::uint8_t p = 0; p < 2; p++)
+    {
+	const bool bParallel = p != 0;
+	mat4f_stream sout;
+	bit_vector singular, aosSingular;
+	std::vector<mat4f> aos(count);
+	std::vector<float> det(count), aosDet(count);
+	const std::size_t singularCount = inverse(sin, sout, singular, bParallel);
+	const std::size_t aosSingularCount = inverse(in.data(), count, aos.data(), aosSingular, bParallel);
+	determinant(sin, det.data(), bParallel);
+	determinant(in.data(), count, aosDet.data(), bParallel);
+	if(sout.size() != count || singular.size() != count || aosSingular.size() != count)
+	    return 1;
+
+	std::size_t expected = 0;
+	for(std::size_t i = 0; i < count; i++)
+	{
+	    expected += refSingular[i];
+	    if(singular[i] != refSingular[i] || aosSingular[i] != refSingular[i])
+		return 1;
+	    if(!matrix_stream_near(det[i], refDet[i], 1.0) || det[i] != aosDet[i])
+		return 1;
+	    if(refSingular[i] != 0)
+		continue;
+	    const mat4f r = sout[i];
+	    for(std::uint8_t c = 0; c < 4; c++)
+	    {
+		for(std::uint8_t row = 0; row < 4; row++)
+		{
+		    if(!matrix_stream_near(r[c][row], ref[i][c][row], 1.0) || r[c][row] != aos[i][c][row])
+			return 1;
+		}
+	    }
+	}
+	if(singularCount != expected || aosSingularCount != expected)
+	    return 1;
+    }
+
+    // in place, the same bits as out of place
+    mat4f_stream s(in), out;
+    bit_vector singular, outSingular;
+    inverse(s, out, outSingular);
+    inverse(s, s, singular);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	if(singular[i] != outSingular[i])
+	    return 1;
+	if(singular[i] != 0)
+	    continue;
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    for(std::uint8_t row = 0; row < 4; row++)
+	    {
+		if(s[i][c][row] != out[i][c][row])
+		    return 1;
+	    }
+	}
+    }
+    return 0;
+}
+
+int matrix_stream_test(const std::size_t count = 2003)
+{
+    // affine matrices first(one general matrix in their lane groups), general ones after,
+    // a zero column every 131 matrices
+    std::vector<mat4f> in(count);
+    std::vector<mat4<double>> ind(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	mat4f& m = in[i];
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    for(std::uint8_t r = 0; r < 4; r++)
+		m[c][r] = (float)(rand() % 200 - 100) / 50.0f + (c == r ? 4.0f : 0.0f);
+	}
+	if(i < 512 && i != 20)
+	{
+	    m[0][3] = m[1][3] = m[2][3] = 0;
+	    m[3][3] = 1;
+	}
+	if(i % 131 == 7)
+	    m[i % 3][0] = m[i % 3][1] = m[i % 3][2] = m[i % 3][3] = 0;
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    for(std::uint8_t r = 0; r < 4; r++)
+		ind[i][c][r] = m[c][r];
+	}
+    }
+
+    // layout round trip, the tail of a shrunk block is back to identities
+    mat4f_stream s(in);
+    if(s.size() != count || s.blocks() != (count + 15) / 16 || s.to_vector()[count - 1][2][1] != in[count - 1][2][1])
+	return 1;
+    s.resize(count - 3);
+    s.resize(count);
+    if(s[count - 1][0][0] != 1 || s[count - 1][0][1] != 0)
+	return 1;
+
+    // generic version
+    const mat4_stream<double> sd(ind);
+    mat4_stream<double> sdOut;
+    bit_vector singular;
+    const std::size_t singularCount = inverse(sd, sdOut, singular);
+    if(singularCount != (count + 123) / 131 || singular[7] != 1 || singular[8] != 0)
+	return 1;
+    // threads split whole blocks, same bits as the plain loop
+    std::vector<mat4<double>> bigd;
+    for(std::uint8_t r = 0; r < 5; r++)
+	bigd.insert(bigd.end(), ind.begin(), ind.end());
+    const mat4_stream<double> sBig(bigd);
+    mat4_stream<double> serialOut, parallelOut;
+    bit_vector serialSingular, parallelSingular;
+    if(inverse(sBig, serialOut, serialSingular) != inverse(sBig, parallelOut, parallelSingular, true)
+       || serialSingular.count() != 5 * singularCount)
+	return 1;
+    std::vector<double> serialDet(bigd.size()), parallelDet(bigd.size());
+    determinant(sBig, serialDet.data());
+    determinant(sBig, parallelDet.data(), true);
+    for(std::size_t i = 0; i < bigd.size(); i++)
+    {
+	const mat4<double> a = serialOut[i], b = parallelOut[i];
+	if(serialSingular[i] != parallelSingular[i] || serialDet[i] != parallelDet[i]
+	   || (!serialSingular.test(i) && std::memcmp(&a, &b, sizeof(a)) != 0))
+	    return 1;
+    }
+
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	if(matrix_stream_level_test(in, ind) != 0)
+	{
+	    std::cout << "matrix_stream_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
@@ -10,5 +10,185 @@ int matrix_test()
 	mat3<Float> a{ { { 3, 2, 4 },{ 2, 0, 2 },{ 4, 2, 3 } } };
      mat3<Float> ev = a.eigenvectors();
 
+    // symmetric eigen decomposition, A * v = lambda * v, sorted, orthonormal
+    {
+	std::vector<mat3<double>> ms;
+	ms.push_back(mat3<double>{{{3, 2, 4}, {2, 0, 2}, {4, 2, 3}}});// 8, -1, -1
+	ms.push_back(mat3<double>{{{2, 0, 0}, {0, 5, 0}, {0, 0, 1}}});
+	ms.push_back(mat3<double>{{{1, 1e-9, 0}, {1e-9, 1, 0}, {0, 0, 1}}});
+	ms.push_back(mat3<double>{{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}});
+	for(std::uint32_t n = 0; n < 1000; n++)
+	{
+	    mat3<double> m;
+	    for(std::uint8_t c = 0; c < 3; c++)
+		for(std::uint8_t r = 0; r <= c; r++)
+		    m[c][r] = m[r][c] = (double)(rand() % 2000) / 100.0 - 10.0;
+	    if(n % 3 == 0)
+		m[1][1] = m[0][0];
+	    ms.push_back(m);
+	}
+
+	std::vector<vec3<double>> values(ms.size());
+	std::vector<mat3<double>> vectors(ms.size());
+	if(!eigenSym3(ms.data(), ms.size(), values.data(), vectors.data(), true))
+	    return 1;
+	if(std::abs(values[0][0] - 8) > 1e-12 || std::abs(values[0][1] + 1) > 1e-12 || std::abs(values[0][2] + 1) > 1e-12)
+	    return 1;
+	for(std::size_t i = 0; i < ms.size(); i++)
+	{
+	    const mat3<double>& m = ms[i];
+	    const mat3<double>& v = vectors[i];
+	    double scale = 1;
+	    for(std::uint8_t c = 0; c < 3; c++)
+		scale = std::max(scale, std::abs(values[i][c]));
+	    if(values[i][0] < values[i][1] || values[i][1] < values[i][2])
+		return 1;
+	    if(dot(cross(v[0], v[1]), v[2]) < 1 - 1e-9)
+		return 1;
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		const vec3<double> residual = m * v[c] - v[c] * values[i][c];
+		if(residual.magnitude() > 1e-9 * scale || std::abs(v[c].magnitude() - 1) > 1e-9)
+		    return 1;
+	    }
+	}
+
+	// float closed form against the double solver
+	for(std::size_t i = 4; i < 104; i++)
+	{
+	    mat3<float> mf;
+	    for(std::uint8_t c = 0; c < 3; c++)
+		for(std::uint8_t r = 0; r < 3; r++)
+		    mf[c][r] = (float)ms[i][c][r];
+	    vec3f vf;
+	    mat3<float> ef;
+	    eigenSym3(mf, vf, ef);
+	    for(std::uint8_t c = 0; c < 3; c++)
+	    {
+		if(std::abs(vf[c] - values[i][c]) > 1e-4 * (1 + std::abs(values[i][c])))
+		    return 1;
+	    }
+	}
+    }
+
+    // one pass covariance against the two pass definition
+    std::vector<vec3f> points;
+    for(std::uint32_t i = 0; i < 300000; i++)
+	points.push_back(vec3f(1000.0f + (float)(i % 97), 2.0f * (float)(i % 89) - 50.0f, (float)(i % 13) * 0.5f + (float)(i % 97)));
+    const mat3<float> cov = covarianceMat3(points.data(), points.size());
+    double mean[3] = {0, 0, 0};
+    for(const vec3f& p : points)
+	for(std::uint8_t c = 0; c < 3; c++)
+	    mean[c] += p[c];
+    for(std::uint8_t c = 0; c < 3; c++)
+	mean[c] /= points.size();
+    for(std::uint8_t r = 0; r < 3; r++)
+    {
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    double ref = 0;
+	    for(const vec3f& p : points)
+		ref += (p[r] - mean[r]) * (p[c] - mean[c]);
+	    ref /= points.size();
+	    if(std::abs(cov[c][r] - ref) > 1e-4 * (1.0 + std::abs(ref)))
+		return 1;
+	}
+    }
+
+    // float mat4 kernels against the generic double path
+    for(std::uint32_t n = 0; n < 100; n++)
+    {
+	mat4<float> m;
+	mat4<double> md;
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    for(std::uint8_t r = 0; r < 4; r++)
+	    {
+		const float v = (float)(rand() % 2000) / 100.0f - 10.0f + (c == r ? 25.0f : 0.0f);
+		m[c][r] = v;
+		md[c][r] = v;
+	    }
+	}
+	const mat4<float> t = m.transpose();
+	const mat4<float> mm = m * t;
+	const mat4<double> mmd = md * md.transpose();
+	mat4<float> inv;
+	mat4<double> invd;
+	if(!m.inverse(inv) || !md.inverse(invd))
+	    return 1;
+	const double det = md.determinant();
+	if(std::abs(m.determinant() - det) > 1e-4 * std::abs(det))
+	    return 1;
+	for(std::uint8_t c = 0; c < 4; c++)
+	{
+	    for(std::uint8_t r = 0; r < 4; r++)
+	    {
+		if(t[c][r] != m[r][c]
+		   || std::abs(mm[c][r] - mmd[c][r]) > 1e-4 * (1.0 + std::abs(mmd[c][r]))
+		   || std::abs(inv[c][r] - invd[c][r]) > 1e-5)
+		    return 1;
+	    }
+	}
+    }
+    mat4<float> singular = mat4<float>::make_identity();
+    singular[2] = singular[1];
+    mat4<float> dummy;
+    if(singular.inverse(dummy) || singular.determinant() != 0)
+	return 1;
+
+    // constant builders fold at compile time and match the std::sin/cos matrices
+    {
+	constexpr mat4<float> t = translateMat(vec3f(1, 2, 3));
+	static_assert(t.value[3].y == 2, "constexpr translateMat");
+	constexpr mat4<double> rx = rotateXAxisMat<double>(30.0f);
+	static_assert(rx.value[1].y > 0.866 && rx.value[1].y < 0.867 && rx.value[2].y < -0.499 && rx.value[2].y > -0.501, "constexpr rotateXAxisMat");
+	constexpr mat4<double> s = scaleMat(vec3<double>(2, 3, 4));
+	static_assert(s.value[1].y == 3 && s.value[3].w == 1, "constexpr scaleMat");
+	for(std::int32_t degree = -720; degree <= 720; degree += 15)
+	{
+	    const double radian = gb::math::degree2radian((float)degree);
+	    if(std::abs(gb::math::constSin(radian) - std::sin(radian)) > 1e-14
+	       || std::abs(gb::math::constCos(radian) - std::cos(radian)) > 1e-14)
+		return 1;
+	    // run time builders stay on std::sin/std::cos(float)
+	    const float fRadian = gb::math::degree2radian((float)degree);
+	    const mat4<float> rz = rotateZAxisMat<float>((float)degree);
+	    if(rz.value[0].y != std::sin(fRadian) || rz.value[0].x != std::cos(fRadian))
+		return 1;
+	}
+    }
+
+    // affine3 against the mat4 it stands for
+    for(std::uint32_t n = 0; n < 100; n++)
+    {
+	const affine3<double> a = affine3<double>::from_mat4(translateMat(vec3<double>(n, -2.0 * n, 3))
+							     * rotateXAxisMat<double>(n * 7.0f)
+							     * scaleMat(vec3<double>(1 + n % 3, 2, 0.5)));
+	const affine3<double> b = affine3<double>::from_mat4(rotateZAxisMat<double>(n * 3.0f) * translateMat(vec3<double>(1, n, 0)));
+	const mat4<double> ab = a.to_mat4() * b.to_mat4();
+	const affine3<double> c = a * b;
+	affine3<double> inv;
+	mat4<double> invd;
+	if(!c.inverse(inv) || !ab.inverse(invd))
+	    return 1;
+	const mat4<double> cm = c.to_mat4();
+	const mat4<double> invm = inv.to_mat4();
+	for(std::uint8_t col = 0; col < 4; col++)
+	{
+	    for(std::uint8_t r = 0; r < 4; r++)
+	    {
+		if(std::abs(cm[col][r] - ab[col][r]) > 1e-9 * (1.0 + std::abs(ab[col][r]))
+		   || std::abs(invm[col][r] - invd[col][r]) > 1e-9 * (1.0 + std::abs(invd[col][r])))
+		    return 1;
+	    }
+	}
+	if(std::abs(c.determinant() - ab.determinant()) > 1e-9 * (1.0 + std::abs(ab.determinant())))
+	    return 1;
+    }
+    affine3<float> flat = affine3<float>::make_identity();
+    flat[1] = vec3f(0);
+    if(flat.inverse(flat) || flat.determinant() != 0)
+	return 1;
+
     return 0;
 }
@@ -0,0 +1,66 @@
+#include "../src/quantize.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+int quantize_test(const unsigned int count = 1003)
+{
+    std::vector<vec3f> a(count);
+    for(unsigned int i = 0; i < count; i++)
+	a[i] = vec3f((rand() % 20000) * 0.01f - 100.0f, (rand() % 1000) * 0.5f, -(float)(rand() % 300));
+
+    // half, the batch path must match the scalar one bit for bit
+    std::vector<vec3h> h(count);
+    std::vector<vec3f> back(count);
+    encodeHalf(a.data(), count, h.data());
+    decodeHalf(h.data(), count, back.data());
+    for(unsigned int i = 0; i < count; i++)
+    {
+	const vec3h ref(a[i]);
+	if(h[i].x.bits != ref.x.bits || h[i].y.bits != ref.y.bits || h[i].z.bits != ref.z.bits)
+	    return 1;
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    // 11 significant bits
+	    if(std::abs(back[i][c] - a[i][c]) > std::abs(a[i][c]) / 2048.0f)
+		return 1;
+	}
+    }
+    if(half::to_float(half::from_float(65520.0f)) != std::numeric_limits<float>::infinity()
+       || half::from_float(-0.0f) != 0x8000 || half::to_float(0x0001) != std::ldexp(1.0f, -24))
+	return 1;
+
+    // fixed point, error within half a step
+    const vec3_quantizer q(aabb<float>(vec3f(-100, 0, -300), vec3f(100, 500, 0)));
+    std::vector<vec3q16> q16(count);
+    quantize(q, a.data(), count, q16.data());
+    dequantize(q, q16.data(), count, back.data());
+    const vec3f step16 = q.step(65535.0f);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(q16[i].x != q.encode16(a[i]).x || q16[i].z != q.encode16(a[i]).z)
+	    return 1;
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    if(std::abs(back[i][c] - a[i][c]) > step16[c] * 0.5f + 1e-4f)
+		return 1;
+	}
+    }
+
+    std::vector<vec3q10> q10(count);
+    quantize(q, a.data(), count, q10.data());
+    dequantize(q, q10.data(), count, back.data());
+    const vec3f step10 = q.step(1023.0f);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(q10[i].bits != q.encode10(a[i]).bits)
+	    return 1;
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    if(std::abs(back[i][c] - a[i][c]) > step10[c] * 0.5f + 1e-4f)
+		return 1;
+	}
+    }
+
+    return 0;
+}
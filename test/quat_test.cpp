@@ -0,0 +1,128 @@
+#include "../src/quat.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+static bool quat_near(const vec3f& a, const vec3f& b, const float tolerance)
+{
+    return (a - b).magnitude() <= tolerance * (1.0f + b.magnitude());
+}
+
+int quat_test()
+{
+    // matrix round trips, the Shepperd branches are picked by the rotation angle
+    for(std::uint32_t n = 0; n < 360; n++)
+    {
+	const vec3f axis((float)(n % 7) - 3.0f, (float)(n % 5) - 1.5f, (float)(n % 3) + 0.5f);
+	const quatf q = rotateAxisQuat(axis, (float)n);
+	const mat3<float> m = q.to_mat3();
+	const quatf back = quatf::from_mat3(m);
+	if(std::abs(std::abs(back.dot(q)) - 1.0f) > 1e-5f)
+	    return 1;
+
+	const vec3f v((float)n, 1.0f, -2.0f);
+	if(!quat_near(q.rotate(v), m * v, 1e-5f))
+	    return 1;
+    }
+
+    // composition matches the matrices
+    const quatf qx = rotateAxisQuat(vec3f(1, 0, 0), 30.0f);
+    const quatf qz = rotateAxisQuat(vec3f(0, 0, 1), 75.0f);
+    const mat4f mxz = rotateXAxisMat<float>(30.0f) * rotateZAxisMat<float>(75.0f);
+    const mat4f qm = (qx * qz).to_mat4();
+    for(std::uint8_t c = 0; c < 4; c++)
+	for(std::uint8_t r = 0; r < 4; r++)
+	    if(std::abs(qm[c][r] - mxz[c][r]) > 1e-5f)
+		return 1;
+
+    // fused TRS against the product
+    const mat4f trs = makeTRS(vec3f(1, 2, 3), qz * qx, vec3f(2, 0.5f, -1));
+    constexpr mat4<double> trsConst = makeTRS(vec3<double>(1, 2, 3), quat<double>::make_identity(), vec3<double>(2, 2, 2));
+    static_assert(trsConst.value[0].x == 2 && trsConst.value[3].z == 3, "constexpr makeTRS");
+    const mat4f trsRef = translateMat(vec3f(1, 2, 3)) * (qz * qx).to_mat4() * scaleMat(vec3f(2, 0.5f, -1));
+    for(std::uint8_t c = 0; c < 4; c++)
+	for(std::uint8_t r = 0; r < 4; r++)
+	    if(std::abs(trs[c][r] - trsRef[c][r]) > 1e-5f)
+		return 1;
+
+    // slerp runs at constant speed, nlerp ends at the same rotations
+    const quatf a = quatf::make_identity();
+    const quatf b = rotateAxisQuat(vec3f(0, 1, 0), 120.0f);
+    const quatf half = slerp(a, b, 0.5f);
+    if(std::abs(half.dot(rotateAxisQuat(vec3f(0, 1, 0), 60.0f)) - 1.0f) > 1e-5f
+       || std::abs(nlerp(a, b, 1.0f).dot(b) - 1.0f) > 1e-5f
+       || std::abs(std::abs(slerp(a, -b, 1.0f).dot(b)) - 1.0f) > 1e-5f)
+	return 1;
+
+    // dual quaternion against the rigid mat4
+    const mat4f rigid = translateMat(vec3f(1, -2, 3)) * rotateYAxisMat<float>(40.0f) * rotateXAxisMat<float>(-15.0f);
+    const dualquatf dq = dualquatf::from_mat4(rigid);
+    const mat4f dm = dq.to_mat4();
+    for(std::uint8_t c = 0; c < 4; c++)
+	for(std::uint8_t r = 0; r < 4; r++)
+	    if(std::abs(dm[c][r] - rigid[c][r]) > 1e-5f)
+		return 1;
+    const dualquatf dq2 = dualquatf::from_rotation_translation(qz, vec3f(0, 5, 0));
+    const vec3f p(3, 4, 5);
+    const vec4<float> ref = rigid * (dq2.to_mat4() * vec4<float>(p.x, p.y, p.z, 1.0f));
+    if(!quat_near((dq * dq2).transform_point(p), vec3f(ref.x, ref.y, ref.z), 1e-5f)
+       || !quat_near(dq.inverse().transform_point(dq.transform_point(p)), p, 1e-5f))
+	return 1;
+
+    // batch nlerp against the scalar one
+    const std::size_t count = 1003;
+    std::vector<quatf> qa(count), qb(count), qo(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	qa[i] = rotateAxisQuat(vec3f((float)(i % 3), 1.0f, (float)(i % 5)), (float)(i % 360));
+	qb[i] = rotateAxisQuat(vec3f(1.0f, (float)(i % 7), 2.0f), (float)(i % 270));
+	if(i % 2 == 0)
+	    qb[i] = -qb[i];
+    }
+    nlerp(qa.data(), qb.data(), 0.3f, count, qo.data());
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const quatf r = nlerp(qa[i], qb[i], 0.3f);
+	if(std::abs(r.dot(qo[i]) - 1.0f) > 1e-5f)
+	    return 1;
+    }
+
+    // batch skinning against blended scalar dual quaternions
+    std::vector<dualquatf> joints;
+    for(std::uint32_t j = 0; j < 8; j++)
+	joints.push_back(dualquatf::from_rotation_translation(j % 2 == 0 ? qa[j] : -qa[j], vec3f((float)j, 1.0f, -(float)j)));
+    std::vector<skin_influence> influences(count);
+    std::vector<vec3f> in(count), outP(count), outD(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	skin_influence& inf = influences[i];
+	const std::uint32_t used = i % 4 + 1;
+	for(std::uint8_t k = 0; k < 4; k++)
+	{
+	    inf.joint[k] = (std::uint16_t)((i + k * 3) % joints.size());
+	    inf.weight[k] = k < used ? 1.0f / used : 0.0f;
+	}
+	in[i] = vec3f((float)(i % 11), (float)(i % 13) - 6.0f, 2.0f);
+    }
+    skinPoints(joints.data(), influences.data(), in.data(), count, outP.data(), true);
+    skinDirections(joints.data(), influences.data(), in.data(), count, outD.data());
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const skin_influence& inf = influences[i];
+	const quatf pivot = joints[inf.joint[0]].real;
+	dualquatf blend{quatf{0, 0, 0, 0}, quatf{0, 0, 0, 0}};
+	for(std::uint8_t k = 0; k < 4; k++)
+	{
+	    const dualquatf& j = joints[inf.joint[k]];
+	    const float w = pivot.dot(j.real) < 0 ? -inf.weight[k] : inf.weight[k];
+	    blend.real = blend.real + j.real * w;
+	    blend.dual = blend.dual + j.dual * w;
+	}
+	blend = blend.normalize();
+	if(!quat_near(outP[i], blend.transform_point(in[i]), 1e-5f)
+	   || !quat_near(outD[i], blend.transform_direction(in[i]), 1e-5f))
+	    return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "../src/rotation.h"
+#include "../src/quat.h"
+#include "../src/cpu.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+static int rotation_sincos_test(const std::vector<float>& radians, const std::vector<float>& degrees)
+{
+    const std::size_t count = radians.size();
+    std::vector<float> s(count), c(count);
+    const double tolerance[2] = {3e-7, 5e-5};
+    for(std::uint8_t a = 0; a < 2; a++)
+    {
+	const sincos_accuracy accuracy = (sincos_accuracy)a;
+	for(std::uint8_t p = 0; p < 2; p++)
+	{
+	    sinCos(radians.data(), count, s.data(), c.data(), accuracy, p != 0);
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		if(std::abs(s[i] - std::sin((double)radians[i])) > tolerance[a] || std::abs(c[i] - std::cos((double)radians[i])) > tolerance[a])
+		    return 1;
+	    }
+	    sinCosDegree(degrees.data(), count, s.data(), c.data(), accuracy, p != 0);
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		const double radian = degrees[i] * 3.14159265358979323846 / 180;
+		if(std::abs(s[i] - std::sin(radian)) > tolerance[a] || std::abs(c[i] - std::cos(radian)) > tolerance[a])
+		    return 1;
+	    }
+	}
+    }
+
+    // quarter turns are exact in degrees, in place
+    std::vector<float> quarters{0, 90, 180, 270, -90, -180, 3600, 450};
+    std::vector<float> qc(quarters.size());
+    sinCosDegree(quarters.data(), quarters.size(), quarters.data(), qc.data());
+    const float qs[] = {0, 1, 0, -1, -1, 0, 0, 1};
+    const float qcos[] = {1, 0, -1, 0, 0, -1, 1, 0};
+    for(std::size_t i = 0; i < quarters.size(); i++)
+    {
+	if(quarters[i] != qs[i] || qc[i] != qcos[i])
+	    return 1;
+    }
+    return 0;
+}
+
+static bool rotation_near(const mat3<float>& a, const mat3<float>& b, const float tolerance = 1e-5f)
+{
+    for(std::uint8_t col = 0; col < 3; col++)
+    {
+	for(std::uint8_t row = 0; row < 3; row++)
+	{
+	    if(std::abs(a[col][row] - b[col][row]) > tolerance)
+		return false;
+	}
+    }
+    return true;
+}
+
+static mat3<float> rotation_upper(const mat4f& m)
+{
+    return mat3<float>{{{m[0][0], m[0][1], m[0][2]}, {m[1][0], m[1][1], m[1][2]}, {m[2][0], m[2][1], m[2][2]}}};
+}
+
+static int rotation_builders_test(const std::vector<float>& degrees)
+{
+    const std::size_t count = degrees.size();
+    std::vector<mat3<float>> m3(count);
+    std::vector<mat4f> m4(count);
+    std::vector<affine3f> af(count);
+    std::vector<vec3f> axes(count);
+    for(std::size_t i = 0; i < count; i++)
+	axes[i] = vec3f(rand() % 200 - 100 + 0.5f, rand() % 200 - 100, rand() % 200 - 100);
+
+    // single axis, against the scalar builders
+    for(std::uint8_t axis = 0; axis < 3; axis++)
+    {
+	rotateAxisMats((rotation_axis)axis, degrees.data(), count, m3.data());
+	rotateAxisMats((rotation_axis)axis, degrees.data(), count, m4.data(), sincos_precise, true);
+	rotateAxisMats((rotation_axis)axis, degrees.data(), count, af.data());
+	for(std::size_t i = 0; i < count; i++)
+	{
+	    // degree2radian's pi has 7 digits
+	    const float tolerance = 1e-5f + std::abs(degrees[i]) * 4e-9f;
+	    const mat4f ref = axis == rotation_x ? rotateXAxisMat<float>(degrees[i])
+		: (axis == rotation_y ? rotateYAxisMat<float>(degrees[i]) : rotateZAxisMat<float>(degrees[i]));
+	    if(!rotation_near(m3[i], rotation_upper(ref), tolerance) || !rotation_near(rotation_upper(m4[i]), m3[i]) || m4[i][3][3] != 1 || m4[i][0][3] != 0)
+		return 1;
+	    if(!rotation_near(rotation_upper(af[i].to_mat4()), m3[i]) || af[i].value[3].x != 0)
+		return 1;
+	}
+    }
+
+    // axis-angle, against the quaternion builder
+    rotateAxisMats(axes.data(), degrees.data(), count, m3.data(), sincos_precise, true);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	if(!rotation_near(m3[i], rotateAxisQuat(axes[i], degrees[i]).to_mat3(), 1e-5f + std::abs(degrees[i]) * 4e-9f))
+	    return 1;
+    }
+
+    // generic version
+    std::vector<double> degreesd(degrees.begin(), degrees.end());
+    std::vector<mat3<double>> m3d(count);
+    rotateAxisMats(rotation_z, degreesd.data(), count, m3d.data());
+    for(std::size_t i = 0; i < count; i++)
+    {
+	if(std::abs(m3d[i][0][1] - std::sin(degreesd[i] * 3.14159265358979323846 / 180)) > 1e-12)
+	    return 1;
+    }
+    return 0;
+}
+
+int rotation_test(const std::size_t count = 40003)
+{
+    // sincos up to its documented range(odd i), the builders keep small degrees
+    std::vector<float> radians(count), degrees(count), wideDegrees(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	radians[i] = i % 2 == 0 ? (float)(rand() % 2000000 - 1000000) / 1000.0f : (float)(rand() % 1999999 - 999999) / 10.0f;
+	degrees[i] = (float)(rand() % 2000000 - 1000000) / 100.0f;
+	wideDegrees[i] = i % 2 == 0 ? degrees[i] : (float)(rand() % 19999999 - 9999999);
+    }
+
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	if(rotation_sincos_test(radians, wideDegrees) != 0 || rotation_builders_test(degrees) != 0)
+	{
+	    std::cout << "rotation_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
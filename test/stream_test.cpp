@@ -0,0 +1,95 @@
+#include "../src/stream.h"
+#include "../src/cpu.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+static int stream_level_test(const unsigned int count)
+{
+    std::vector<vec3f> a(count), b(count);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	a[i] = vec3f(rand() % 100 + 1, rand() % 100 - 50, rand() % 100);
+	b[i] = vec3f(rand() % 100 - 50, rand() % 100 + 1, rand() % 100);
+    }
+
+    const vec3f_stream sa(a), sb(b);
+    vec3f_stream ret;
+
+    add(sa, sb, ret);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(ret[i].x != a[i].x + b[i].x || ret[i].z != a[i].z + b[i].z)
+	    return 1;
+    }
+
+    cross(sa, sb, ret);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	const vec3f& l = a[i];
+	const vec3f& r = b[i];
+	if(ret[i].y != l.z * r.x - l.x * r.z)
+	    return 1;
+    }
+
+    std::vector<float> d(count);
+    dot(sa, sb, d.data());
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(Float(d[i]) != dot(a[i], b[i]))
+	    return 1;
+    }
+
+    const vec3f p(7, -3, 20);
+    sqDistance(sa, p, d.data());
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(Float(d[i]) != a[i].sqDistance(p))
+	    return 1;
+    }
+
+    normalize(sa, ret);
+    const std::vector<vec3f> n = ret;
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(std::abs(n[i].magnitude() - 1.0f) > 1e-5f)
+	    return 1;
+    }
+
+    vec3f lower = a[0], upper = a[0];
+    for(unsigned int i = 1; i < count; i++)
+    {
+	for(std::uint8_t c = 0; c < 3; c++)
+	{
+	    lower[c] = std::min(lower[c], a[i][c]);
+	    upper[c] = std::max(upper[c], a[i][c]);
+	}
+    }
+    const vec3f sLower = reduceMin(sa);
+    const vec3f sUpper = reduceMax(sa);
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	if(sLower[c] != lower[c] || sUpper[c] != upper[c])
+	    return 1;
+    }
+
+    return 0;
+}
+
+// every kernel level the cpu can run must give the same results
+int stream_test(const unsigned int count = 1003)
+{
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	if(stream_level_test(count) != 0)
+	{
+	    std::cout << "stream_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
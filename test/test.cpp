@@ -2,6 +2,16 @@
 #include "sptree_test.cpp"
 #include "type_test.cpp"
 #include "matrix_test.cpp"
+#include "stream_test.cpp"
+#include "quantize_test.cpp"
+#include "transform_test.cpp"
+#include "matrix_stream_test.cpp"
+#include "eigen_map_test.cpp"
+#include "rotation_test.cpp"
+#include "aabb_pack_test.cpp"
+#include "boundingbox_test.cpp"
+#include "quat_test.cpp"
+#include "hierarchy_test.cpp"
 
 #define test(testfunc, ...)					\
     if(testfunc(__VA_ARGS__) == 0)				\
@@ -14,6 +24,16 @@ int main(int argc, char** argv)
     test(type_test);
     test(sptree_test);
     test(matrix_test);
+    test(stream_test);
+    test(quantize_test);
+    test(transform_test);
+    test(matrix_stream_test);
+    test(eigen_map_test);
+    test(rotation_test);
+    test(aabb_pack_test);
+    test(boundingbox_test);
+    test(quat_test);
+    test(hierarchy_test);
     
     return 0;
 }
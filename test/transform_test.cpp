@@ -0,0 +1,109 @@
+#include "../src/transform.h"
+#include "../src/cpu.h"
+#include <iostream>
+
+using namespace gb::physics;
+
+static bool transform_near(const vec3f& a, const vec3<double>& b)
+{
+    for(std::uint8_t c = 0; c < 3; c++)
+    {
+	if(std::abs(a[c] - b[c]) > 1e-3 * (1.0 + std::abs(b[c])))
+	    return false;
+    }
+    return true;
+}
+
+static int transform_level_test(const mat4f& m, const mat4<double>& md, const std::vector<vec3f>& in, const std::vector<vec3<double>>& ind)
+{
+    const std::size_t count = in.size();
+    std::vector<vec3f> out(count);
+    std::vector<vec3<double>> ref(count);
+    const vec3f_stream sin(in);
+    vec3f_stream sout;
+
+    for(std::uint8_t mode = 0; mode < 3; mode++)
+    {
+	for(std::uint8_t p = 0; p < 2; p++)
+	{
+	    const bool bParallel = p != 0;
+	    if(mode == transform_point)
+	    {
+		transformPoints(md, ind.data(), count, ref.data());
+		transformPoints(m, in.data(), count, out.data(), bParallel);
+		transformPoints(m, sin, sout, bParallel);
+	    }
+	    else if(mode == transform_direction)
+	    {
+		transformDirections(md, ind.data(), count, ref.data());
+		transformDirections(m, in.data(), count, out.data(), bParallel);
+		transformDirections(m, sin, sout, bParallel);
+	    }
+	    else
+	    {
+		transformPointsProjective(md, ind.data(), count, ref.data());
+		transformPointsProjective(m, in.data(), count, out.data(), bParallel);
+		transformPointsProjective(m, sin, sout, bParallel);
+	    }
+
+	    for(std::size_t i = 0; i < count; i++)
+	    {
+		if(!transform_near(out[i], ref[i]) || !transform_near(sout[i], ref[i]))
+		    return 1;
+	    }
+	}
+    }
+
+    // against the vec4 path, and in place
+    std::vector<vec3f> inPlace = in;
+    transformPoints(m, inPlace.data(), count, inPlace.data());
+    for(std::size_t i = 0; i < count; i++)
+    {
+	const vec4<double> r = md * vec4<double>(ind[i].x, ind[i].y, ind[i].z, 1.0);
+	if(!transform_near(inPlace[i], vec3<double>(r.x, r.y, r.z)))
+	    return 1;
+    }
+
+    return 0;
+}
+
+int transform_test(const std::size_t count = 70003)
+{
+    mat4f m;
+    mat4<double> md;
+    for(std::uint8_t c = 0; c < 4; c++)
+    {
+	for(std::uint8_t r = 0; r < 4; r++)
+	{
+	    m[c][r] = (float)(rand() % 200 - 100) / 50.0f;
+	    md[c][r] = m[c][r];
+	}
+    }
+    // keep w away from 0 for the projective path
+    m[0][3] = m[1][3] = m[2][3] = 0.01f;
+    m[3][3] = 2.0f;
+    md[0][3] = md[1][3] = md[2][3] = m[0][3];
+    md[3][3] = m[3][3];
+
+    std::vector<vec3f> in(count);
+    std::vector<vec3<double>> ind(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+	in[i] = vec3f(rand() % 100 - 50, rand() % 100 - 50, rand() % 100 - 50);
+	ind[i] = vec3<double>(in[i].x, in[i].y, in[i].z);
+    }
+
+    const simd_level detected = detectedSimdLevel();
+    for(std::uint8_t l = 0; l <= (std::uint8_t)detected; l++)
+    {
+	forceSimdLevel((simd_level)l);
+	if(transform_level_test(m, md, in, ind) != 0)
+	{
+	    std::cout << "transform_test failed at " << simdLevelName((simd_level)l) << std::endl;
+	    resetSimdLevel();
+	    return 1;
+	}
+    }
+    resetSimdLevel();
+    return 0;
+}
@@ -1,8 +1,48 @@
 #include "../src/type.h"
+#include "../src/roaring.h"
 #include <iostream>
+#include <cstdio>
 
 using namespace gb::physics;
 
+// a mapped array must realloc to the same elements as a heap one
+template<typename Layout>
+static bool _mapped_realloc_test(const char* path)
+{
+    array_2d<std::uint32_t, Layout> heap(13, 21);
+    array_2d<std::uint32_t, Layout> mapped;
+    if(!mapped.create_mapped(path, 13, 21))
+	return false;
+    for(std::uint32_t i = 0; i < 13; i++)
+    {
+	for(std::uint32_t j = 0; j < 21; j++)
+	    heap(i, j) = mapped(i, j) = i * 100 + j + 1;
+    }
+    const std::uint32_t shapes[][2] = {{13, 40}, {30, 40}, {30, 9}, {5, 9}, {5, 33}, {40, 3}, {0, 0}, {7, 7}};
+    for(const auto& shape : shapes)
+    {
+	heap.realloc(shape[0], shape[1]);
+	if(!mapped.realloc(shape[0], shape[1]) || mapped.height != shape[0] || mapped.width != shape[1])
+	    return false;
+	for(std::uint32_t i = 0; i < shape[0]; i++)
+	{
+	    for(std::uint32_t j = 0; j < shape[1]; j++)
+	    {
+		if(mapped(i, j) != heap(i, j))
+		    return false;
+	    }
+	}
+	for(std::uint32_t i = 0; i < shape[0]; i++)
+	    mapped(i, 0) = heap(i, 0) = i + 7;
+    }
+    mapped.flush();
+    array_2d<std::uint32_t, Layout> reopened;
+    const bool ret = reopened.open_mapped(path, true) && reopened.height == 7 && reopened(6, 0) == 13;
+    reopened = array_2d<std::uint32_t, Layout>();
+    mapped = array_2d<std::uint32_t, Layout>();
+    std::remove(path);
+    return ret;
+}
 
 int type_test(const unsigned int count = 1000)
 {
@@ -49,9 +89,162 @@ int type_test(const unsigned int count = 1000)
 	if(bitVec[i] != bitArray[i])
 	    return 1;
     }
-    std::cout << std::endl;
+
+    // rank/select/find_next
+    std::size_t ones = 0;
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(bitVec.rank(i) != ones)
+	    return 1;
+	if(bitArray[i] != 0)
+	{
+	    if(bitVec.select(ones) != i)
+		return 1;
+	    ones++;
+	}
+    }
+    if(bitVec.count() != ones)
+	return 1;
+
+    bitVec.build_rank_index(2);
+    std::size_t next = bitVec.find_next(0);
+    for(std::size_t k = 0; k < ones; k++)
+    {
+	if(next != bitVec.select(k) || bitVec.rank(next) != k)
+	    return 1;
+	next = bitVec.find_next(next + 1);
+    }
+    if(next != bit_vector::npos)
+	return 1;
+
+    // bulk ops
+    bit_vector inverse;
+    inverse.insert(0, count, 1);
+    inverse.and_not(bitVec);
+    if((inverse & bitVec).count() != 0 || (inverse | bitVec).count() != count || (inverse ^ bitVec).count() != count)
+	return 1;
+
+    // compressed
+    roaring_bit_vector roaring(bitVec);
+    for(unsigned int i = 0; i < count; i++)
+    {
+	if(roaring[i] != bitArray[i])
+	    return 1;
+    }
+    std::size_t runBits = 0;
+    roaring.for_each_run([&runBits](const std::size_t, const std::size_t size)
+			 {
+			     runBits += size;
+			 });
+    if(runBits != ones || roaring.count() != ones)
+	return 1;
+
+    // incremental inserts: single bits and short ranges, sparse in chunk 0, dense enough in chunk 1
+    // to outgrow the array container, against a plain bit_vector
+    roaring_bit_vector incremental;
+    bit_vector reference;
+    for(unsigned int i = 0; i < 20000; i++)
+    {
+	const std::size_t chunk = i % 2;
+	const std::size_t pos = chunk * roaring_bit_vector::chunk_bits + rand() % (chunk == 0 ? 60000 : 9000);
+	const std::size_t size = i % 5 == 0 ? 1 + rand() % 40 : 1;
+	const std::uint8_t val = i % 7 == 0 ? 0 : 1;
+	incremental.insert(pos, size, val);
+	reference.insert(pos, size, val);
+    }
+    if(incremental.count() != reference.count() || incremental.size() != reference.size())
+	return 1;
+    for(std::size_t i = 0; i < reference.size(); i++)
+    {
+	if(incremental[i] != reference[i])
+	    return 1;
+    }
 
     delete[] bitArray;
 
+    // array_2d layouts, every layout must hold the same values
+    array_2d<std::uint32_t> rm(13, 21);
+    array_2d<std::uint32_t, layout_pitched<>> pitched(13, 21);
+    array_2d<std::uint32_t, layout_tiled<8>> tiled(13, 21);
+    array_2d<std::uint32_t, layout_morton> morton(13, 21);
+    for(std::uint32_t i = 0; i < 13; i++)
+    {
+	for(std::uint32_t j = 0; j < 21; j++)
+	{
+	    rm[i][j] = i * 100 + j;
+	    pitched(i, j) = tiled(i, j) = morton(i, j) = i * 100 + j;
+	}
+    }
+    if(pitched.layout().pitch() * sizeof(std::uint32_t) % GB_PHYSICS_SIMD_ALIGNMENT != 0)
+	return 1;
+    for(std::uint32_t i = 0; i < 13; i++)
+    {
+	for(std::uint32_t j = 0; j < 21; j++)
+	{
+	    if(pitched(i, j) != rm(i, j) || tiled(i, j) != rm(i, j) || morton(i, j) != rm(i, j))
+		return 1;
+	}
+    }
+    // subregion view and insert across layouts
+    array_2d<std::uint32_t>::view_type sub = rm.view(2, 3, 5, 4);
+    if(sub(0, 0) != 203 || sub.view(1, 1, 2, 2)(1, 1) != 405 || sub.row_at(4)[3] != 606)
+	return 1;
+    tiled.insert({{0, 0}}, sub);
+    pitched.insert({{10, 1}}, tiled.view(0, 0, 5, 4));
+    if(tiled(4, 3) != 606 || pitched(5, 13) != 606)
+	return 1;
+    tiled.realloc(6, 30);
+    if(tiled(4, 3) != 606 || tiled(5, 20) != 520 || tiled(5, 25) != 0)
+	return 1;
+
+    // file backed storage
+    {
+	const char* path = "type_test_mapped.bin";
+	{
+	    array_2d<std::uint32_t, layout_tiled<8>> mappedArr;
+	    if(!mappedArr.create_mapped(path, 13, 21))
+		return 1;
+	    mappedArr.insert({{0, 0}}, rm);
+	    if(!mappedArr.realloc(20, 21))
+		return 1;
+	    mappedArr.flush();
+	    array_2d<std::uint32_t, layout_tiled<8>> reopened;
+	    if(!reopened.open_mapped(path, true) || reopened.height != 20 || reopened(12, 20) != 1220 || reopened(19, 0) != 0)
+		return 1;
+	    // a read only map can't be resized and stays as it was
+	    if(reopened.realloc(40, 21) || reopened.height != 20 || reopened(12, 20) != 1220)
+		return 1;
+	}
+
+	if(!_mapped_realloc_test<layout_row_major>(path) || !_mapped_realloc_test<layout_pitched<>>(path)
+	   || !_mapped_realloc_test<layout_tiled<4>>(path) || !_mapped_realloc_test<layout_morton>(path))
+	    return 1;
+
+	bit_vector mappedBits;
+	if(!mappedBits.create_mapped(path, 100))
+	    return 1;
+	mappedBits.insert(10, 5, 1);
+	mappedBits.insert(1000, 1, 1);//grows the file
+	mappedBits.clear();
+	if(!mappedBits.open_mapped(path) || mappedBits.size() != 1001 || mappedBits.count() != 6 || !mappedBits.test(1000))
+	    return 1;
+	mappedBits.clear();
+	if(!mappedBits.open_mapped(path, true) || mappedBits.insert(5000, 1, 1)
+	   || mappedBits.capacity() != 1024 || mappedBits.count() != 6)
+	    return 1;
+	mappedBits.clear();
+	std::remove(path);
+    }
+
+    // vec expression test
+    const vec3f a(1, 2, 3), b(4, 5, 6);
+    const vec3f r = a + b * 2 - a / 2;
+    if(r.x != 8.5f || r.y != 11.0f || r.z != 13.5f)
+	return 1;
+    if(dot(a, b) != 32 || cross(a, b).y != 6)
+	return 1;
+    if(!(a < b) || (a - b).abs().eval().x != 3)
+	return 1;
+
     return 0;
 }    